@@ -0,0 +1,63 @@
+# benchmark suite (nomacsBenchmark)
+# run: nomacsBenchmark -platform offscreen -o results.json
+# or:  make benchmark (writes benchmark.json to the build directory)
+# the synchronization benchmark: make benchmark_sync (writes benchmark_sync.json)
+
+if(NOT Qt5_FOUND)
+	message(WARNING "the benchmark suite needs Qt5 - ${CMAKE_PROJECT_NAME}Benchmark is not built")
+	return()
+endif()
+
+set(BENCHMARK_NAME ${CMAKE_PROJECT_NAME}Benchmark)
+
+file(GLOB BENCHMARK_SOURCES "src/DkBenchmark/*.cpp")
+file(GLOB BENCHMARK_HEADERS "src/DkBenchmark/*.h")
+
+# the benchmarks are independent of the GUI
+if(MSVC)
+	set(BENCHMARK_LIBS ${LIB_CORE_NAME} ${LIB_LOADER_NAME})
+else()
+	set(BENCHMARK_LIBS ${DLL_CORE_NAME} ${DLL_LOADER_NAME})
+endif()
+set(BENCHMARK_DEPENDENCIES ${DLL_LOADER_NAME} ${DLL_CORE_NAME})
+
+add_executable(${BENCHMARK_NAME} ${BENCHMARK_SOURCES} ${BENCHMARK_HEADERS})
+target_link_libraries(${BENCHMARK_NAME} ${BENCHMARK_LIBS} ${EXIV2_LIBRARIES} ${LIBRAW_LIBRARIES} ${OpenCV_LIBS} ${TIFF_LIBRARIES} ${QUAZIP_LIBRARIES} ${QUAZIP_DEPENDENCY})
+target_include_directories(${BENCHMARK_NAME} PRIVATE ${CMAKE_SOURCE_DIR}/src/DkBenchmark ${OpenCV_INCLUDE_DIRS} ${ZLIB_INCLUDE_DIRS})
+set_target_properties(${BENCHMARK_NAME} PROPERTIES COMPILE_FLAGS "-DDK_DLL_IMPORT -DNOMINMAX")
+add_dependencies(${BENCHMARK_NAME} ${BENCHMARK_DEPENDENCIES})
+
+qt5_use_modules(${BENCHMARK_NAME} Widgets Gui Network Concurrent Svg)
+
+add_custom_target(benchmark 
+	COMMAND ${BENCHMARK_NAME} -platform offscreen -o ${CMAKE_BINARY_DIR}/benchmark.json
+	DEPENDS ${BENCHMARK_NAME}
+	COMMENT "running the nomacs benchmarks")
+
+# synchronization benchmark (nomacsSyncBenchmark)
+# measures messages/s and latency of two DkLocalConnections - it needs the GUI library (DkConnection)
+set(SYNC_BENCHMARK_NAME ${CMAKE_PROJECT_NAME}SyncBenchmark)
+
+file(GLOB SYNC_BENCHMARK_SOURCES "src/DkSyncBenchmark/*.cpp")
+file(GLOB SYNC_BENCHMARK_HEADERS "src/DkSyncBenchmark/*.h")
+
+if(MSVC)
+	set(SYNC_BENCHMARK_LIBS ${LIB_NAME} ${LIB_CORE_NAME} ${LIB_LOADER_NAME})
+	set(SYNC_BENCHMARK_DEPENDENCIES ${DLL_GUI_NAME} ${DLL_LOADER_NAME} ${DLL_CORE_NAME})
+else()
+	set(SYNC_BENCHMARK_LIBS ${DLL_NAME} ${DLL_CORE_NAME} ${DLL_LOADER_NAME})
+	set(SYNC_BENCHMARK_DEPENDENCIES ${DLL_NAME} ${DLL_LOADER_NAME} ${DLL_CORE_NAME})
+endif()
+
+add_executable(${SYNC_BENCHMARK_NAME} ${SYNC_BENCHMARK_SOURCES} ${SYNC_BENCHMARK_HEADERS})
+target_link_libraries(${SYNC_BENCHMARK_NAME} ${SYNC_BENCHMARK_LIBS} ${EXIV2_LIBRARIES} ${LIBRAW_LIBRARIES} ${OpenCV_LIBS} ${TIFF_LIBRARIES} ${QUAZIP_LIBRARIES} ${QUAZIP_DEPENDENCY})
+target_include_directories(${SYNC_BENCHMARK_NAME} PRIVATE ${CMAKE_SOURCE_DIR}/src/DkSyncBenchmark ${OpenCV_INCLUDE_DIRS} ${ZLIB_INCLUDE_DIRS})
+set_target_properties(${SYNC_BENCHMARK_NAME} PROPERTIES COMPILE_FLAGS "-DDK_DLL_IMPORT -DNOMINMAX")
+add_dependencies(${SYNC_BENCHMARK_NAME} ${SYNC_BENCHMARK_DEPENDENCIES})
+
+qt5_use_modules(${SYNC_BENCHMARK_NAME} Widgets Gui Network Concurrent Svg)
+
+add_custom_target(benchmark_sync
+	COMMAND ${SYNC_BENCHMARK_NAME} -platform offscreen -o ${CMAKE_BINARY_DIR}/benchmark_sync.json
+	DEPENDS ${SYNC_BENCHMARK_NAME}
+	COMMENT "running the nomacs synchronization benchmark")
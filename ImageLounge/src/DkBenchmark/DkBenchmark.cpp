@@ -0,0 +1,852 @@
+/*******************************************************************************************************
+ DkBenchmark.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkBenchmark.h"
+#include "DkImageLoader.h"
+#include "DkImageStorage.h"
+#include "DkBasicLoader.h"
+#include "DkMetaData.h"
+#include "DkThumbs.h"
+#include "DkProcess.h"
+#include "DkSettings.h"
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QBuffer>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QImageWriter>
+#include <QThread>
+#include <QTimer>
+#include <QSysInfo>
+#include <QEventLoop>
+#include <QDebug>
+
+#ifdef WITH_QUAZIP
+#include <quazip/JlCompress.h>
+#endif
+
+#ifdef WITH_LIBTIFF
+#ifdef WIN32
+#include "tif_config.h"
+#endif
+
+// see DkBasicLoader.cpp
+#define uint64 uint64_hack_
+#define int64 int64_hack_
+
+#include "tiffio.h"
+
+#undef uint64
+#undef int64
+#endif
+#pragma warning(pop)		// no warnings from includes - end
+
+#include <algorithm>
+#include <iostream>
+
+namespace nmc {
+
+/**
+ * Exposes the folder functions of DkImageLoader.
+ **/
+class DkBenchmarkLoader : public DkImageLoader {
+
+public:
+	using DkImageLoader::createImages;
+	using DkImageLoader::sortImages;
+};
+
+/**
+ * Computes the image pyramid synchronously.
+ **/
+class DkBenchmarkStorage : public DkImageStorage {
+
+public:
+	void compute(const QImage& img) {
+		mImg = img;
+		mImgs.clear();
+		mStop = false;
+		computeImage();
+	};
+
+	int numLevels() const {
+		return mImgs.size();
+	};
+};
+
+// DkBenchmarkResult --------------------------------------------------------------------
+DkBenchmarkResult::DkBenchmarkResult(const QString& group, const QString& name, const QString& dataset, int numItems) {
+
+	this->group = group;
+	this->name = name;
+	this->dataset = dataset;
+	this->numItems = numItems;
+}
+
+void DkBenchmarkResult::addRun(double ms) {
+
+	mRuns << ms;
+}
+
+bool DkBenchmarkResult::isEmpty() const {
+
+	return mRuns.isEmpty();
+}
+
+double DkBenchmarkResult::minMs() const {
+
+	if (mRuns.isEmpty())
+		return 0.0;
+
+	return *std::min_element(mRuns.begin(), mRuns.end());
+}
+
+double DkBenchmarkResult::medianMs() const {
+
+	if (mRuns.isEmpty())
+		return 0.0;
+
+	QVector<double> runs = mRuns;
+	std::sort(runs.begin(), runs.end());
+
+	int mid = runs.size()/2;
+	return (runs.size() % 2) ? runs[mid] : (runs[mid-1] + runs[mid]) * 0.5;
+}
+
+double DkBenchmarkResult::meanMs() const {
+
+	if (mRuns.isEmpty())
+		return 0.0;
+
+	double sum = 0.0;
+	for (double r : mRuns)
+		sum += r;
+
+	return sum / mRuns.size();
+}
+
+QJsonObject DkBenchmarkResult::toJson() const {
+
+	QJsonObject o;
+	o["group"] = group;
+	o["name"] = name;
+	o["dataset"] = dataset;
+	o["items"] = numItems;
+
+	QJsonArray runs;
+	for (double r : mRuns)
+		runs.append(r);
+	o["runs_ms"] = runs;
+
+	double median = medianMs();
+	o["min_ms"] = minMs();
+	o["median_ms"] = median;
+	o["mean_ms"] = meanMs();
+
+	if (median > 0) {
+		o["items_per_s"] = numItems / median * 1000.0;
+
+		if (bytes > 0)
+			o["mb_per_s"] = bytes / (1024.0*1024.0) / median * 1000.0;
+	}
+
+	if (bytes > 0)
+		o["bytes"] = (double)bytes;
+
+	for (QJsonObject::const_iterator it = extra.constBegin(); it != extra.constEnd(); it++)
+		o[it.key()] = it.value();
+
+	return o;
+}
+
+// DkBenchmarkData --------------------------------------------------------------------
+DkBenchmarkData::DkBenchmarkData(const QString& workDir, const QSize& largeSize) {
+
+	mWorkDir = workDir;
+	mLargeSize = largeSize;
+
+	QDir().mkpath(mWorkDir);
+}
+
+QString DkBenchmarkData::workDir() const {
+
+	return mWorkDir;
+}
+
+/**
+ * Creates an image with gradients and structured noise.
+ * The noise keeps the encoders busy (a plain gradient compresses too well).
+ * @param size the image size
+ * @return QImage a deterministic RGB32 image
+ **/
+QImage DkBenchmarkData::syntheticImage(const QSize& size) {
+
+	QImage img(size, QImage::Format_RGB32);
+	quint32 seed = 42;
+
+	for (int y = 0; y < img.height(); y++) {
+
+		QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
+
+		for (int x = 0; x < img.width(); x++) {
+
+			seed = seed * 1664525u + 1013904223u;	// LCG - we need the same pixels on every platform
+			int n = (seed >> 24) & 0x1f;
+
+			int r = (x * 255 / qMax(img.width()-1, 1) + n) & 0xff;
+			int g = (y * 255 / qMax(img.height()-1, 1) + n) & 0xff;
+			int b = (((x / 64 + y / 64) % 2) ? 200 : 55) + n;
+
+			line[x] = qRgb(r, g, qMin(b, 255));
+		}
+	}
+
+	return img;
+}
+
+QByteArray DkBenchmarkData::encode(const QImage& img, const char* format, int quality) const {
+
+	QByteArray ba;
+	QBuffer buffer(&ba);
+	buffer.open(QIODevice::WriteOnly);
+
+	QImageWriter writer(&buffer, format);
+	writer.setQuality(quality);
+
+	if (!writer.write(img))
+		qWarning() << "[DkBenchmarkData] cannot encode" << format << writer.errorString();
+
+	return ba;
+}
+
+/**
+ * Returns a directory with numFiles copies of fileData.
+ * The directory is only written if it does not exist or has a different number of files.
+ **/
+QString DkBenchmarkData::filledDir(const QString& name, int numFiles, const QByteArray& fileData, const QString& suffix) const {
+
+	QString dirPath = QDir(mWorkDir).absoluteFilePath(QString("%1-%2").arg(name).arg(numFiles));
+	QDir dir(dirPath);
+
+	if (dir.exists() && dir.entryList(QDir::Files).size() == numFiles)
+		return dirPath;
+
+	dir.removeRecursively();
+	QDir().mkpath(dirPath);
+
+	for (int idx = 0; idx < numFiles; idx++) {
+
+		QFile file(dir.absoluteFilePath(QString("img-%1.%2").arg(idx, 6, 10, QChar('0')).arg(suffix)));
+
+		if (!file.open(QIODevice::WriteOnly) || file.write(fileData) != fileData.size()) {
+			qWarning() << "[DkBenchmarkData] cannot write" << file.fileName();
+			break;
+		}
+	}
+
+	return dirPath;
+}
+
+/**
+ * Returns a folder of small (160 x 120) JPGs.
+ * @param numFiles the number of files in the folder
+ * @return QString the folder path
+ **/
+QString DkBenchmarkData::smallFilesDir(int numFiles) const {
+
+	QByteArray ba = encode(syntheticImage(QSize(160, 120)), "jpg", 90);
+	return filledDir("small", numFiles, ba, "jpg");
+}
+
+/**
+ * Returns JPGs (1920 x 1280) with Exif orientation, rating and thumbnail.
+ * @param numFiles the number of files in the folder
+ * @return QString the folder path
+ **/
+QString DkBenchmarkData::exifFilesDir(int numFiles) const {
+
+	QString srcPath = QDir(mWorkDir).absoluteFilePath("exif-source.jpg");
+
+	if (!QFileInfo(srcPath).exists()) {
+
+		QImage img = syntheticImage(QSize(1920, 1280));
+		img.save(srcPath, "jpg", 90);
+
+		DkMetaDataT metaData;
+		metaData.readMetaData(srcPath);
+		metaData.setThumbnail(img.scaled(QSize(160, 160), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+		metaData.setOrientation(90);
+		metaData.setRating(3);
+
+		if (!metaData.saveMetaData(srcPath))
+			qWarning() << "[DkBenchmarkData] cannot write Exif data to" << srcPath;
+	}
+
+	QFile file(srcPath);
+	file.open(QIODevice::ReadOnly);
+
+	return filledDir("exif", numFiles, file.readAll(), "jpg");
+}
+
+/**
+ * Returns a large image of the given format.
+ * @param format the file format (jpg, png, tif)
+ * @return QString the file path
+ **/
+QString DkBenchmarkData::largeImage(const QString& format) const {
+
+	QString filePath = QDir(mWorkDir).absoluteFilePath(QString("large-%1x%2.%3").arg(mLargeSize.width()).arg(mLargeSize.height()).arg(format));
+
+	if (!QFileInfo(filePath).exists()) {
+
+		QByteArray ba = encode(syntheticImage(mLargeSize), format.toLatin1().constData(), format == "jpg" ? 90 : -1);
+
+		QFile file(filePath);
+		if (ba.isEmpty() || !file.open(QIODevice::WriteOnly) || file.write(ba) != ba.size()) {
+			qWarning() << "[DkBenchmarkData] cannot create" << filePath;
+			return QString();
+		}
+	}
+
+	return filePath;
+}
+
+/**
+ * Returns a multi-page TIFF (1024 x 768 per page).
+ * @param numPages the number of pages
+ * @return QString the file path or an empty string if nomacs is built without libtiff
+ **/
+QString DkBenchmarkData::multiPageTiff(int numPages) const {
+
+#ifdef WITH_LIBTIFF
+	QString filePath = QDir(mWorkDir).absoluteFilePath(QString("multipage-%1.tif").arg(numPages));
+
+	if (QFileInfo(filePath).exists())
+		return filePath;
+
+	TIFF* tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "w");
+
+	if (!tiff) {
+		qWarning() << "[DkBenchmarkData] cannot create" << filePath;
+		return QString();
+	}
+
+	QImage img = syntheticImage(QSize(1024, 768)).convertToFormat(QImage::Format_RGB888);
+
+	for (int pIdx = 0; pIdx < numPages; pIdx++) {
+
+		TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, FILETYPE_PAGE);
+		TIFFSetField(tiff, TIFFTAG_PAGENUMBER, pIdx, numPages);
+		TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, img.width());
+		TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, img.height());
+		TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+		TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+		TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+		TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+		TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+		TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(tiff, 0));
+
+		for (int rIdx = 0; rIdx < img.height(); rIdx++)
+			TIFFWriteScanline(tiff, img.scanLine(rIdx), rIdx, 0);
+
+		TIFFWriteDirectory(tiff);
+	}
+
+	TIFFClose(tiff);
+
+	return filePath;
+#else
+	Q_UNUSED(numPages);
+	return QString();
+#endif
+}
+
+/**
+ * Returns a zip archive with numFiles small JPGs.
+ * @param numFiles the number of images in the archive
+ * @return QString the file path or an empty string if nomacs is built without QuaZip
+ **/
+QString DkBenchmarkData::zipArchive(int numFiles) const {
+
+#ifdef WITH_QUAZIP
+	QString filePath = QDir(mWorkDir).absoluteFilePath(QString("archive-%1.zip").arg(numFiles));
+
+	if (!QFileInfo(filePath).exists() && !JlCompress::compressDir(filePath, smallFilesDir(numFiles))) {
+		qWarning() << "[DkBenchmarkData] cannot create" << filePath;
+		return QString();
+	}
+
+	return filePath;
+#else
+	Q_UNUSED(numFiles);
+	return QString();
+#endif
+}
+
+QStringList DkBenchmarkData::files(const QString& dirPath) const {
+
+	QStringList filePaths;
+	QDir dir(dirPath);
+
+	for (const QString& fileName : dir.entryList(QDir::Files, QDir::Name))
+		filePaths << dir.absoluteFilePath(fileName);
+
+	return filePaths;
+}
+
+// DkBenchmark --------------------------------------------------------------------
+DkBenchmark::DkBenchmark(const QString& workDir, int numRuns, bool quick) :
+	mData(workDir, quick ? QSize(2000, 1500) : QSize(6000, 4000)) {
+
+	mNumRuns = qMax(numRuns, 1);
+	mQuick = quick;
+}
+
+QStringList DkBenchmark::groups() {
+
+	return QStringList() << "folder" << "decode" << "exif" << "processing" << "pyramid" << "thumbs" << "batch";
+}
+
+/**
+ * Runs the benchmarks.
+ * @param groups the groups to run (all if empty)
+ **/
+void DkBenchmark::run(const QStringList& groups) {
+
+	QStringList g = groups.isEmpty() ? DkBenchmark::groups() : groups;
+
+	if (g.contains("folder"))
+		benchFolder();
+	if (g.contains("decode"))
+		benchDecode();
+	if (g.contains("exif"))
+		benchExif();
+	if (g.contains("processing"))
+		benchProcessing();
+	if (g.contains("pyramid"))
+		benchPyramid();
+	if (g.contains("thumbs"))
+		benchThumbs();
+	if (g.contains("batch"))
+		benchBatch();
+}
+
+/**
+ * Times func mNumRuns times (after an untimed warm-up run).
+ * @param prepare is called before each run and not timed
+ * @return DkBenchmarkResult the timings
+ **/
+DkBenchmarkResult DkBenchmark::measure(const QString& group, const QString& name, const QString& dataset, int numItems, std::function<void()> func, std::function<void()> prepare) {
+
+	DkBenchmarkResult result(group, name, dataset, numItems);
+	QElapsedTimer timer;
+
+	for (int idx = -1; idx < mNumRuns; idx++) {
+
+		if (prepare)
+			prepare();
+
+		timer.start();
+		func();
+		double ms = timer.nsecsElapsed() / 1e6;
+
+		if (idx >= 0)
+			result.addRun(ms);
+	}
+
+	return result;
+}
+
+void DkBenchmark::addResult(const DkBenchmarkResult& result) {
+
+	if (result.isEmpty())
+		return;
+
+	mResults << result;
+
+	std::cerr << qPrintable(QString("%1 / %2 (%3): %4 ms")
+		.arg(result.group, -10)
+		.arg(result.name)
+		.arg(result.dataset)
+		.arg(result.medianMs(), 0, 'f', 2)) << std::endl;
+}
+
+void DkBenchmark::benchFolder() {
+
+	QVector<int> sizes;
+	sizes << 1000;
+	if (!mQuick)
+		sizes << 10000 << 100000;
+
+	DkBenchmarkLoader loader;
+	int sortMode = Settings::param().global().sortMode;
+
+	for (int numFiles : sizes) {
+
+		QString dirPath = mData.smallFilesDir(numFiles);
+		QString dataset = QString("%1 files").arg(numFiles);
+		QFileInfoList files;
+
+		addResult(measure("folder", "getFilteredFileInfoList", dataset, numFiles, [&]() {
+			files = loader.getFilteredFileInfoList(dirPath);
+		}));
+
+		addResult(measure("folder", "createImages", dataset, numFiles, [&]() {
+			loader.createImages(files, false);
+		}, [&]() {
+			loader.setImages(QVector<QSharedPointer<DkImageContainerT> >());	// otherwise the containers are reused
+		}));
+
+		QVector<QSharedPointer<DkImageContainerT> > images = loader.getImages();
+
+		Settings::param().global().sortMode = DkSettings::sort_filename;
+		addResult(measure("folder", "sort by filename", dataset, numFiles, [&]() {
+			loader.sortImages(images);
+		}));
+
+		Settings::param().global().sortMode = DkSettings::sort_date_modified;
+		addResult(measure("folder", "sort by date modified", dataset, numFiles, [&]() {
+			loader.sortImages(images);
+		}));
+
+		Settings::param().global().sortMode = sortMode;
+		loader.setImages(QVector<QSharedPointer<DkImageContainerT> >());
+	}
+}
+
+void DkBenchmark::benchDecode() {
+
+	QStringList formats;
+	formats << "jpg" << "png" << "tif";
+
+	for (const QString& format : formats) {
+
+		QString filePath = mData.largeImage(format);
+
+		if (filePath.isEmpty())
+			continue;
+
+		QString dataset = QFileInfo(filePath).fileName();
+
+		DkBenchmarkResult r = measure("decode", QString("loadGeneral %1").arg(format), dataset, 1, [&]() {
+			DkBasicLoader loader;
+			loader.loadGeneral(filePath);
+		});
+		r.bytes = QFileInfo(filePath).size();
+		addResult(r);
+
+		if (format == "jpg") {
+			DkBenchmarkResult rf = measure("decode", "loadGeneral jpg fast", dataset, 1, [&]() {
+				DkBasicLoader loader;
+				loader.loadGeneral(filePath, false, true);
+			});
+			rf.bytes = r.bytes;
+			addResult(rf);
+		}
+	}
+
+	// multi-page TIFF
+	QString tiffPath = mData.multiPageTiff(10);
+
+	if (!tiffPath.isEmpty()) {
+
+		addResult(measure("decode", "multi-page tif (all pages)", QFileInfo(tiffPath).fileName(), 10, [&]() {
+			DkBasicLoader loader;
+			loader.loadGeneral(tiffPath);
+
+			for (int pIdx = 1; pIdx < loader.getNumPages(); pIdx++)
+				loader.loadPageAt(pIdx);
+		}));
+	}
+
+#ifdef WITH_QUAZIP
+	QString zipPath = mData.zipArchive(100);
+
+	if (!zipPath.isEmpty()) {
+
+		QStringList fileNames = JlCompress::getFileList(zipPath);
+
+		addResult(measure("decode", "zip archive", QFileInfo(zipPath).fileName(), fileNames.size(), [&]() {
+			for (const QString& fileName : fileNames) {
+				DkBasicLoader loader;
+				loader.loadGeneral(DkZipContainer::encodeZipFile(zipPath, fileName));
+			}
+		}));
+	}
+#endif
+
+	std::cerr << qPrintable(DkDecoderRegistry::instance().timingReport()) << std::endl;
+}
+
+void DkBenchmark::benchExif() {
+
+	int numFiles = mQuick ? 200 : 1000;
+	QStringList files = mData.files(mData.exifFilesDir(numFiles));
+	QString dataset = QString("%1 jpgs").arg(files.size());
+
+	addResult(measure("exif", "readMetaData (Exiv2)", dataset, files.size(), [&]() {
+		for (const QString& filePath : files) {
+			DkMetaDataT metaData;
+			metaData.readMetaData(filePath);
+			metaData.getOrientation();
+		}
+	}));
+
+	addResult(measure("exif", "probeMetaData", dataset, files.size(), [&]() {
+		for (const QString& filePath : files) {
+			DkMetaDataT metaData;
+			metaData.probeMetaData(filePath);
+			metaData.getOrientation();
+		}
+	}));
+
+	addResult(measure("exif", "readMetaData + thumbnail", dataset, files.size(), [&]() {
+		for (const QString& filePath : files) {
+			DkMetaDataT metaData;
+			metaData.readMetaData(filePath);
+			metaData.getThumbnail();
+		}
+	}));
+
+	addResult(measure("exif", "probeMetaData + thumbnail", dataset, files.size(), [&]() {
+		for (const QString& filePath : files) {
+			DkMetaDataT metaData;
+			metaData.probeMetaData(filePath);
+			metaData.getThumbnail();
+		}
+	}));
+}
+
+void DkBenchmark::benchProcessing() {
+
+	QImage img = DkBenchmarkData::syntheticImage(mQuick ? QSize(2000, 1500) : QSize(6000, 4000));
+	QImage tmp;
+	QString dataset = QString("%1x%2").arg(img.width()).arg(img.height());
+
+	addResult(measure("processing", "resizeImage 0.5 area", dataset, 1, [&]() {
+		DkImage::resizeImage(img, QSize(), 0.5f, DkImage::ipl_area, false);
+	}));
+
+	addResult(measure("processing", "resizeImage 0.5 cubic gamma", dataset, 1, [&]() {
+		DkImage::resizeImage(img, QSize(), 0.5f, DkImage::ipl_cubic, true);
+	}));
+
+	addResult(measure("processing", "resizeImage 0.1 area", dataset, 1, [&]() {
+		DkImage::resizeImage(img, QSize(), 0.1f, DkImage::ipl_area, false);
+	}));
+
+	addResult(measure("processing", "gammaToLinear", dataset, 1, [&]() {
+		DkImage::gammaToLinear(tmp);
+	}, [&]() {
+		tmp = img.copy();
+	}));
+
+	addResult(measure("processing", "linearToGamma", dataset, 1, [&]() {
+		DkImage::linearToGamma(tmp);
+	}, [&]() {
+		tmp = img.copy();
+	}));
+
+#ifdef WITH_OPENCV
+	addResult(measure("processing", "unsharpMask", dataset, 1, [&]() {
+		DkImage::unsharpMask(tmp);
+	}, [&]() {
+		tmp = img.copy();
+	}));
+#endif
+}
+
+void DkBenchmark::benchPyramid() {
+
+	QImage img = DkBenchmarkData::syntheticImage(mQuick ? QSize(4000, 4000) : QSize(8000, 6000));
+	DkBenchmarkStorage storage;
+
+	DkBenchmarkResult r = measure("pyramid", "computeImage", QString("%1x%2").arg(img.width()).arg(img.height()), 1, [&]() {
+		storage.compute(img);
+	});
+	r.extra["levels"] = storage.numLevels();
+	addResult(r);
+}
+
+void DkBenchmark::benchThumbs() {
+
+	int numFiles = mQuick ? 100 : 500;
+	QStringList exifFiles = mData.files(mData.exifFilesDir(numFiles));
+	QStringList smallFiles = mData.files(mData.smallFilesDir(1000)).mid(0, numFiles);
+
+	addResult(measure("thumbs", "exif thumbnails", QString("%1 jpgs").arg(exifFiles.size()), exifFiles.size(), [&]() {
+		for (const QString& filePath : exifFiles) {
+			DkThumbNail thumb(filePath);
+			thumb.compute(DkThumbNail::force_exif_thumb);
+		}
+	}));
+
+	addResult(measure("thumbs", "decoded thumbnails (1920x1280)", QString("%1 jpgs").arg(exifFiles.size()), exifFiles.size(), [&]() {
+		for (const QString& filePath : exifFiles) {
+			DkThumbNail thumb(filePath);
+			thumb.compute(DkThumbNail::force_full_thumb);
+		}
+	}));
+
+	addResult(measure("thumbs", "decoded thumbnails (160x120)", QString("%1 jpgs").arg(smallFiles.size()), smallFiles.size(), [&]() {
+		for (const QString& filePath : smallFiles) {
+			DkThumbNail thumb(filePath);
+			thumb.compute(DkThumbNail::force_full_thumb);
+		}
+	}));
+}
+
+void DkBenchmark::benchBatch() {
+
+	int numFiles = mQuick ? 20 : 100;
+	QStringList files = mData.files(mData.exifFilesDir(numFiles));
+	QString outDir = QDir(mData.workDir()).absoluteFilePath("batch-out");
+	QString dataset = QString("%1 jpgs").arg(files.size());
+
+	QSharedPointer<DkResizeBatch> resize(new DkResizeBatch());
+	resize->setProperties(0.5f);
+
+	QSharedPointer<DkBatchTransform> rotate(new DkBatchTransform());
+	rotate->setProperties(90);
+
+	QSharedPointer<DkBatchTransform> rotateExif(new DkBatchTransform());
+	rotateExif->setProperties(90, false, false, true);
+
+	QVector<QPair<QString, QSharedPointer<DkAbstractBatch> > > jobs;
+	jobs << qMakePair(QString("resize 0.5"), qSharedPointerCast<DkAbstractBatch>(resize));
+	jobs << qMakePair(QString("rotate 90"), qSharedPointerCast<DkAbstractBatch>(rotate));
+	jobs << qMakePair(QString("rotate 90 (exif)"), qSharedPointerCast<DkAbstractBatch>(rotateExif));
+
+	for (const QPair<QString, QSharedPointer<DkAbstractBatch> >& job : jobs) {
+
+		DkBatchConfig config(files, outDir, "<c:0>.<old>");
+		config.setProcessFunctions(QVector<QSharedPointer<DkAbstractBatch> >() << job.second);
+		config.setMode(DkBatchConfig::mode_overwrite);
+
+		if (!config.isOk()) {
+			qWarning() << "[DkBenchmark] illegal batch config";
+			return;
+		}
+
+		addResult(measure("batch", QString("DkBatchProcessing %1").arg(job.first), dataset, files.size(), [&]() {
+			DkBatchProcessing batch(config);
+			QEventLoop loop;
+			QObject::connect(&batch, SIGNAL(finished()), &loop, SLOT(quit()));
+			batch.compute();
+			loop.exec();
+		}, [&]() {
+			QDir(outDir).removeRecursively();
+			QDir().mkpath(outDir);
+		}));
+	}
+}
+
+QJsonObject DkBenchmark::toJson() const {
+
+	QStringList features;
+#ifdef WITH_OPENCV
+	features << "opencv";
+#endif
+#ifdef WITH_LIBTIFF
+	features << "libtiff";
+#endif
+#ifdef WITH_LIBRAW
+	features << "libraw";
+#endif
+#ifdef WITH_QUAZIP
+	features << "quazip";
+#endif
+
+	QJsonObject o;
+	o["benchmark"] = QString("nomacs");
+	o["version"] = QString(NOMACS_VERSION);
+	o["qt"] = QString(qVersion());
+#if QT_VERSION >= 0x050400
+	o["os"] = QSysInfo::prettyProductName();
+#endif
+	o["cpu"] = QSysInfo::currentCpuArchitecture();
+	o["threads"] = QThread::idealThreadCount();
+	o["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	o["runs"] = mNumRuns;
+	o["quick"] = mQuick;
+	o["features"] = QJsonArray::fromStringList(features);
+
+	QJsonArray results;
+	for (const DkBenchmarkResult& r : mResults)
+		results.append(r.toJson());
+	o["results"] = results;
+
+	// decoder counters of all runs (including the warm-up runs)
+	QJsonArray decoders;
+	for (const DkImageDecoder& d : DkDecoderRegistry::instance().decoders()) {
+		QJsonObject dj;
+		dj["name"] = d.name();
+		dj["capabilities"] = d.capabilities();
+		dj["calls"] = d.numCalls();
+		dj["loaded"] = d.numLoaded();
+		dj["totalSec"] = d.totalTime();
+		decoders.append(dj);
+	}
+	o["decoders"] = decoders;
+
+#ifdef WITH_OPENCV
+	// QImage <-> cv::Mat copies (see DkMatView)
+	o["image_conversions"] = DkMatView::numConversions();
+#endif
+
+	return o;
+}
+
+/**
+ * Saves the results as JSON.
+ * @param filePath the output file (stdout if empty)
+ * @return bool true if the results were written
+ **/
+bool DkBenchmark::save(const QString& filePath) const {
+
+	QByteArray json = QJsonDocument(toJson()).toJson(QJsonDocument::Indented);
+
+	if (filePath.isEmpty()) {
+		std::cout << json.constData() << std::endl;
+		return true;
+	}
+
+	QFile file(filePath);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "[DkBenchmark] cannot write" << filePath;
+		return false;
+	}
+
+	return file.write(json) == json.size();
+}
+
+}
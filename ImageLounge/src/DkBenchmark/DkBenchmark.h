@@ -0,0 +1,131 @@
+/*******************************************************************************************************
+ DkBenchmark.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QImage>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <functional>
+#pragma warning(pop)		// no warnings from includes - end
+
+namespace nmc {
+
+/**
+ * The timings of a single benchmark.
+ **/
+class DkBenchmarkResult {
+
+public:
+	DkBenchmarkResult(const QString& group = QString(), const QString& name = QString(), const QString& dataset = QString(), int numItems = 1);
+
+	void addRun(double ms);
+	bool isEmpty() const;
+	double minMs() const;
+	double medianMs() const;
+	double meanMs() const;
+	QJsonObject toJson() const;
+
+	QString group;
+	QString name;
+	QString dataset;
+	int numItems = 1;
+	qint64 bytes = 0;		// processed bytes per run (0 if not applicable)
+	QJsonObject extra;		// benchmark specific values (e.g. latency percentiles)
+
+protected:
+	QVector<double> mRuns;
+};
+
+/**
+ * Creates the synthetic datasets of the benchmarks.
+ * All files are created in the work directory and reused
+ * by subsequent runs (the content is deterministic).
+ **/
+class DkBenchmarkData {
+
+public:
+	DkBenchmarkData(const QString& workDir, const QSize& largeSize);
+
+	QString workDir() const;
+	QString smallFilesDir(int numFiles) const;
+	QString largeImage(const QString& format) const;
+	QString exifFilesDir(int numFiles) const;
+	QString multiPageTiff(int numPages) const;
+	QString zipArchive(int numFiles) const;
+	QStringList files(const QString& dirPath) const;
+
+	static QImage syntheticImage(const QSize& size);
+
+protected:
+	QString filledDir(const QString& name, int numFiles, const QByteArray& fileData, const QString& suffix) const;
+	QByteArray encode(const QImage& img, const char* format, int quality = -1) const;
+
+	QString mWorkDir;
+	QSize mLargeSize;
+};
+
+/**
+ * Runs the benchmarks of the loader and image processing hot paths.
+ * Results are written as JSON so that releases can be compared.
+ * Groups: folder, decode, exif, processing, pyramid, thumbs, batch
+ **/
+class DkBenchmark {
+
+public:
+	DkBenchmark(const QString& workDir, int numRuns = 5, bool quick = false);
+
+	void run(const QStringList& groups = QStringList());
+	QJsonObject toJson() const;
+	bool save(const QString& filePath) const;
+
+	static QStringList groups();
+
+protected:
+	DkBenchmarkResult measure(const QString& group, const QString& name, const QString& dataset, int numItems, std::function<void()> func, std::function<void()> prepare = std::function<void()>());
+	void addResult(const DkBenchmarkResult& result);
+
+	void benchFolder();
+	void benchDecode();
+	void benchExif();
+	void benchProcessing();
+	void benchPyramid();
+	void benchThumbs();
+	void benchBatch();
+
+	DkBenchmarkData mData;
+	int mNumRuns;
+	bool mQuick;
+	QVector<DkBenchmarkResult> mResults;
+};
+
+};
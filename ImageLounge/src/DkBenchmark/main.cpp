@@ -0,0 +1,102 @@
+/*******************************************************************************************************
+ main.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#pragma warning(pop)		// no warnings from includes - end
+
+#include "DkBenchmark.h"
+#include "DkSettings.h"
+#include "DkTimer.h"
+
+// runs the benchmark suite (e.g. nomacsBenchmark -platform offscreen -o results.json)
+int main(int argc, char *argv[]) {
+
+	// use separate settings - we do not want to touch the user's nomacs settings
+	QCoreApplication::setOrganizationName("nomacs");
+	QCoreApplication::setApplicationName("Image Lounge Benchmark");
+
+	QApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("nomacs benchmark suite");
+	parser.addHelpOption();
+
+	QCommandLineOption outputOpt(QStringList() << "o" << "output",
+		QObject::tr("Write the results (JSON) to <file> instead of stdout."),
+		QObject::tr("file"));
+	parser.addOption(outputOpt);
+
+	QCommandLineOption workDirOpt(QStringList() << "w" << "work-dir",
+		QObject::tr("The <directory> for the synthetic datasets (reused by subsequent runs)."),
+		QObject::tr("directory"),
+		QDir::temp().absoluteFilePath("nomacs-benchmark"));
+	parser.addOption(workDirOpt);
+
+	QCommandLineOption runsOpt(QStringList() << "r" << "runs",
+		QObject::tr("Number of timed <runs> per benchmark."),
+		QObject::tr("runs"),
+		"5");
+	parser.addOption(runsOpt);
+
+	QCommandLineOption groupsOpt(QStringList() << "g" << "groups",
+		QObject::tr("Comma separated <groups> to run: %1").arg(nmc::DkBenchmark::groups().join(", ")),
+		QObject::tr("groups"));
+	parser.addOption(groupsOpt);
+
+	QCommandLineOption quickOpt(QStringList() << "q" << "quick",
+		QObject::tr("Use small datasets (smoke test)."));
+	parser.addOption(quickOpt);
+
+	QCommandLineOption traceOpt(QStringList() << "trace",
+		QObject::tr("Write a Chrome trace of the benchmarks to <file>."),
+		QObject::tr("file"));
+	parser.addOption(traceOpt);
+
+	parser.process(a);
+
+	nmc::Settings::param().initFileFilters();
+
+	if (parser.isSet(traceOpt))
+		nmc::DkTracer::instance().start(parser.value(traceOpt));
+
+	QStringList groups;
+	if (parser.isSet(groupsOpt))
+		groups = parser.value(groupsOpt).split(",", QString::SkipEmptyParts);
+
+	nmc::DkBenchmark benchmark(parser.value(workDirOpt), parser.value(runsOpt).toInt(), parser.isSet(quickOpt));
+	benchmark.run(groups);
+
+	if (nmc::DkTracer::isEnabled()) {
+		nmc::DkTracer::instance().stop();
+		nmc::DkTracer::instance().save();
+	}
+
+	return benchmark.save(parser.value(outputOpt)) ? 0 : 1;
+}
@@ -301,6 +301,7 @@ void DkSettings::load() {
 		app_p.showHistoryDock = tmpShow;
 
 	app_p.closeOnEsc = settings.value("closeOnEsc", app_p.closeOnEsc).toBool();
+	app_p.singleInstance = settings.value("singleInstance", app_p.singleInstance).toBool();
 	app_p.showRecentFiles = settings.value("showRecentFiles", app_p.showRecentFiles).toBool();
 	
 	QStringList tmpFileFilters = app_p.fileFilters;
@@ -326,6 +327,7 @@ void DkSettings::load() {
 
 	global_p.loop = settings.value("loop", global_p.loop).toBool();
 	global_p.scanSubFolders = settings.value("scanRecursive", global_p.scanSubFolders).toBool();
+	global_p.maxSubFolders = settings.value("maxSubFolders", global_p.maxSubFolders).toInt();
 	global_p.lastDir = settings.value("lastDir", global_p.lastDir).toString();
 	global_p.searchHistory = settings.value("searchHistory", global_p.searchHistory).toStringList();
 	global_p.recentFolders = settings.value("recentFolders", global_p.recentFolders).toStringList();
@@ -424,6 +426,8 @@ void DkSettings::load() {
 	resources_p.filterDuplicats = settings.value("filterDuplicates", resources_p.filterDuplicats).toBool();
 	resources_p.preferredExtension = settings.value("preferredExtension", resources_p.preferredExtension).toString();	
 	resources_p.gammaCorrection = settings.value("gammaCorrection", resources_p.gammaCorrection).toBool();
+	resources_p.fastPreview = settings.value("fastPreview", resources_p.fastPreview).toBool();
+	resources_p.thumbMemory = settings.value("thumbMemory", resources_p.thumbMemory).toFloat();
 
 	if (sync_p.switchModifier) {
 		global_p.altMod = Qt::ControlModifier;
@@ -497,6 +501,8 @@ void DkSettings::save(bool force) {
 		settings.setValue("currentAppMode", app_p.currentAppMode);
 	if (!force && app_p.closeOnEsc != app_d.closeOnEsc)
 		settings.setValue("closeOnEsc", app_p.closeOnEsc);
+	if (!force && app_p.singleInstance != app_d.singleInstance)
+		settings.setValue("singleInstance", app_p.singleInstance);
 	if (!force && app_p.showRecentFiles != app_d.showRecentFiles)
 		settings.setValue("showRecentFiles", app_p.showRecentFiles);
 	if (!force && app_p.browseFilters != app_d.browseFilters)
@@ -516,6 +522,8 @@ void DkSettings::save(bool force) {
 		settings.setValue("loop",global_p.loop);
 	if (!force && global_p.scanSubFolders != global_d.scanSubFolders)
 		settings.setValue("scanRecursive",global_p.scanSubFolders);
+	if (!force && global_p.maxSubFolders != global_d.maxSubFolders)
+		settings.setValue("maxSubFolders", global_p.maxSubFolders);
 	if (!force && global_p.lastDir != global_d.lastDir)
 		settings.setValue("lastDir", global_p.lastDir);
 	if (!force && global_p.searchHistory != global_d.searchHistory)
@@ -677,6 +685,10 @@ void DkSettings::save(bool force) {
 		settings.setValue("preferredExtension", resources_p.preferredExtension);
 	if (!force && resources_p.gammaCorrection != resources_d.gammaCorrection)
 		settings.setValue("gammaCorrection", resources_p.gammaCorrection);
+	if (!force && resources_p.fastPreview != resources_d.fastPreview)
+		settings.setValue("fastPreview", resources_p.fastPreview);
+	if (!force && resources_p.thumbMemory != resources_d.thumbMemory)
+		settings.setValue("thumbMemory", resources_p.thumbMemory);
 	settings.endGroup();
 
 	// keep loaded settings in mind
@@ -709,6 +721,7 @@ void DkSettings::setToDefaultSettings() {
 	app_p.showHistoryDock = QBitArray(mode_end, false);
 	app_p.advancedSettings = false;
 	app_p.closeOnEsc = false;
+	app_p.singleInstance = false;
 	app_p.showRecentFiles = true;
 	app_p.browseFilters = QStringList();
 	app_p.showMenuBar = true;
@@ -719,11 +732,13 @@ void DkSettings::setToDefaultSettings() {
 
 	app_p.appMode = 0;
 	app_p.privateMode = false;
+	app_p.fastStart = false;
 
 	global_p.skipImgs = 10;
 	global_p.numFiles = 50;
 	global_p.loop = true;
 	global_p.scanSubFolders = false;
+	global_p.maxSubFolders = 10000;
 	global_p.lastDir = QString();
 	global_p.lastSaveDir = QString();
 	global_p.recentFiles = QStringList();
@@ -806,6 +821,8 @@ void DkSettings::setToDefaultSettings() {
 	resources_p.numThumbsLoading = 0;
 	resources_p.maxThumbsLoading = 5;
 	resources_p.gammaCorrection = true;
+	resources_p.fastPreview = true;
+	resources_p.thumbMemory = 64;	// MB
 	resources_p.waitForLastImg = true;
 
 	qDebug() << "ok... default settings are set";
@@ -148,8 +148,10 @@ public:
 		int appMode;
 		int currentAppMode;
 		bool privateMode;
+		bool fastStart;		// runtime only: started with a file, non-essential UI is created after the first image
 		bool advancedSettings;
 		bool closeOnEsc;
+		bool singleInstance;
 		bool maximizedMode;
 		QStringList browseFilters;
 		QStringList registerFilters;
@@ -192,6 +194,7 @@ public:
 		int numFiles;
 		bool loop;
 		bool scanSubFolders;
+		int maxSubFolders;	// -1: no limit
 
 		QString lastDir;
 		QString lastSaveDir;
@@ -258,6 +261,8 @@ public:
 		int numThumbsLoading;
 		int maxThumbsLoading;
 		bool gammaCorrection;
+		bool fastPreview;
+		float thumbMemory;
 	};
 
 	//enums for checkboxes - divide in camera data and description
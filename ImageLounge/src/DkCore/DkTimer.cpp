@@ -32,6 +32,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QString>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QCoreApplication>
+#include <QDebug>
 #pragma warning(pop)		// no warnings from includes - end
 
 #include "DkTimer.h"
@@ -95,4 +100,124 @@ void DkTimer::start() {
 double DkTimer::getTime() {
 	return (double) clock();
 }
+
+// DkTracer --------------------------------------------------------------------
+QAtomicInt DkTracer::sEnabled(0);
+
+DkTracer& DkTracer::instance() {
+
+	static DkTracer inst;
+	return inst;
+}
+
+/**
+ * Starts tracing.
+ * @param filePath the file the trace is saved to (see save())
+ **/
+void DkTracer::start(const QString& filePath) {
+
+	QMutexLocker locker(&mMutex);
+
+	mFilePath = filePath;
+	mEvents.clear();
+	mNumDropped = 0;
+	mMainThread = threadId();
+	mClock.start();
+
+	sEnabled = 1;
+	qDebug() << "[DkTracer] tracing to" << filePath;
+}
+
+void DkTracer::stop() {
+
+	sEnabled = 0;
+}
+
+/**
+ * Returns the trace time.
+ * @return qint64 microseconds since start()
+ **/
+qint64 DkTracer::now() const {
+
+	return mClock.nsecsElapsed() / 1000;
+}
+
+quint64 DkTracer::threadId() {
+
+	return (quint64)reinterpret_cast<quintptr>(QThread::currentThreadId());
+}
+
+void DkTracer::addEvent(const char* category, const char* name, qint64 start, qint64 duration) {
+
+	DkTraceEvent e = {category, name, 'X', threadId(), start, duration};
+
+	QMutexLocker locker(&mMutex);
+
+	if (mEvents.size() >= max_events) {
+		mNumDropped++;
+		return;
+	}
+
+	mEvents.append(e);
+}
+
+void DkTracer::addCounter(const char* name, qint64 value) {
+
+	DkTraceEvent e = {"counter", name, 'C', threadId(), now(), value};
+
+	QMutexLocker locker(&mMutex);
+
+	if (mEvents.size() >= max_events) {
+		mNumDropped++;
+		return;
+	}
+
+	mEvents.append(e);
+}
+
+/**
+ * Saves all events in the Chrome trace event format.
+ * @param filePath the output file - if empty, the file passed to start() is used
+ * @return bool true if the trace was written
+ **/
+bool DkTracer::save(const QString& filePath) const {
+
+	QMutexLocker locker(&mMutex);
+
+	QString fp = filePath.isEmpty() ? mFilePath : filePath;
+
+	if (fp.isEmpty())
+		return false;
+
+	QFile file(fp);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		qWarning() << "[DkTracer] cannot write" << fp;
+		return false;
+	}
+
+	qint64 pid = QCoreApplication::applicationPid();
+
+	QTextStream ts(&file);
+	ts << "{\"traceEvents\":[\n";
+	ts << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << mMainThread << ",\"args\":{\"name\":\"GUI\"}}";
+
+	for (const DkTraceEvent& e : mEvents) {
+
+		ts << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category << "\",\"ph\":\"" << e.phase 
+			<< "\",\"pid\":" << pid << ",\"tid\":" << e.tid << ",\"ts\":" << e.ts;
+
+		if (e.phase == 'C')
+			ts << ",\"args\":{\"value\":" << e.value << "}}";
+		else
+			ts << ",\"dur\":" << e.value << "}";
+	}
+
+	ts << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << mNumDropped << "}}\n";
+
+	qDebug() << "[DkTracer]" << mEvents.size() << "events written to" << fp;
+
+	return true;
+}
+
 }
\ No newline at end of file
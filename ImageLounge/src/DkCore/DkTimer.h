@@ -30,6 +30,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QObject>
+#include <QMutex>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 #pragma warning(pop)		// no warnings from includes - end
 
 #ifndef DllCoreExport
@@ -170,4 +174,93 @@ public:
 		lastTick = cTime;
 	};
 };
+
+/**
+ * Records scoped trace events and counters of a session.
+ * Tracing is enabled with nomacs --trace <file>. The events are saved
+ * as Chrome trace JSON which can be opened with chrome://tracing or Perfetto.
+ * If tracing is disabled, DK_TRACE and DK_TRACE_COUNTER cost a single atomic load.
+ * Names are not copied, so pass string literals only.
+ **/
+class DllCoreExport DkTracer {
+
+public:
+	static DkTracer& instance();
+
+	static bool isEnabled() {
+#if QT_VERSION >= 0x050000
+		return sEnabled.load() != 0;
+#else
+		return (int)sEnabled != 0;
+#endif
+	};
+
+	void start(const QString& filePath);
+	void stop();
+	bool save(const QString& filePath = QString()) const;
+
+	qint64 now() const;
+	void addEvent(const char* category, const char* name, qint64 start, qint64 duration);
+	void addCounter(const char* name, qint64 value);
+
+	enum {
+		max_events = 2000000,	// ~96 MB (48 bytes per event on 64 bit)
+	};
+
+protected:
+	DkTracer() {};
+	DkTracer(DkTracer const&);			// hide
+	void operator=(DkTracer const&);	// hide
+
+	static quint64 threadId();
+
+	struct DkTraceEvent {
+		const char* category;
+		const char* name;
+		char phase;			// 'X' complete event, 'C' counter
+		quint64 tid;
+		qint64 ts;			// us since start()
+		qint64 value;		// duration (us) or counter value
+	};
+
+	static QAtomicInt sEnabled;
+
+	mutable QMutex mMutex;
+	QVector<DkTraceEvent> mEvents;
+	QElapsedTimer mClock;
+	QString mFilePath;
+	quint64 mMainThread = 0;
+	int mNumDropped = 0;
+};
+
+/**
+ * Adds a trace event which lasts from construction to destruction.
+ * Use DK_TRACE("category", "name") at the beginning of a scope.
+ **/
+class DllCoreExport DkTraceScope {
+
+public:
+	DkTraceScope(const char* category, const char* name) : mCategory(category), mName(name) {
+		
+		if (DkTracer::isEnabled())
+			mStart = DkTracer::instance().now();
+	};
+
+	~DkTraceScope() {
+
+		if (mStart >= 0)
+			DkTracer::instance().addEvent(mCategory, mName, mStart, DkTracer::instance().now() - mStart);
+	};
+
+protected:
+	const char* mCategory;
+	const char* mName;
+	qint64 mStart = -1;
+};
+
+#define DK_TRACE_CONCAT_INTERN(a, b) a##b
+#define DK_TRACE_CONCAT(a, b) DK_TRACE_CONCAT_INTERN(a, b)
+#define DK_TRACE(category, name) nmc::DkTraceScope DK_TRACE_CONCAT(dkTraceScope, __LINE__)(category, name)
+#define DK_TRACE_COUNTER(name, value) do { if (nmc::DkTracer::isEnabled()) nmc::DkTracer::instance().addCounter(name, (qint64)(value)); } while (0)
+
 };
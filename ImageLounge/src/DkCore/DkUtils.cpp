@@ -856,6 +856,28 @@ void TreeItem::appendChild(TreeItem *item) {
 	//item->setParent(this);
 }
 
+void TreeItem::insertChild(int row, TreeItem* item) {
+	childItems.insert(row, item);
+	item->setParent(this);
+}
+
+/**
+ * Removes the child at row without deleting it.
+ * @param row the child's row
+ * @return TreeItem* the child (the caller takes ownership) or NULL if row is invalid
+ **/ 
+TreeItem* TreeItem::takeChild(int row) {
+
+	if (row < 0 || row >= childItems.size())
+		return 0;
+
+	TreeItem* item = childItems[row];
+	childItems.remove(row);
+	item->setParent(0);
+
+	return item;
+}
+
 TreeItem* TreeItem::child(int row) {
 
 	if (row < 0 || row >= childItems.size())
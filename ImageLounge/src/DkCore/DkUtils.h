@@ -446,6 +446,8 @@ public:
 	~TreeItem();
 
 	void appendChild(TreeItem *child);
+	void insertChild(int row, TreeItem* child);
+	TreeItem* takeChild(int row);
 
 	TreeItem *child(int row);
 	int childCount() const;
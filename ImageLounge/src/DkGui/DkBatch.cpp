@@ -1116,6 +1116,9 @@ void DkBatchTransformWidget::createLayout() {
 	mCbFlipH = new QCheckBox(tr("Flip &Horizontal"));
 	mCbFlipV = new QCheckBox(tr("Flip &Vertical"));
 
+	mCbExifOnly = new QCheckBox(tr("Rotate JPGs by their &EXIF Orientation"));
+	mCbExifOnly->setToolTip(tr("If checked, JPGs are rotated without decoding them (lossless).\nOnly the EXIF orientation is changed - viewers that ignore it show the original orientation."));
+
 	QGridLayout* layout = new QGridLayout(this);
 	layout->addWidget(mRbRotate0, 0, 0);
 	layout->addWidget(mRbRotateRight, 1, 0);
@@ -1124,6 +1127,7 @@ void DkBatchTransformWidget::createLayout() {
 
 	layout->addWidget(mCbFlipH, 0, 1);
 	layout->addWidget(mCbFlipV, 1, 1);
+	layout->addWidget(mCbExifOnly, 3, 1);
 	layout->setColumnStretch(3, 10);
 
 	connect(mRotateGroup, SIGNAL(buttonClicked(int)), this, SLOT(radioButtonClicked(int)));
@@ -1170,7 +1174,7 @@ void DkBatchTransformWidget::updateHeader() const {
 
 void DkBatchTransformWidget::transferProperties(QSharedPointer<DkBatchTransform> batchTransform) const {
 
-	batchTransform->setProperties(getAngle(), mCbFlipH->isChecked(), mCbFlipV->isChecked());
+	batchTransform->setProperties(getAngle(), mCbFlipH->isChecked(), mCbFlipV->isChecked(), mCbExifOnly->isChecked());
 }
 
 int DkBatchTransformWidget::getAngle() const {
@@ -27,6 +27,7 @@
 
 #include "DkConnection.h"
 #include "DkSettings.h"
+#include "DkTimer.h"
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QBuffer>
@@ -35,6 +36,7 @@
 #include <QHostInfo>
 #include <QThread>
 #include <QDebug>
+#include <QCoreApplication>
 #pragma warning(pop)		// no warnings from includes - end
 
 namespace nmc {
@@ -50,6 +52,11 @@ DkConnection::DkConnection(QObject* parent) : QTcpSocket(parent) {
 	mSynchronizedTimer = new QTimer(this);
 
 	connect(mSynchronizedTimer, SIGNAL(timeout()), this, SLOT(synchronizedTimerTimeout()));
+
+	mTransformTimer = new QTimer(this);
+	mTransformTimer->setSingleShot(true);
+	connect(mTransformTimer, SIGNAL(timeout()), this, SLOT(flushTransforms()));
+	mSyncClock.start();
 	connect(this, SIGNAL(readyRead()), this, SLOT(processReadyRead()));
 
 	setReadBufferSize(MaxBufferSize);
@@ -72,10 +79,8 @@ void DkConnection::sendStartSynchronizeMessage() {
 		ds << mSynchronizedPeersServerPorts[i];
 	}
 	//QByteArray data = "SYNCHRONIZE" + SeparatorToken + QByteArray::number(synchronize.size()) + SeparatorToken + synchronize;
-	QByteArray data = "STARTSYNCHRONIZE";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	qDebug() << "sending startsynchronize:" << data;
-	if (write(data) == data.size())
+	qDebug() << "sending startsynchronize:" << ba;
+	if (writeMessage("STARTSYNCHRONIZE", ba))
 		mIsSynchronizeMessageSent = true;
 }
 
@@ -84,9 +89,15 @@ void DkConnection::sendStopSynchronizeMessage() {
 		//qDebug() << "sending disable synchronize Message to " << this->peerName() << ":" << this->peerPort();
 		QByteArray synchronize = "disable synchronizing";
 		//QByteArray data = "DISABLESYNCHRONIZE" + SeparatorToken + QByteArray::number(synchronize.size()) + SeparatorToken + synchronize;
-		QByteArray data = "STOPSYNCHRONIZE";
-		data.append(SeparatorToken).append(QByteArray::number(synchronize.size())).append(SeparatorToken).append(synchronize);
-		if (write(data) == data.size())
+		qDebug() << syncReport();
+
+		// forget transforms that are still waiting
+		mTransformTimer->stop();
+		mTransformPending = false;
+		mRelativePending = false;
+		mPendingRelative.reset();
+
+		if (writeMessage("STOPSYNCHRONIZE", synchronize))
 			mIsSynchronizeMessageSent = false;
 		mState=ReadyForUse;
 	}
@@ -98,9 +109,7 @@ void DkConnection::sendNewTitleMessage(const QString& newtitle) {
 
 	QByteArray newTitleBA=newtitle.toUtf8();
 	//QByteArray data = "NEWTITLE" + SeparatorToken + QByteArray::number(newTitleBA.size()) + SeparatorToken + newTitleBA;
-	QByteArray data = "NEWTITLE";
-	data.append(SeparatorToken).append(QByteArray::number(newTitleBA.size())).append(SeparatorToken).append(newTitleBA);
-	write(data);
+	writeMessage("NEWTITLE", newTitleBA);
 }
 
 void DkConnection::sendNewPositionMessage(QRect position, bool opacity, bool overlaid) {
@@ -112,12 +121,70 @@ void DkConnection::sendNewPositionMessage(QRect position, bool opacity, bool ove
 	ds << overlaid;
 
 	//QByteArray data = "NEWTITLE" + SeparatorToken + QByteArray::number(ba.size()) + SeparatorToken + ba;
-	QByteArray data = "NEWPOSITION";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("NEWPOSITION", ba);
 }
 
+/**
+ * Queues a transform for the peer.
+ * Absolute transforms replace the pending one (only the latest state matters),
+ * relative transforms (canvasSize is null) are accumulated. The queue is
+ * flushed at most once per round trip so that slow peers do not replay stale transforms.
+ * @param transform the world matrix (or the relative translation)
+ * @param imgTransform the image matrix
+ * @param canvasSize the normalized image center (null for relative transforms)
+ **/ 
 void DkConnection::sendNewTransformMessage(QTransform transform, QTransform imgTransform, QPointF canvasSize) {
+	
+	if (!mTransformPending && !mRelativePending)
+		mPendingSince = mSyncClock.elapsed();
+
+	mNumTransformsQueued++;
+
+	if (canvasSize.isNull()) {
+		if (mRelativePending)
+			mNumTransformsCoalesced++;
+		mPendingRelative *= transform;
+		mRelativePending = true;
+	}
+	else {
+		if (mTransformPending)
+			mNumTransformsCoalesced++;
+		mPendingTransform = transform;
+		mPendingImgTransform = imgTransform;
+		mPendingCanvasSize = canvasSize;
+		mTransformPending = true;
+	}
+
+	// send now or wait for the next slot
+	qint64 interval = qBound((qint64)min_transform_interval, qRound64(mRoundTrip), (qint64)max_transform_interval);
+	qint64 elapsed = mSyncClock.elapsed() - mLastTransformSent;
+
+	if (mLastTransformSent < 0 || elapsed >= interval)
+		flushTransforms();
+	else if (!mTransformTimer->isActive())
+		mTransformTimer->start(interval - elapsed);
+}
+
+void DkConnection::flushTransforms() {
+
+	mTransformTimer->stop();
+
+	if (mRelativePending) {
+		writeTransformMessage(mPendingRelative, QTransform(), QPointF(), false);
+		mPendingRelative.reset();
+		mRelativePending = false;
+	}
+
+	if (mTransformPending) {
+		writeTransformMessage(mPendingTransform, mPendingImgTransform, mPendingCanvasSize, true);
+		mTransformPending = false;
+	}
+
+	mLastTransformSent = mSyncClock.elapsed();
+}
+
+void DkConnection::writeTransformMessage(const QTransform& transform, const QTransform& imgTransform, const QPointF& canvasSize, bool requestAck) {
+
 	//qDebug() << "sending new Transform Message to " << this->peerName() << ":" << this->peerPort();
 	QByteArray ba;
 	QDataStream ds(&ba, QIODevice::ReadWrite);
@@ -125,10 +192,43 @@ void DkConnection::sendNewTransformMessage(QTransform transform, QTransform imgT
 	ds << imgTransform;
 	ds << canvasSize;
 
-	//QByteArray data = "NEWTRANSFORM" + SeparatorToken + QByteArray::number(ba.size()) + SeparatorToken + ba;
-	QByteArray data = "NEWTRANSFORM";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	// old peers ignore the sequence number
+	if (requestAck && mPeerProtocolVersion >= 2) {
+
+		ds << ++mTransformSeq;
+
+		// we measure the latest message only
+		mAckSeq = mTransformSeq;
+		mAckSentAt = mSyncClock.elapsed();
+		mAckQueuedAt = mPendingSince;
+	}
+
+	writeMessage("NEWTRANSFORM", ba);
+	mNumTransformsSent++;
+}
+
+void DkConnection::transformAcknowledged(quint32 seq) {
+
+	if (seq != mAckSeq || mAckSentAt < 0)
+		return;
+
+	qint64 now = mSyncClock.elapsed();
+	double rtt = (double)(now - mAckSentAt);
+	double latency = (mAckSentAt - mAckQueuedAt) + rtt*0.5;	// queued -> received by the peer
+
+	mRoundTrip = (mRoundTrip == 0) ? rtt : mRoundTrip*0.8 + rtt*0.2;
+	mSyncLatency = (mSyncLatency == 0) ? latency : mSyncLatency*0.8 + latency*0.2;
+	mAckSentAt = -1;
+}
+
+QString DkConnection::syncReport() const {
+
+	return QString("[DkConnection] transforms queued: %1 sent: %2 coalesced: %3 | round trip: %4 ms latency: %5 ms")
+		.arg(mNumTransformsQueued)
+		.arg(mNumTransformsSent)
+		.arg(mNumTransformsCoalesced)
+		.arg(mRoundTrip, 0, 'f', 1)
+		.arg(mSyncLatency, 0, 'f', 1);
 }
 
 void DkConnection::sendNewFileMessage(qint16 op, const QString& filename) {
@@ -137,34 +237,151 @@ void DkConnection::sendNewFileMessage(qint16 op, const QString& filename) {
 	QDataStream ds(&ba, QIODevice::ReadWrite);
 	ds << op;
 	ds << filename;
-	QByteArray data = "NEWFILE";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("NEWFILE", ba);
 };
 
 void DkConnection::sendNewGoodbyeMessage() {
 	//qDebug() << "sending good bye to " << peerName() << ":" << this->peerPort();
 
 	QByteArray ba = "GoodBye";  // scherz?
-	QByteArray data = "GOODBYE";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("GOODBYE", ba);
 	waitForBytesWritten();
 }
 
+/**
+ * Sends a message to the peer.
+ * If the peer understands binary frames (see protocol_version), the message
+ * is sent with a fixed header: marker, version, type (index of protocolHeaders()) and length.
+ * Otherwise the text protocol is used: HEADER<length<payload
+ * @param header the message header (e.g. NEWTRANSFORM)
+ * @param payload the message data
+ * @return bool true if the whole message was written
+ **/ 
+bool DkConnection::writeMessage(const QByteArray& header, const QByteArray& payload) {
+
+	DK_TRACE("sync", "writeMessage");
+
+	QByteArray data;
+	int type = protocolHeaders().indexOf(header);
+
+	if (mBinaryProtocol && type != -1) {
+		data.reserve(frame_header_size + payload.size());
+		QDataStream ds(&data, QIODevice::WriteOnly);
+		ds << (quint8)BinaryFrameMarker;
+		ds << (quint8)protocol_version;
+		ds << (quint8)type;
+		ds << (quint32)payload.size();
+		ds.writeRawData(payload.constData(), payload.size());
+	}
+	else {
+		data = header;
+		data.append(SeparatorToken).append(QByteArray::number(payload.size())).append(SeparatorToken).append(payload);
+	}
+
+	return write(data) == data.size();
+}
+
+/**
+ * Reads the header of a binary frame.
+ * The header is converted to its text representation (e.g. NEWTRANSFORM<)
+ * so that readProtocolHeader() works for both protocols.
+ * @return bool true if a complete frame header was read
+ **/ 
+bool DkConnection::readFrameHeader() {
+
+	if (bytesAvailable() < frame_header_size)
+		return false;
+
+	quint8 marker, version, type;
+	quint32 length;
+
+	QDataStream ds(read(frame_header_size));
+	ds >> marker;
+	ds >> version;
+	ds >> type;
+	ds >> length;
+
+	if (type >= protocolHeaders().size() || length > (quint32)MaxBufferSize) {
+		qWarning() << "[DkConnection] illegal frame (type:" << type << "length:" << length << ") received from:" << peerAddress();
+		abort();
+		return false;
+	}
+
+	mBuffer = protocolHeaders().at(type);
+	mBuffer.append(SeparatorToken);
+	mFrameLength = length;
+	mBinaryFrame = true;
+
+	return true;
+}
+
+/**
+ * Appends our protocol version to a greeting message.
+ * Old peers ignore trailing greeting data.
+ **/ 
+void DkConnection::writeProtocolVersion(QDataStream& ds) const {
+
+	ds << (quint16)protocol_version;
+}
+
+/**
+ * Reads the peer's protocol version from the end of a greeting message.
+ * Peers that do not send a version just understand the text protocol.
+ **/ 
+void DkConnection::readProtocolVersion(QDataStream& ds) {
+
+	quint16 version = 0;
+
+	if (!ds.atEnd())
+		ds >> version;
+
+	mPeerProtocolVersion = version;
+	mBinaryProtocol = version >= 1;
+	qDebug() << "[DkConnection] peer protocol version:" << version << (mBinaryProtocol ? "-> binary frames" : "-> text protocol");
+}
+
+/**
+ * All message headers known - the index is the type of a binary frame.
+ * NOTE: never change the order, append new headers.
+ **/ 
+const QList<QByteArray>& DkConnection::protocolHeaders() {
+
+	static const QList<QByteArray> headers = QList<QByteArray>()
+		<< "GREETING"
+		<< "STARTSYNCHRONIZE"
+		<< "STOPSYNCHRONIZE"
+		<< "NEWTITLE"
+		<< "NEWPOSITION"
+		<< "NEWTRANSFORM"
+		<< "NEWFILE"
+		<< "GOODBYE"
+		<< "QUIT"
+		<< "UPCOMINGIMAGE"
+		<< "NEWIMAGE"
+		<< "SWITCHSERVER"
+		<< "PERMISSION"
+		<< "ASKPERMISSION"
+		<< "RCTYPE"
+		<< "TRANSFORMACK"
+		<< "SHAREDIMAGE";
+
+	return headers;
+}
+
 void DkConnection::synchronizedPeersListChanged(QList<quint16> newList) {
 	mSynchronizedPeersServerPorts = newList;
 }
 
 bool DkConnection::readProtocolHeader() {
-	QByteArray greetingBA = QByteArray("GREETING").append(SeparatorToken);
-	QByteArray synchronizeBA = QByteArray("STARTSYNCHRONIZE").append(SeparatorToken);
-	QByteArray disableSynchronizeBA = QByteArray("STOPSYNCHRONIZE").append(SeparatorToken);
-	QByteArray newtitleBA = QByteArray("NEWTITLE").append(SeparatorToken);
-	QByteArray newtransformBA = QByteArray("NEWTRANSFORM").append(SeparatorToken);
-	QByteArray newpositionBA = QByteArray("NEWPOSITION").append(SeparatorToken);
-	QByteArray newFileBA = QByteArray("NEWFILE").append(SeparatorToken);
-	QByteArray goodbyeBA = QByteArray("GOODBYE").append(SeparatorToken);
+	static const QByteArray greetingBA = QByteArray("GREETING").append(SeparatorToken);
+	static const QByteArray synchronizeBA = QByteArray("STARTSYNCHRONIZE").append(SeparatorToken);
+	static const QByteArray disableSynchronizeBA = QByteArray("STOPSYNCHRONIZE").append(SeparatorToken);
+	static const QByteArray newtitleBA = QByteArray("NEWTITLE").append(SeparatorToken);
+	static const QByteArray newtransformBA = QByteArray("NEWTRANSFORM").append(SeparatorToken);
+	static const QByteArray newpositionBA = QByteArray("NEWPOSITION").append(SeparatorToken);
+	static const QByteArray newFileBA = QByteArray("NEWFILE").append(SeparatorToken);
+	static const QByteArray goodbyeBA = QByteArray("GOODBYE").append(SeparatorToken);
+	static const QByteArray transformAckBA = QByteArray("TRANSFORMACK").append(SeparatorToken);
 
 	if (mBuffer == greetingBA) {
 		//qDebug() << "Greeting received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -190,6 +407,8 @@ bool DkConnection::readProtocolHeader() {
 	} else if (mBuffer == goodbyeBA) {
 		//qDebug() << "Goodbye received from:" << this->peerAddress() << ":" << this->peerPort();
 		mCurrentDataType = GoodBye;
+	} else if (mBuffer == transformAckBA) {
+		mCurrentDataType = transformAck;
 	} else {
 		qDebug() << QString(mBuffer);
 		qDebug() << "Undefined received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -215,12 +434,15 @@ int DkConnection::readDataIntoBuffer(int maxSize) {
 		return 0;
 	}
 
-	while (bytesAvailable() > 0 && mBuffer.size() < maxSize) {
-		mBuffer.append(read(1));
-		if (mBuffer.endsWith(SeparatorToken)) {
-			break;
-		}
-	}
+	// binary frames know their header & length
+	if (mBuffer.isEmpty() && peek(1) == QByteArray(1, BinaryFrameMarker))
+		return readFrameHeader() ? mBuffer.size() : 0;
+
+	// read up to the next separator at once
+	QByteArray chunk = peek(qMin(bytesAvailable(), (qint64)(maxSize - mBuffer.size())));
+	int sepIdx = chunk.indexOf(SeparatorToken);
+	mBuffer.append(read(sepIdx != -1 ? sepIdx+1 : chunk.size()));
+
 	return mBuffer.size() - numBytesBeforeRead;
 }
 
@@ -241,6 +463,12 @@ bool DkConnection::hasEnoughData() {
 }
 
 int DkConnection::dataLengthForCurrentDataType() {
+
+	if (mBinaryFrame) {
+		mBinaryFrame = false;
+		return mFrameLength;
+	}
+
 	if (bytesAvailable() <= 0 || readDataIntoBuffer() <= 0 || !mBuffer.endsWith(SeparatorToken))
 		return 0;
 
@@ -398,6 +626,8 @@ bool DkConnection::readDataTypeIntoBuffer() {
 }
 
 void DkConnection::processData() {
+
+	DK_TRACE("sync", "processData");
 	switch (mCurrentDataType) {
 	case newTitle:
 		emit connectionTitleHasChanged(this, QString::fromUtf8(mBuffer));
@@ -424,8 +654,25 @@ void DkConnection::processData() {
 			dsTransform >> imgTransform;
 			dsTransform >> canvasSize;
 			emit connectionNewTransform(this, transform, imgTransform, canvasSize);
+
+			// the peer wants to measure the round trip
+			if (!dsTransform.atEnd()) {
+				quint32 seq;
+				dsTransform >> seq;
+
+				QByteArray ba;
+				QDataStream ds(&ba, QIODevice::ReadWrite);
+				ds << seq;
+				writeMessage("TRANSFORMACK", ba);
+			}
 		}
 		break;}
+	case transformAck: {
+		quint32 seq;
+		QDataStream ds(mBuffer);
+		ds >> seq;
+		transformAcknowledged(seq);
+		break;}
 	case newFile: {
 		if (mState == Synchronized) {
 			qint16 op;
@@ -451,13 +698,134 @@ void DkConnection::synchronizedTimerTimeout() {
 	emit connectionStopSynchronize(this);
 }
 
+// DkSharedImage --------------------------------------------------------------------
+/**
+ * Copies the image into a new shared memory segment.
+ * @param img the image to be shared
+ * @param numReceivers the number of peers that will attach
+ **/ 
+DkSharedImage::DkSharedImage(const QImage& img, int numReceivers) {
+
+	static int imgCount = 0;
+	mMemory.setKey(QString("nomacs-image-%1-%2").arg(QCoreApplication::applicationPid()).arg(imgCount++));
+	mAge.start();
+
+	if (img.isNull() || numReceivers <= 0)
+		return;
+
+	int numBytes = img.bytesPerLine()*img.height();
+
+	if (!mMemory.create(header_size + numBytes)) {
+		qWarning() << "[DkSharedImage] could not create shared memory:" << mMemory.errorString();
+		return;
+	}
+
+	mMemory.lock();
+	Header* header = static_cast<Header*>(mMemory.data());
+	header->magic = magicNumber();
+	header->refCount = numReceivers;
+	header->width = img.width();
+	header->height = img.height();
+	header->bytesPerLine = img.bytesPerLine();
+	header->format = img.format();
+
+	// this is the only copy
+	memcpy(static_cast<char*>(mMemory.data()) + header_size, img.constBits(), numBytes);
+	mMemory.unlock();
+
+	mValid = true;
+}
+
+DkSharedImage::~DkSharedImage() {
+
+	// the segment is destroyed by the OS if the last process detaches
+	if (mMemory.isAttached())
+		mMemory.detach();
+}
+
+QString DkSharedImage::key() const {
+	
+	return mMemory.key();
+}
+
+bool DkSharedImage::isValid() const {
+
+	return mValid;
+}
+
+/**
+ * Returns true if all receivers attached to the image.
+ * @return bool true if the segment can be released by the sender
+ **/ 
+bool DkSharedImage::isReleased() const {
+
+	if (!mValid || mAge.elapsed() > timeout_ms)
+		return true;
+
+	QSharedMemory& mem = const_cast<QSharedMemory&>(mMemory);
+	mem.lock();
+	bool released = static_cast<const Header*>(mem.constData())->refCount <= 0;
+	mem.unlock();
+
+	return released;
+}
+
+/**
+ * Attaches to an image shared by a local peer.
+ * The returned image maps the shared pixels read only (no copy) and keeps
+ * the segment attached as long as the image lives. Writing to it creates a private copy.
+ * @param key the segment's key
+ * @return QImage the shared image or a null image if the segment is gone
+ **/ 
+QImage DkSharedImage::attach(const QString& key) {
+
+	QSharedMemory* memory = new QSharedMemory(key);
+
+	if (!memory->attach()) {
+		qWarning() << "[DkSharedImage] could not attach to" << key << memory->errorString();
+		delete memory;
+		return QImage();
+	}
+
+	memory->lock();
+	Header* header = static_cast<Header*>(memory->data());
+	Header h = *header;
+	
+	if (h.magic == magicNumber())
+		header->refCount--;
+	memory->unlock();
+
+	if (h.magic != magicNumber() || 
+		memory->size() < header_size + h.bytesPerLine*h.height) {
+		qWarning() << "[DkSharedImage] illegal image header in" << key;
+		delete memory;
+		return QImage();
+	}
+
+	// read only: an edit detaches the image instead of changing the pixels all peers have mapped
+	const uchar* bits = static_cast<const uchar*>(memory->constData()) + header_size;
+
+#if QT_VERSION >= 0x050000
+	return QImage(bits, h.width, h.height, h.bytesPerLine, (QImage::Format)h.format, &DkSharedImage::detachImage, memory);
+#else
+	QImage img = QImage(bits, h.width, h.height, h.bytesPerLine, (QImage::Format)h.format).copy();
+	delete memory;
+	return img;
+#endif
+}
+
+void DkSharedImage::detachImage(void* memory) {
+
+	delete static_cast<QSharedMemory*>(memory);	// detaches
+}
+
 // DkLocalConnection --------------------------------------------------------------------
 DkLocalConnection::DkLocalConnection(QObject* parent/* =0 */) : DkConnection(parent) {
 }
 
 
 void DkLocalConnection::processReadyRead() {
-	if (mCurrentLocalDataType == Quit) { // long message (copied from lan connection) -> does this work here correctly?
+	if (mCurrentLocalDataType != Undefined) { // long message (copied from lan connection) -> does this work here correctly?
 		readWhileBytesAvailable();
 		return;
 	}
@@ -470,21 +838,62 @@ void DkLocalConnection::processReadyRead() {
 	DkConnection::processReadyRead();
 }
 
+void DkLocalConnection::readWhileBytesAvailable() {
+	do {
+		if (mCurrentDataType == DkConnection::Undefined && mCurrentLocalDataType == Undefined) {
+			if (readDataIntoBuffer() <= 0)
+				return;
+			if (!readProtocolHeader())
+				return;
+			checkState();
+		}
+		if (!hasEnoughData()) {
+			return;
+		}
+
+		mBuffer = read(mNumBytesForCurrentDataType);
+		if (mBuffer.size() != mNumBytesForCurrentDataType) {
+			abort();
+			return;
+		}
+		processData();
+	} while (bytesAvailable() > 0);
+}
+
 void DkLocalConnection::processData() {
 	switch (mCurrentLocalDataType) {
 	case Quit:
 		emit connectionQuitReceived();
 		break;
+	case SharedImage:
+		if (mState == Synchronized) {
+			QString key;
+			QString title;
+			QDataStream ds(mBuffer);
+			ds >> key;
+			ds >> title;
+
+			QImage img = DkSharedImage::attach(key);
+			if (!img.isNull())
+				emit connectionNewImage(this, img, title);
+		}
+		break;
+	default:
+		break;
 	}
 	
+	mCurrentLocalDataType = Undefined;
 	DkConnection::processData();
 }
 
 bool DkLocalConnection::readProtocolHeader() {
-	QByteArray quitBA = QByteArray("QUIT").append(SeparatorToken);
+	static const QByteArray quitBA = QByteArray("QUIT").append(SeparatorToken);
+	static const QByteArray sharedImageBA = QByteArray("SHAREDIMAGE").append(SeparatorToken);
 
 	if (mBuffer == quitBA) {
 		mCurrentLocalDataType = Quit;
+	} else if (mBuffer == sharedImageBA) {
+		mCurrentLocalDataType = SharedImage;
 	} else {
 		return DkConnection::readProtocolHeader();
 	}
@@ -502,20 +911,13 @@ void DkLocalConnection::sendGreetingMessage(const QString& currentTitle) {
 	QDataStream ds(&ba, QIODevice::ReadWrite);
 	ds << mLocalTcpServerPort;
 	ds << mCurrentTitle;
+	writeProtocolVersion(ds);
 
 	//qDebug() << "title: " << mCurrentTitle;
 	//qDebug() << "local tcp: " << mLocalTcpServerPort;
 	//qDebug() << "peer id: " << mPeerId;
 
-	QByteArray data = "GREETING";
-	data.append(SeparatorToken);
-	data.append(QByteArray::number(ba.size()));
-	data.append(SeparatorToken);
-	data.append(ba);
-
-	//qDebug() << "greeting message: " << data;
-
-	if (write(data) == data.size()) {
+	if (writeMessage("GREETING", ba)) {
 		mIsGreetingMessageSent = true;
 	}
 
@@ -526,23 +928,31 @@ void DkLocalConnection::readGreetingMessage() {
 	QDataStream ds(mBuffer);
 	ds >> this->mPeerServerPort;
 	ds >> title;
+	readProtocolVersion(ds);
 
 	//qDebug() << "emitting readyForUse";
 	emit connectionReadyForUse(mPeerServerPort, title, this);
 }
 
+void DkLocalConnection::sendSharedImageMessage(const QString& key, const QString& title) {
+
+	if (!canReceiveSharedImages())
+		return;
+
+	QByteArray ba;
+	QDataStream ds(&ba, QIODevice::ReadWrite);
+	ds << key;
+	ds << title;
+
+	writeMessage("SHAREDIMAGE", ba);
+}
+
 void DkLocalConnection::sendQuitMessage() {
 	QByteArray ba;
 	QDataStream ds(&ba, QIODevice::ReadWrite);
 	ds << "updating";
 
-	QByteArray data = "QUIT";
-	data.append(SeparatorToken);
-	data.append(QByteArray::number(ba.size()));
-	data.append(SeparatorToken);
-	data.append(ba);
-
-	if (write(data) == data.size()) {
+	if (writeMessage("QUIT", ba)) {
 		mIsGreetingMessageSent = true;
 	}
 }
@@ -565,9 +975,7 @@ void DkLANConnection::sendNewUpcomingImageMessage(const QString& imageTitle) {
 	QDataStream ds(&ba, QIODevice::ReadWrite);
 	ds << title;
 
-	QByteArray data = "UPCOMINGIMAGE";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("UPCOMINGIMAGE", ba);
 };
 
 
@@ -601,9 +1009,7 @@ void DkLANConnection::sendNewImageMessage(const QImage& image, const QString& im
 	//qDebug() << "my stacksize is: " << (float)this->thread()->stackSize()/1000000.0f;
 
 	try {
-		QByteArray data = "NEWIMAGE";
-		data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-		write(data);
+		writeMessage("NEWIMAGE", ba);
 	} 
 	catch(...) {
 		QString imageSize;
@@ -621,9 +1027,7 @@ void DkLANConnection::sendSwitchServerMessage(const QHostAddress& address, quint
 	ds << address;
 	ds << port;	
 
-	QByteArray data = "SWITCHSERVER";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("SWITCHSERVER", ba);
 }
 
 void DkLANConnection::sendGreetingMessage(const QString& currentTitle) {
@@ -641,15 +1045,11 @@ void DkLANConnection::sendGreetingMessage(const QString& currentTitle) {
 	if (mIAmServer) 
 		ds << currentTitle;
 	else
-		ds << " ";
+		ds << QString(" ");
+	writeProtocolVersion(ds);
 
 	//QByteArray data = "GREETING" + SeparatorToken + QByteArray::number(ba.size()) + SeparatorToken + ba;
-	QByteArray data = "GREETING";
-	data.append(SeparatorToken);
-	data.append(QByteArray::number(ba.size()));
-	data.append(SeparatorToken);
-	data.append(ba);
-	if (write(data) == data.size())
+	if (writeMessage("GREETING", ba))
 		mIsGreetingMessageSent = true;
 }
 
@@ -665,10 +1065,18 @@ void DkLANConnection::readGreetingMessage() {
 		ds >> mAllowPosition;
 		ds >> mAllowTransformation;
 		ds >> title;		
+		readProtocolVersion(ds);
 	} else {
 		QDataStream ds(mBuffer); // only read clientname
 		ds >> mClientName;
 
+		// skip the client's settings
+		bool dummy;
+		QString dummyTitle;
+		ds >> dummy >> dummy >> dummy >> dummy;
+		ds >> dummyTitle;
+		readProtocolVersion(ds);
+
 		mAllowFile = Settings::param().sync().allowFile;
 		mAllowImage = Settings::param().sync().allowImage;
 		mAllowPosition = Settings::param().sync().allowPosition;
@@ -682,9 +1090,9 @@ void DkLANConnection::readGreetingMessage() {
 
 bool DkLANConnection::readProtocolHeader() {
 	//qDebug() << "DkLANConnection::readProtocolHeader";
-	QByteArray newImageBA = QByteArray("NEWIMAGE").append(SeparatorToken);
-	QByteArray upcomingImageBA = QByteArray("UPCOMINGIMAGE").append(SeparatorToken);
-	QByteArray switchServerBA = QByteArray("SWITCHSERVER").append(SeparatorToken);
+	static const QByteArray newImageBA = QByteArray("NEWIMAGE").append(SeparatorToken);
+	static const QByteArray upcomingImageBA = QByteArray("UPCOMINGIMAGE").append(SeparatorToken);
+	static const QByteArray switchServerBA = QByteArray("SWITCHSERVER").append(SeparatorToken);
 
 	if (mBuffer == newImageBA) {
 		//qDebug() << "New Image received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -832,9 +1240,9 @@ void DkRCConnection::readGreetingMessage() {
 
 bool DkRCConnection::readProtocolHeader() {
 	//qDebug() << __FUNCTION__ << " " << __LINE__;
-	QByteArray newPermissionBA = QByteArray("PERMISSION").append(SeparatorToken);
-	QByteArray newAskPermissionBA = QByteArray("ASKPERMISSION").append(SeparatorToken);
-	QByteArray newRCType = QByteArray("RCTYPE").append(SeparatorToken);
+	static const QByteArray newPermissionBA = QByteArray("PERMISSION").append(SeparatorToken);
+	static const QByteArray newAskPermissionBA = QByteArray("ASKPERMISSION").append(SeparatorToken);
+	static const QByteArray newRCType = QByteArray("RCTYPE").append(SeparatorToken);
 
 	if (mBuffer == newPermissionBA) {
 		//qDebug() << "New Permission received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -938,9 +1346,7 @@ void DkRCConnection::sendAskForPermission() {
 	QDataStream ds(&ba, QIODevice::ReadWrite);
 	ds << "dummyMessage";
 
-	QByteArray data = "ASKPERMISSION";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("ASKPERMISSION", ba);
 	this->waitForBytesWritten();
 }
 
@@ -957,9 +1363,7 @@ void DkRCConnection::sendPermission() {
 	QDataStream ds(&ba, QIODevice::ReadWrite);
 	ds << (Settings::param().sync().syncWhiteList.contains(getClientName()) != 0);
 	ds << "dummyText";
-	QByteArray data = "PERMISSION";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("PERMISSION", ba);
 	this->waitForBytesWritten();
 }
 
@@ -967,9 +1371,7 @@ void DkRCConnection::sendRCType(int type) {
 	QByteArray ba;
 	QDataStream ds(&ba, QIODevice::ReadWrite);
 	ds << type;
-	QByteArray data = "RCTYPE";
-	data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-	write(data);
+	writeMessage("RCTYPE", ba);
 	this->waitForBytesWritten();
 }
 
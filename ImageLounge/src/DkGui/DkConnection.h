@@ -33,6 +33,8 @@
 #include <QTransform>
 #include <QHostAddress>
 #include <QImage>
+#include <QElapsedTimer>
+#include <QSharedMemory>
 #pragma warning(pop)		// no warnings from includes - end
 
 #pragma warning(disable: 4251)
@@ -53,11 +55,13 @@
 
 // Qt defines
 class QTimer;
+class QDataStream;
 
 namespace nmc {
 
 static const int MaxBufferSize = 102400000;
 static const char SeparatorToken = '<';
+static const char BinaryFrameMarker = '\xff';	// never starts a text header
 
 class DllGuiExport DkConnection : public QTcpSocket {
 	Q_OBJECT;
@@ -76,9 +80,22 @@ class DllGuiExport DkConnection : public QTcpSocket {
 		quint16 getPeerId() {return mPeerId;};
 		void setPeerId(quint16 peerId) { mPeerId = peerId;};
 		void setTitle(const QString& newTitle);
+		bool isBinaryProtocol() const { return mBinaryProtocol; };
+		quint16 peerProtocolVersion() const { return mPeerProtocolVersion; };
+		QString syncReport() const;
 
 		bool connectionCreated;
 
+		enum {
+			protocol_version = 3,	// 0: text only, 1: binary frames, 2: transform acks, 3: shared images
+			frame_header_size = 7,	// marker, version, type, length (quint32)
+		};
+
+		enum {
+			min_transform_interval = 15,	// ms between two transform messages
+			max_transform_interval = 500,	// ms - even if the peer is really slow
+		};
+
 	signals:
 		void connectionReadyForUse(quint16 peerServerPort, const QString& title, DkConnection* connection) const;
 		void connectionStartSynchronize(QList<quint16> synchronizedPeersOfOtherClient, DkConnection* connection) const;
@@ -117,6 +134,7 @@ class DllGuiExport DkConnection : public QTcpSocket {
 			newTransform,
 			newFile,
 			GoodBye,
+			transformAck,
 			Undefined
 		};
 
@@ -131,6 +149,14 @@ class DllGuiExport DkConnection : public QTcpSocket {
 		int dataLengthForCurrentDataType();
 		virtual bool allowedToSynchronize() {return true;};
 
+		bool writeMessage(const QByteArray& header, const QByteArray& payload);
+		bool readFrameHeader();
+		void writeProtocolVersion(QDataStream& ds) const;
+		void readProtocolVersion(QDataStream& ds);
+		static const QList<QByteArray>& protocolHeaders();
+		void writeTransformMessage(const QTransform& transform, const QTransform& imgTransform, const QPointF& canvasSize, bool requestAck);
+		void transformAcknowledged(quint32 seq);
+
 		ConnectionState mState = WaitingForGreeting; 
 		DataType mCurrentDataType = Undefined; 
 		QByteArray mBuffer;
@@ -140,20 +166,88 @@ class DllGuiExport DkConnection : public QTcpSocket {
 		quint16 mPeerServerPort = 0;
 		bool mIsGreetingMessageSent = false;
 		bool mIsSynchronizeMessageSent = false;
+		bool mBinaryProtocol = false;	// true if the peer understands binary frames
+		quint16 mPeerProtocolVersion = 0;
+		bool mBinaryFrame = false;		// true if the current header was read from a binary frame
+		int mFrameLength = 0;
 
 	protected slots:
 		virtual void processReadyRead();
 
 	private slots:
 		void synchronizedTimerTimeout();
+		void flushTransforms();
 
 	protected:
 
 		QTimer* mSynchronizedTimer;
+
+		// transform sync channel: only the latest transform is sent (at most once per round trip)
+		QTimer* mTransformTimer;
+		QElapsedTimer mSyncClock;
+		bool mTransformPending = false;
+		QTransform mPendingTransform;
+		QTransform mPendingImgTransform;
+		QPointF mPendingCanvasSize;
+		bool mRelativePending = false;
+		QTransform mPendingRelative;
+		qint64 mPendingSince = 0;
+		qint64 mLastTransformSent = -1;
+		quint32 mTransformSeq = 0;
+		quint32 mAckSeq = 0;
+		qint64 mAckSentAt = -1;
+		qint64 mAckQueuedAt = -1;
+		double mRoundTrip = 0;		// ms (smoothed)
+		double mSyncLatency = 0;	// ms (smoothed)
+		int mNumTransformsQueued = 0;
+		int mNumTransformsSent = 0;
+		int mNumTransformsCoalesced = 0;
 		QList<quint16> mSynchronizedPeersServerPorts;
 		quint16 mPeerId;
 };
 
+/**
+ * Hands images to local peers via shared memory.
+ * The segment holds a small header (reference count, size, format)
+ * followed by the raw pixels. Receivers map the pixels directly and 
+ * decrement the reference count. The sender keeps the segment alive
+ * until all receivers attached (or timeout_ms passed).
+ **/ 
+class DllGuiExport DkSharedImage {
+
+	public:
+		DkSharedImage(const QImage& img, int numReceivers);
+		~DkSharedImage();
+
+		QString key() const;
+		bool isValid() const;
+		bool isReleased() const;
+
+		static QImage attach(const QString& key);
+
+		enum {
+			header_size = 32,		// bytes reserved for the Header
+			timeout_ms = 10000,		// we give up if the receivers do not attach within this time
+		};
+
+	protected:
+		struct Header {
+			quint32 magic;
+			qint32 refCount;
+			qint32 width;
+			qint32 height;
+			qint32 bytesPerLine;
+			qint32 format;
+		};
+
+		static void detachImage(void* memory);
+		static quint32 magicNumber() { return 0x6e6d6373; };	// nmcs
+
+		QSharedMemory mMemory;
+		QElapsedTimer mAge;
+		bool mValid = false;
+};
+
 class DllGuiExport DkLocalConnection : public DkConnection {
 	Q_OBJECT;
 
@@ -163,10 +257,14 @@ class DllGuiExport DkLocalConnection : public DkConnection {
 		quint16 getLocalTcpServerPort() { return mLocalTcpServerPort;};
 		void setLocalTcpServerPort(quint16 localTcpServerPort) { mLocalTcpServerPort = localTcpServerPort;};
 		void sendGreetingMessage(const QString& currentTitle);
-		
+		bool canReceiveSharedImages() const { return mPeerProtocolVersion >= 3; };
 
 	signals:
 		void connectionQuitReceived();
+		void connectionNewImage(DkConnection* connection, const QImage& image, const QString& title);
+
+	public slots:
+		void sendSharedImageMessage(const QString& key, const QString& title);
 
 	protected slots:
 		void processReadyRead();
@@ -176,9 +274,12 @@ class DllGuiExport DkLocalConnection : public DkConnection {
 	protected:
 		enum LocalDataType {
 			Quit,
+			SharedImage,
 			Undefined
 		};
 
+		void readWhileBytesAvailable();
+
 	private:
 		bool readProtocolHeader();
 		void readGreetingMessage();
@@ -476,6 +476,7 @@ void DkControlWidget::hideCrop(bool hide /* = true */) {
 void DkControlWidget::showCrop(bool visible) {
 
 	if (visible) {
+		mViewport->loadFullImage();		// the crop rect refers to the full image
 		mCropWidget->reset();
 		switchWidget(mWidgets[crop_widget]);
 		connect(mCropWidget->getToolbar(), SIGNAL(colorSignal(const QBrush&)), mViewport, SLOT(setBackgroundBrush(const QBrush&)));
@@ -492,7 +493,7 @@ void DkControlWidget::showHistogram(bool visible) {
 
 	if (visible && !mHistogram->isVisible()) {
 		mHistogram->show();
-		if(!mViewport->getImage().isNull()) mHistogram->drawHistogram(mViewport->getImage());
+		if(!mViewport->getImage().isNull()) mHistogram->drawHistogram(mViewport->getImage(), mViewport->imageContainer());
 		else  mHistogram->clearHistogram();
 	}
 	else if (!visible && mHistogram->isVisible()) {
@@ -619,6 +620,7 @@ void DkControlWidget::setPluginWidget(DkViewPortInterface* pluginWidget, bool re
 	if (!pluginViewport) return;
 
 	if (!removeWidget) {
+		mViewport->loadFullImage();		// plugins paint in full image coordinates
 		pluginViewport->setWorldMatrix(mViewport->getWorldMatrixPtr());
 		pluginViewport->setImgMatrix(mViewport->getImageMatrixPtr());
 
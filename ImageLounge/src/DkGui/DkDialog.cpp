@@ -37,6 +37,7 @@
 #include "DkUtils.h"
 #include "DkActionManager.h"
 #include "DkPluginManager.h"
+#include "DkDirScanner.h"
 
 #if defined(WIN32) && !defined(SOCK_STREAM)
 #include <winsock2.h>	// needed since libraw 0.16
@@ -3643,7 +3644,8 @@ int DkMosaicDialog::computeMosaic(const QString& filter, const QString& suffix,
 	DkTimer dt;
 
 	// compute new image size
-	cv::Mat mImg = DkImage::qImage2Mat(mLoader.image());
+	DkMatView view(mLoader.image(), false);
+	cv::Mat mImg = view.mat();
 
 	QSize numPatches = QSize(numPatchesH, 0);
 
@@ -3898,8 +3900,9 @@ cv::Mat DkMosaicDialog::createPatch(const DkThumbNail& thumb, int patchRes) {
 	else
 		img = thumb.getImage();
 
-	cv::Mat cvThumb = DkImage::qImage2Mat(img);
-	cv::cvtColor(cvThumb, cvThumb, CV_RGB2Lab);
+	// the thumbnail is shared - don't convert it in place
+	cv::Mat cvThumb;
+	cv::cvtColor(DkMatView(img, false).mat(), cvThumb, CV_RGB2Lab);
 	std::vector<cv::Mat> channels;
 	cv::split(cvThumb, channels);
 	cvThumb = channels[0];
@@ -4457,20 +4460,12 @@ void DkArchiveExtractionDialog::loadArchive(const QString& filePath) {
 
 	QStringList fileNameList = JlCompress::getFileList(lFilePath);
 	
-	// remove the * in fileFilters
-	QStringList fileFiltersClean = Settings::param().app().browseFilters;
-	for (int idx = 0; idx < fileFiltersClean.size(); idx++)
-		fileFiltersClean[idx].replace("*", "");
+	DkSuffixFilter filter(Settings::param().app().browseFilters);
 
-	for (int idx = 0; idx < fileNameList.size(); idx++) {
+	for (const QString& fileName : fileNameList) {
 		
-		for (int idxFilter = 0; idxFilter < fileFiltersClean.size(); idxFilter++) {
-
-			if (fileNameList.at(idx).contains(fileFiltersClean[idxFilter], Qt::CaseInsensitive)) {
-				mFileList.append(fileNameList.at(idx));
-				break;
-			}
-		}
+		if (filter.matches(fileName))
+			mFileList.append(fileName);
 	}
 
 	if (mFileList.size() > 0)
@@ -84,68 +84,35 @@ void DkMetaDataModel::addMetaData(QSharedPointer<DkMetaDataT> metaData) {
 	if (!metaData)
 		return;
 
-	DkTimer dt;
-	QStringList fileKeys, fileValues;
-	metaData->getFileMetaData(fileKeys, fileValues);
-
-	for (int idx = 0; idx < fileKeys.size(); idx++) {
-
-		QString lastKey = fileKeys.at(idx).split(".").last();
-		createItem(fileKeys.at(idx), lastKey, fileValues.at(idx));
-	}
-
-	QStringList exifKeys = metaData->getExifKeys();
-
-	for (int idx = 0; idx < exifKeys.size(); idx++) {
-		
-		QString lastKey = exifKeys.at(idx).split(".").last();
-		QString translatedKey = DkMetaDataHelper::getInstance().translateKey(lastKey);
-		QString exifValue = metaData->getNativeExifValue(exifKeys.at(idx));
-		exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
-
-		createItem(exifKeys.at(idx), translatedKey, exifValue);
-	}
-
-	QStringList iptcKeys = metaData->getIptcKeys();
-
-	for (int idx = 0; idx < iptcKeys.size(); idx++) {
-
-		QString lastKey = iptcKeys.at(idx).split(".").last();
-		QString translatedKey = DkMetaDataHelper::getInstance().translateKey(lastKey);
-		QString exifValue = metaData->getIptcValue(iptcKeys.at(idx));
-		exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
+	setEntries(DkMetaDataHelper::getInstance().resolveEntries(metaData));
+}
 
-		createItem(iptcKeys.at(idx), translatedKey, exifValue);
-	}
+/**
+ * Updates the model with resolved metadata entries.
+ * The new entries are diffed against the current tree so that views keep
+ * their state (e.g. expanded items) and only changed rows are updated.
+ * @param entries the metadata entries (see DkImageContainerT::metaDataEntries())
+ **/ 
+void DkMetaDataModel::setEntries(const QVector<DkMetaDataEntry>& entries) {
 
-	QStringList xmpKeys = metaData->getXmpKeys();
+	DkTimer dt;
 
-	for (int idx = 0; idx < xmpKeys.size(); idx++) {
+	TreeItem* newRoot = new TreeItem(QVector<QVariant>());
+	QHash<QString, TreeItem*> groups;
 
-		QString lastKey = xmpKeys.at(idx).split(".").last();
-		QString translatedKey = DkMetaDataHelper::getInstance().translateKey(lastKey);
-		QString exifValue = metaData->getXmpValue(xmpKeys.at(idx));
-		exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
+	for (const DkMetaDataEntry& e : entries) {
 
-		createItem(xmpKeys.at(idx), translatedKey, exifValue);
+		QString key = (e.type == DkMetaDataEntry::entry_qt) ? tr("Data.") + e.key : e.key;
+		createItem(newRoot, groups, key, e.name, e.displayValue);
 	}
 
-	QStringList qtKeys = metaData->getQtKeys();
-
-	for (QString cKey : qtKeys) {
-
-		QString lastKey = cKey.split(".").last();
-		QString translatedKey = DkMetaDataHelper::getInstance().translateKey(lastKey);
-		QString exifValue = metaData->getQtValue(cKey);
-		exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
-
-		createItem(tr("Data.") + cKey, translatedKey, exifValue);
-	}
+	syncItems(rootItem, newRoot);
+	delete newRoot;
 
 	qDebug() << "model refreshed in: " << dt.getTotal();
 }
 
-void DkMetaDataModel::createItem(const QString& key, const QString& keyName, const QString& value) {
+void DkMetaDataModel::createItem(TreeItem* root, QHash<QString, TreeItem*>& groups, const QString& key, const QString& keyName, const QVariant& value) {
 
 	// Split key first
 	QStringList keyHierarchy = key.split('.');
@@ -155,38 +122,103 @@ void DkMetaDataModel::createItem(const QString& key, const QString& keyName, con
 		return;
 	}
 
-	TreeItem* item = rootItem;
+	TreeItem* item = root;
+	QString groupKey;
 
 	for (int idx = 0; idx < keyHierarchy.size()-1; idx++) {
 
 		QString cKey = keyHierarchy.at(idx);
-		TreeItem* cHierarchyItem = item->find(cKey, 0);
+		groupKey += cKey + ".";
+		TreeItem* cHierarchyItem = groups.value(groupKey);
 
 		if (!cHierarchyItem) {
 			QVector<QVariant> keyData;
 			keyData << cKey;
 			cHierarchyItem = new TreeItem(keyData, item);
 			item->appendChild(cHierarchyItem);
+			groups.insert(groupKey, cHierarchyItem);
 		}
 
 		item = cHierarchyItem;	// switch to next hierarchy level
 	}
 
-	QString cleanValue = DkUtils::cleanFraction(value);
-	
 	QVector<QVariant> metaDataEntry;
-	metaDataEntry << keyName;
-
-	QDateTime pd = DkUtils::getConvertableDate(cleanValue);
-
-	if (!pd.isNull())
-		metaDataEntry << pd;
-	else
-		metaDataEntry << cleanValue;
+	metaDataEntry << keyName << value;
 
 	TreeItem* dataItem = new TreeItem(metaDataEntry, item);
 	item->appendChild(dataItem);
+}
+
+/**
+ * Applies the children of newItem to item.
+ * Matching rows are kept (values are updated), outdated rows are removed and new rows inserted.
+ * The children of newItem are consumed.
+ * @param item an item of the model's tree
+ * @param newItem the corresponding item of the new tree
+ **/ 
+void DkMetaDataModel::syncItems(TreeItem* item, TreeItem* newItem) {
+
+	QModelIndex parentIndex = (item == rootItem) ? QModelIndex() : createIndex(item->row(), 0, item);
+
+	// count the rows that can still be matched
+	QHash<QString, int> remaining;
+	for (int idx = 0; idx < item->childCount(); idx++)
+		remaining[itemKey(item->child(idx))]++;
+
+	int row = 0;
+
+	while (newItem->childCount() > 0) {
+
+		TreeItem* newChild = newItem->takeChild(0);
+		QString key = itemKey(newChild);
+
+		if (remaining.value(key) > 0) {
+
+			// remove outdated rows until we find the matching one
+			while (itemKey(item->child(row)) != key) {
+				remaining[itemKey(item->child(row))]--;
+				beginRemoveRows(parentIndex, row, row);
+				delete item->takeChild(row);
+				endRemoveRows();
+			}
+			remaining[key]--;
+
+			TreeItem* child = item->child(row);
+
+			if (newChild->childCount() > 0 || !newChild->data(1).isValid())
+				syncItems(child, newChild);
+			else if (child->data(1) != newChild->data(1)) {
+				child->setData(newChild->data(1), 1);
+				QModelIndex vIdx = createIndex(row, 1, child);
+				emit dataChanged(vIdx, vIdx);
+			}
+
+			delete newChild;
+		}
+		else {
+			beginInsertRows(parentIndex, row, row);
+			item->insertChild(row, newChild);
+			endInsertRows();
+		}
+
+		row++;
+	}
+
+	if (row < item->childCount()) {
+		beginRemoveRows(parentIndex, row, item->childCount()-1);
+		while (item->childCount() > row)
+			delete item->takeChild(row);
+		endRemoveRows();
+	}
+}
+
+QString DkMetaDataModel::itemKey(TreeItem* item) const {
+
+	// groups have no value
+	if (!item->data(1).isValid())
+		return item->data(0).toString() + ".";
 
+	return item->data(0).toString();
 }
 
 QModelIndex DkMetaDataModel::index(int row, int column, const QModelIndex &parent) const {
@@ -406,12 +438,13 @@ void DkMetaDataDock::updateEntries() {
 	for (int idx = 0; idx < numRows; idx++)
 		getExpandedItemNames(mModel->index(idx,0,QModelIndex()), mExpandedNames);
 
-	mModel->clear();
-
-	if (!mImgC)
+	if (!mImgC) {
+		mModel->clear();
 		return;
+	}
 
-	mModel->addMetaData(mImgC->getMetaData());
+	// the entries are resolved while loading - we just apply the differences
+	mModel->setEntries(mImgC->metaDataEntries());
 	
 	mTreeView->setUpdatesEnabled(false);
 	numRows = mModel->rowCount(QModelIndex());
@@ -812,6 +845,8 @@ QStringList DkMetaDataHUD::getDefaultKeys() const {
 
 void DkMetaDataHUD::updateMetaData(const QSharedPointer<DkImageContainerT> cImg) {
 
+	mImgC = cImg;
+
 	if (cImg) {
 		mMetaData = cImg->getMetaData();
 		
@@ -825,16 +860,17 @@ void DkMetaDataHUD::updateMetaData(const QSharedPointer<DkImageContainerT> cImg)
 
 void DkMetaDataHUD::updateMetaData(const QSharedPointer<DkMetaDataT> metaData) {
 
-	// clean up
-	for (QLabel* cLabel : mEntryKeyLabels)
-		delete cLabel;
-	for (QLabel* cLabel : mEntryValueLabels)
-		delete cLabel;
+	if (!metaData) {
 
-	mEntryKeyLabels.clear();
-	mEntryValueLabels.clear();
+		// clean up
+		for (QLabel* cLabel : mEntryKeyLabels)
+			delete cLabel;
+		for (QLabel* cLabel : mEntryValueLabels)
+			delete cLabel;
 
-	if (!metaData) {
+		mEntryKeyLabels.clear();
+		mEntryValueLabels.clear();
+		mEntryKeys.clear();
 
 		// create dummy entries
 		for (QString cKey : mKeyValues) {
@@ -845,85 +881,52 @@ void DkMetaDataHUD::updateMetaData(const QSharedPointer<DkMetaDataT> metaData) {
 
 	DkTimer dt;
 
-	QStringList fileKeys, fileValues;
-	metaData->getFileMetaData(fileKeys, fileValues);
-
-	for (int idx = 0; idx < fileKeys.size(); idx++) {
-
-		QString cKey = fileKeys.at(idx);
-		if (mKeyValues.contains(cKey)) {
-			mEntryKeyLabels.append(createKeyLabel(cKey));
-			mEntryValueLabels.append(createValueLabel(fileValues.at(idx)));
-		}
-	}
-
-	QStringList exifKeys = metaData->getExifKeys();
-
-	for (int idx = 0; idx < exifKeys.size(); idx++) {
+	// the container resolves its entries while loading
+	QVector<DkMetaDataEntry> entries = (mImgC && mImgC->getMetaData() == metaData) ? 
+		mImgC->metaDataEntries() : 
+		DkMetaDataHelper::getInstance().resolveEntries(metaData);
 
-		QString cKey = exifKeys.at(idx);
+	QStringList keys;
+	QStringList values;
 
-		if (mKeyValues.contains(cKey)) {
-			QString lastKey = cKey.split(".").last();
-			QString exifValue = metaData->getNativeExifValue(exifKeys.at(idx));
-			exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
+	for (const DkMetaDataEntry& e : entries) {
 
-			mEntryKeyLabels.append(createKeyLabel(cKey));
-			mEntryValueLabels.append(createValueLabel(exifValue));
-		}
-	}
-
-	QStringList iptcKeys = metaData->getIptcKeys();
-
-	for (int idx = 0; idx < iptcKeys.size(); idx++) {
-
-		QString cKey = iptcKeys.at(idx);
-
-		if (mKeyValues.contains(cKey)) {
-
-			QString lastKey = iptcKeys.at(idx).split(".").last();
-			QString exifValue = metaData->getIptcValue(iptcKeys.at(idx));
-			exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
-
-			mEntryKeyLabels.append(createKeyLabel(cKey));
-			mEntryValueLabels.append(createValueLabel(exifValue));
+		if (mKeyValues.contains(e.key)) {
+			keys << e.key;
+			values << valueLabelText(e);
 		}
 	}
 
-	QStringList xmpKeys = metaData->getXmpKeys();
-
-	for (int idx = 0; idx < xmpKeys.size(); idx++) {
-
-		QString cKey = xmpKeys.at(idx);
+	// just update the values if the same keys are shown
+	if (keys == mEntryKeys && mEntryValueLabels.size() == values.size()) {
 
-		if (mKeyValues.contains(cKey)) {
-
-			QString lastKey = xmpKeys.at(idx).split(".").last();
-			QString exifValue = metaData->getXmpValue(xmpKeys.at(idx));
-			exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
-
-			mEntryKeyLabels.append(createKeyLabel(cKey));
-			mEntryValueLabels.append(createValueLabel(exifValue));
+		for (int idx = 0; idx < values.size(); idx++) {
+			if (mEntryValueLabels.at(idx)->text() != values.at(idx))
+				mEntryValueLabels.at(idx)->setText(values.at(idx));
 		}
+		return;
 	}
 
-	QStringList qtKeys = metaData->getQtKeys();
-
-	for (int idx = 0; idx < qtKeys.size(); idx++) {
-
-		QString cKey = qtKeys.at(idx);
+	// recycle the labels
+	while (mEntryKeyLabels.size() > keys.size())
+		delete mEntryKeyLabels.takeLast();
+	while (mEntryValueLabels.size() > keys.size())
+		delete mEntryValueLabels.takeLast();
 
-		if (mKeyValues.contains(cKey)) {
+	for (int idx = 0; idx < keys.size(); idx++) {
 
-			QString lastKey = cKey.split(".").last();
-			QString exifValue = metaData->getQtValue(cKey);
-			exifValue = DkMetaDataHelper::getInstance().resolveSpecialValue(metaData, lastKey, exifValue);
+		if (idx < mEntryKeyLabels.size())
+			mEntryKeyLabels.at(idx)->setText(keyLabelText(keys.at(idx)));
+		else
+			mEntryKeyLabels.append(createKeyLabel(keys.at(idx)));
 
-			mEntryKeyLabels.append(createKeyLabel(cKey));
-			mEntryValueLabels.append(createValueLabel(exifValue));
-		}
+		if (idx < mEntryValueLabels.size())
+			mEntryValueLabels.at(idx)->setText(values.at(idx));
+		else
+			mEntryValueLabels.append(createValueLabel(values.at(idx)));
 	}
 
+	mEntryKeys = keys;
 
 	updateLabels();
 }
@@ -994,11 +997,23 @@ void DkMetaDataHUD::updateLabels(int numColumns /* = -1 */) {
 	// decrease it's size
 }
 
-QLabel* DkMetaDataHUD::createKeyLabel(const QString& key) {
+QString DkMetaDataHUD::keyLabelText(const QString& key) const {
 
 	QString labelString = key.split(".").last();
-	labelString = DkMetaDataHelper::getInstance().translateKey(labelString);
-	QLabel* keyLabel = new QLabel(labelString, this);
+	return DkMetaDataHelper::getInstance().translateKey(labelString);
+}
+
+QString DkMetaDataHUD::valueLabelText(const DkMetaDataEntry& entry) const {
+
+	if (entry.displayValue.type() == QVariant::DateTime)
+		return entry.displayValue.toDateTime().toString(Qt::SystemLocaleShortDate);
+
+	return entry.displayValue.toString().trimmed();
+}
+
+QLabel* DkMetaDataHUD::createKeyLabel(const QString& key) {
+
+	QLabel* keyLabel = new QLabel(keyLabelText(key), this);
 	keyLabel->setObjectName("DkMetaDataKeyLabel");
 	keyLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
 	keyLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
@@ -1008,13 +1023,7 @@ QLabel* DkMetaDataHUD::createKeyLabel(const QString& key) {
 
 QLabel* DkMetaDataHUD::createValueLabel(const QString& val) {
 
-	QString cleanValue = DkUtils::cleanFraction(val);
-	QDateTime pd = DkUtils::getConvertableDate(cleanValue);
-
-	if (!pd.isNull())
-		cleanValue = pd.toString(Qt::SystemLocaleShortDate);
-
-	QLabel* valLabel = new QLabel(cleanValue.trimmed(), this);
+	QLabel* valLabel = new QLabel(val, this);
 	valLabel->setObjectName("DkMetaDataLabel");
 	valLabel->setAlignment(Qt::AlignLeft | Qt::AlignVCenter);
 	valLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
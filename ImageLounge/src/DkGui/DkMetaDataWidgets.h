@@ -48,6 +48,7 @@ namespace nmc {
 
 // nomacs defines
 class TreeItem;
+class DkMetaDataEntry;
 
 class DkMetaDataModel : public QAbstractItemModel {
 	Q_OBJECT
@@ -69,12 +70,15 @@ public:
 	//virtual bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole);
 
 	virtual void addMetaData(QSharedPointer<DkMetaDataT> metaData);
+	void setEntries(const QVector<DkMetaDataEntry>& entries);
 	void clear();
 
 protected:
 	TreeItem* rootItem;
 
-	void createItem(const QString& key, const QString& keyName, const QString& value);
+	void createItem(TreeItem* root, QHash<QString, TreeItem*>& groups, const QString& key, const QString& keyName, const QVariant& value);
+	void syncItems(TreeItem* item, TreeItem* newItem);
+	QString itemKey(TreeItem* item) const;
 };
 
 class DkMetaDataDock : public DkDockWidget {
@@ -178,12 +182,16 @@ protected:
 	QStringList getDefaultKeys() const;
 	QLabel* createKeyLabel(const QString& key);
 	QLabel* createValueLabel(const QString& val);
+	QString keyLabelText(const QString& key) const;
+	QString valueLabelText(const DkMetaDataEntry& entry) const;
 
 	void contextMenuEvent(QContextMenuEvent *event);
 
 	// current metadata
 	QSharedPointer<DkMetaDataT> mMetaData;
+	QSharedPointer<DkImageContainerT> mImgC;
 	QStringList mKeyValues;
+	QStringList mEntryKeys;		// keys currently shown
 
 	// gui elements
 	QVector<QLabel*> mEntryKeyLabels;
@@ -37,6 +37,9 @@
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDataStream>
 #include <QStringBuilder>
 #include <QDir>
 #include <QNetworkInterface>
@@ -251,6 +254,11 @@ void DkClientManager::sendGoodByeToAll() {
 DkLocalClientManager::DkLocalClientManager(const QString& title, QObject* parent ) : DkClientManager(title, parent) {
 	server = new DkLocalTcpServer(this);
 	connect(server, SIGNAL(serverReiceivedNewConnection(int)), this, SLOT(newConnection(int)));
+
+	mSharedImageTimer = new QTimer(this);
+	mSharedImageTimer->setInterval(500);
+	connect(mSharedImageTimer, SIGNAL(timeout()), this, SLOT(releaseSharedImages()));
+
 	searchForOtherClients();
 	//QFuture<void> future = QtConcurrent::run(this, &DkLocalClientManager::searchForOtherClients);
 }
@@ -422,6 +430,59 @@ void DkLocalClientManager::connectionReceivedQuit() {
 	emit receivedQuit();
 }
 
+/**
+ * Shares the image with all synchronized local instances.
+ * The pixels are copied once into shared memory - no encoding is needed.
+ * @param image the image to be shared
+ * @param title the image title
+ **/ 
+void DkLocalClientManager::sendNewImage(QImage image, const QString& title) {
+
+	QList<DkLocalConnection*> receivers;
+
+	foreach (DkPeer* peer, mPeerList.getSynchronizedPeers()) {
+		
+		DkLocalConnection* con = peer ? dynamic_cast<DkLocalConnection*>(peer->connection) : 0;
+
+		if (con && con->canReceiveSharedImages())
+			receivers.append(con);
+	}
+
+	if (receivers.empty())
+		return;
+
+	DkTimer dt;
+	QSharedPointer<DkSharedImage> sharedImg(new DkSharedImage(image, receivers.size()));
+
+	if (!sharedImg->isValid())
+		return;
+
+	for (DkLocalConnection* con : receivers)
+		con->sendSharedImageMessage(sharedImg->key(), title);
+
+	mSharedImages.append(sharedImg);
+	mSharedImageTimer->start();
+
+	qDebug() << "[DkLocalClientManager] image shared with" << receivers.size() << "peers in" << dt.getTotal();
+}
+
+void DkLocalClientManager::releaseSharedImages() {
+
+	for (int idx = mSharedImages.size()-1; idx >= 0; idx--) {
+		if (mSharedImages.at(idx)->isReleased())
+			mSharedImages.removeAt(idx);
+	}
+
+	if (mSharedImages.empty())
+		mSharedImageTimer->stop();
+}
+
+void DkLocalClientManager::connectionReceivedNewImage(DkConnection*, const QImage& image, const QString& title) {
+	
+	emit receivedImage(image);
+	emit receivedImageTitle(title + " - ");
+}
+
 DkLocalConnection* DkLocalClientManager::createConnection() {
 
 	//qDebug() << "SERVER server port: " << server->serverPort();
@@ -432,6 +493,7 @@ DkLocalConnection* DkLocalClientManager::createConnection() {
 	connect(this, SIGNAL(synchronizedPeersListChanged(QList<quint16>)), connection, SLOT(synchronizedPeersListChanged(QList<quint16>)));
 	connect(this, SIGNAL(sendQuitMessage()), connection, SLOT(sendQuitMessage()));
 	connect(connection, SIGNAL(connectionQuitReceived()), this, SLOT(connectionReceivedQuit()));
+	connect(connection, SIGNAL(connectionNewImage(DkConnection*, const QImage&, const QString&)), this, SLOT(connectionReceivedNewImage(DkConnection*, const QImage&, const QString&)));
 	return connection;
 
 }
@@ -2069,6 +2131,11 @@ void DkLocalManagerThread::connectClient() {
 	
 	// this connection to parent is only needed for the local client (synchronize all instances)
 	connect(parent, SIGNAL(synchronizeWithSignal(quint16)), clientManager, SLOT(synchronizeWith(quint16)));
+
+	// images are handed over via shared memory
+	connect(parent->viewport(), SIGNAL(sendImageSignal(QImage, const QString&)), clientManager, SLOT(sendNewImage(QImage, const QString&)));
+	connect(clientManager, SIGNAL(receivedImage(QImage)), parent->viewport(), SLOT(loadImage(QImage)));
+	connect(clientManager, SIGNAL(receivedImageTitle(const QString&)), parent, SLOT(setWindowTitle(const QString&)));
 	DkManagerThread::connectClient();
 }
 
@@ -2163,4 +2230,108 @@ void DkRCManagerThread::sendNewMode(int mode) {
 	newModeSignal(mode);
 }
 
+// DkInstanceServer --------------------------------------------------------------------
+DkInstanceServer::DkInstanceServer(QObject* parent) : QObject(parent) {
+
+	mServer = new QLocalServer(this);
+	connect(mServer, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+/**
+ * Starts listening for files of new nomacs instances.
+ * @return bool false if another instance is listening already.
+ **/
+bool DkInstanceServer::listen() {
+
+	if (mServer->isListening())
+		return true;
+
+	// don't steal the socket of another instance
+	QLocalSocket socket;
+	socket.connectToServer(serverName());
+	if (socket.waitForConnected(timeout_ms)) {
+		socket.disconnectFromServer();
+		qDebug() << "[DkInstanceServer] another instance is running already";
+		return false;
+	}
+
+	// remove stale sockets (e.g. if nomacs crashed)
+	QLocalServer::removeServer(serverName());
+
+	if (!mServer->listen(serverName())) {
+		qWarning() << "[DkInstanceServer] cannot listen:" << mServer->errorString();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Sends files to a running nomacs.
+ * @param filePaths the absolute file paths.
+ * @return bool true if a running instance received the files.
+ **/
+bool DkInstanceServer::sendFiles(const QStringList& filePaths) {
+
+	QLocalSocket socket;
+	socket.connectToServer(serverName());
+
+	if (!socket.waitForConnected(timeout_ms))
+		return false;
+
+	QByteArray ba;
+	QDataStream ds(&ba, QIODevice::WriteOnly);
+	ds << filePaths;
+
+	socket.write(ba);
+	bool sent = socket.waitForBytesWritten(timeout_ms);
+	socket.disconnectFromServer();
+
+	if (socket.state() != QLocalSocket::UnconnectedState)
+		socket.waitForDisconnected(timeout_ms);
+
+	return sent;
+}
+
+/**
+ * The socket name is unique per user.
+ * @return QString the name of the local socket.
+ **/
+QString DkInstanceServer::serverName() {
+
+	return "nomacs-" + QString::number(qHash(QDir::homePath()), 16);
+}
+
+void DkInstanceServer::newConnection() {
+
+	while (mServer->hasPendingConnections()) {
+
+		QLocalSocket* socket = mServer->nextPendingConnection();
+		
+		// the files are complete once the client disconnects
+		connect(socket, SIGNAL(disconnected()), this, SLOT(readFiles()));
+		connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+	}
+}
+
+void DkInstanceServer::readFiles() {
+
+	QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+
+	if (!socket)
+		return;
+
+	QStringList filePaths;
+	QDataStream ds(socket->readAll());
+	ds >> filePaths;
+
+	if (ds.status() != QDataStream::Ok || filePaths.empty()) {
+		qWarning() << "[DkInstanceServer] illegal message received";
+		return;
+	}
+
+	qDebug() << "[DkInstanceServer] received:" << filePaths;
+	emit loadFilesSignal(filePaths);
+}
+
 }
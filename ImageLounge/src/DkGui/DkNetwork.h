@@ -36,6 +36,7 @@
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QTcpServer>
 #include <QUdpSocket>
+#include <QStringList>
 #include <QNetworkReply>
 #include <QThread>
 #include <QMutex>
@@ -45,6 +46,8 @@
 #include "DkConnection.h"
 
 class QXmlStreamReader;
+class QLocalServer;
+class QLocalSocket;
 
 namespace nmc {
 
@@ -204,17 +207,22 @@ class DkLocalClientManager : public DkClientManager {
 		void synchronizeWith(quint16 peerId);
 		void sendArrangeInstances(bool overlaid);
 		void sendQuitMessageToPeers();
+		void sendNewImage(QImage image, const QString& title);
 
 	private slots:
 		void connectionSynchronized(QList<quint16> synchronizedPeersOfOtherClient, DkConnection* connection);
 		virtual void connectionStopSynchronized(DkConnection* connection);
 		void connectionReceivedQuit(); 
+		void connectionReceivedNewImage(DkConnection* connection, const QImage& image, const QString& title);
+		void releaseSharedImages();
 
 	private:
 		DkLocalConnection* createConnection();
 		void searchForOtherClients();
 
 		DkLocalTcpServer* server;
+		QTimer* mSharedImageTimer;
+		QList<QSharedPointer<DkSharedImage> > mSharedImages;	// images waiting for the receivers
 };
 
 
@@ -486,6 +494,37 @@ protected:
 
 };
 
+/**
+ * Hands files to an already running nomacs (single instance mode).
+ * The running instance listens on a local socket, new instances
+ * send their files with sendFiles() and exit.
+ **/
+class DllGuiExport DkInstanceServer : public QObject {
+	Q_OBJECT
+
+public:
+	DkInstanceServer(QObject* parent = 0);
+
+	bool listen();
+
+	static bool sendFiles(const QStringList& filePaths);
+	static QString serverName();
+
+	enum {
+		timeout_ms = 1000,
+	};
+
+signals:
+	void loadFilesSignal(const QStringList& filePaths) const;
+
+protected slots:
+	void newConnection();
+	void readFiles();
+
+protected:
+	QLocalServer* mServer = 0;
+};
+
 class DkPackage {
 
 public:
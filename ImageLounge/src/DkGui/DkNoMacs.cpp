@@ -112,6 +112,8 @@ bool DkNomacsOSXEventFilter::eventFilter(QObject *obj, QEvent *event) {
 DkNoMacs::DkNoMacs(QWidget *parent, Qt::WindowFlags flags)
 	: QMainWindow(parent, flags) {
 
+	mStartupTimer.start();
+
 	QMainWindow::setWindowTitle("nomacs | Image Lounge");
 	setObjectName("DkNoMacs");
 
@@ -177,6 +179,8 @@ void DkNoMacs::release() {
 
 void DkNoMacs::init() {
 
+	DK_TRACE("startup", "init ui");
+
 // assign icon -> in windows the 32px version
 	QString iconPath = ":/nomacs/img/nomacs.svg";
 	loadStyleSheet();
@@ -794,6 +798,7 @@ void DkNoMacs::flipImageHorizontal() {
 		return;
 
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	QImage img = vp->getImage();
 	img = img.mirrored(true, false);
@@ -812,6 +817,7 @@ void DkNoMacs::flipImageVertical() {
 		return;
 
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	QImage img = vp->getImage();
 	img = img.mirrored(false, true);
@@ -831,6 +837,7 @@ void DkNoMacs::invertImage() {
 		return;
 
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	QImage img = vp->getImage();
 	img.invertPixels();
@@ -850,6 +857,7 @@ void DkNoMacs::convert2gray() {
 		return;
 
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	QImage img = vp->getImage();
 
@@ -873,15 +881,21 @@ void DkNoMacs::normalizeImage() {
 		return;
 
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	QImage img = vp->getImage();
+	QSharedPointer<DkImageContainerT> imgC = vp->imageContainer();
+	DkImageHistogram hist = (imgC && imgC->hasHistogram(img)) ? imgC->histogram() : DkImageHistogram();
 	
-	bool normalized = DkImage::normImage(img);
+	bool normalized = DkImage::normImage(img, &hist);
 
 	if (!normalized || img.isNull())
 		vp->getController()->setInfo(tr("The Image is Already Normalized..."));
-	else
+	else {
+		if (imgC && !hist.isEmpty())
+			imgC->setHistogram(hist, img);	// the histogram is remapped - no need to compute it again
 		vp->setEditedImage(img, tr("Normalized"));
+	}
 }
 
 void DkNoMacs::autoAdjustImage() {
@@ -892,20 +906,27 @@ void DkNoMacs::autoAdjustImage() {
 		return;
 
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	QImage img = vp->getImage();
+	QSharedPointer<DkImageContainerT> imgC = vp->imageContainer();
+	DkImageHistogram hist = (imgC && imgC->hasHistogram(img)) ? imgC->histogram() : DkImageHistogram();
 
-	bool normalized = DkImage::autoAdjustImage(img);
+	bool normalized = DkImage::autoAdjustImage(img, &hist);
 
 	if (!normalized || img.isNull())
 		vp->getController()->setInfo(tr("Sorry, I cannot Auto Adjust"));
-	else
+	else {
+		if (imgC && !hist.isEmpty())
+			imgC->setHistogram(hist, img);	// empty if it was not remapped (e.g. indexed images)
 		vp->setEditedImage(img, tr("Auto Adjust"));
+	}
 }
 
 void DkNoMacs::unsharpMask() {
 #ifdef WITH_OPENCV
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	DkUnsharpDialog* unsharpDialog = new DkUnsharpDialog(this);
 	unsharpDialog->setImage(viewport()->getImage());
@@ -924,6 +945,7 @@ void DkNoMacs::tinyPlanet() {
 #ifdef WITH_OPENCV
 	
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	DkTinyPlanetDialog* tinyPlanetDialog = new DkTinyPlanetDialog(this);
 	tinyPlanetDialog->setImage(viewport()->getImage());
@@ -1681,15 +1703,19 @@ void DkNoMacs::saveFileAs(bool silent) {
 	qDebug() << "saving...";
 
 	// TODO: move to current image loader
-	if (getTabWidget()->getCurrentImageLoader())
+	if (getTabWidget()->getCurrentImageLoader()) {
+		getTabWidget()->getViewPort()->loadFullImage();
 		getTabWidget()->getCurrentImageLoader()->saveUserFileAs(getTabWidget()->getViewPort()->getImage(), silent);
+	}
 }
 
 void DkNoMacs::saveFileWeb() {
 
 	// TODO: move to current image loader
-	if (getTabWidget()->getCurrentImageLoader())
+	if (getTabWidget()->getCurrentImageLoader()) {
+		getTabWidget()->getViewPort()->loadFullImage();
 		getTabWidget()->getCurrentImageLoader()->saveFileWeb(getTabWidget()->getViewPort()->getImage());
+	}
 }
 
 void DkNoMacs::resizeImage() {
@@ -1698,6 +1724,7 @@ void DkNoMacs::resizeImage() {
 		return;
 
 	viewport()->getController()->applyPluginChanges(true);
+	viewport()->loadFullImage();
 
 	if (!mResizeDialog)
 		mResizeDialog = new DkResizeDialog(this);
@@ -1818,6 +1845,7 @@ void DkNoMacs::openImgManipulationDialog() {
 	else 
 		mImgManipulationDialog->resetValues();
 
+	viewport()->loadFullImage();
 	QImage tmpImg = viewport()->getImage();
 	mImgManipulationDialog->setImage(&tmpImg);
 
@@ -1841,6 +1869,7 @@ void DkNoMacs::setWallpaper() {
 
 	// based on code from: http://qtwiki.org/Set_windows_background_using_QT
 
+	viewport()->loadFullImage();
 	QImage img = viewport()->getImage();
 
 	QImage dImg = img;
@@ -1877,6 +1906,7 @@ void DkNoMacs::printDialog() {
 		res = imgC->getMetaData()->getResolution();
 
 	//QPrintPreviewDialog* previewDialog = new QPrintPreviewDialog();
+	viewport()->loadFullImage();
 	QImage img = viewport()->getImage();
 	if (!mPrintPreviewDialog)
 		mPrintPreviewDialog = new DkPrintPreviewDialog(img, (float)res.x(), 0, this);
@@ -2065,6 +2095,89 @@ void DkNoMacs::showRecentFiles(bool show) {
 
 void DkNoMacs::onWindowLoaded() {
 
+	// load settings AFTER everything is initialized
+	getTabWidget()->loadSettings();
+
+	initDeferred();
+}
+
+/**
+ * Fast start path: shows the image before the non-essential UI is created.
+ * Docks, the welcome dialog and the update check are created
+ * after the first image is loaded (see initDeferred).
+ * @param filePath the image (or directory) to load.
+ **/
+void DkNoMacs::startWithFile(const QString& filePath) {
+
+	// the tabs must be restored before the file is loaded (setTabList replaces all tabs)
+	getTabWidget()->loadSettings();
+
+	// queued so that the image gets painted before we continue
+	connect(getTabWidget(), SIGNAL(imageLoadedSignal(QSharedPointer<DkImageContainerT>)), this, SLOT(initDeferred()), Qt::QueuedConnection);
+
+	// fallback if the file cannot be loaded
+	QTimer::singleShot(3000, this, SLOT(initDeferred()));
+
+	loadFile(filePath);
+}
+
+/**
+ * Opens files of new nomacs instances in this window (single instance mode).
+ **/
+void DkNoMacs::startInstanceServer() {
+
+	if (!mInstanceServer)
+		mInstanceServer = new DkInstanceServer(this);
+
+	if (mInstanceServer->listen())
+		connect(mInstanceServer, SIGNAL(loadFilesSignal(const QStringList&)), this, SLOT(loadFilesFromInstance(const QStringList&)), Qt::UniqueConnection);
+}
+
+/**
+ * Loads files that were sent by another nomacs instance.
+ * The current tab is reused if it is empty, otherwise new tabs are added.
+ * @param filePaths the absolute file paths.
+ **/
+void DkNoMacs::loadFilesFromInstance(const QStringList& filePaths) {
+
+	for (const QString& filePath : filePaths) {
+
+		if (!getTabWidget()->getCurrentImage() || QFileInfo(filePath).isDir())
+			loadFile(filePath);
+		else
+			getTabWidget()->addTab(filePath);
+	}
+
+	// bring us to front
+	if (isMinimized())
+		showNormal();
+	raise();
+	activateWindow();
+}
+
+/**
+ * Creates the UI that is not needed to display the first image.
+ * This is called once - either by onWindowLoaded or after the
+ * first image was loaded in fast start mode.
+ **/
+void DkNoMacs::initDeferred() {
+
+	if (mDeferredInitDone)
+		return;
+
+	mDeferredInitDone = true;
+	disconnect(getTabWidget(), SIGNAL(imageLoadedSignal(QSharedPointer<DkImageContainerT>)), this, SLOT(initDeferred()));
+
+	qint64 firstImageUs = mStartupTimer.nsecsElapsed() / 1000;
+	if (DkTracer::isEnabled())
+		DkTracer::instance().addEvent("startup", "window to first image", DkTracer::instance().now() - firstImageUs, firstImageUs);
+
+	if (Settings::param().app().fastStart)
+		qDebug() << "[DkNoMacs] first image shown after" << firstImageUs / 1000 << "ms";
+
+	DK_TRACE("startup", "deferred ui");
+	DkTimer dt;
+
 	QSettings& settings = Settings::instance().getSettings();
 	bool firstTime = settings.value("AppSettings/firstTime.nomacs.3", true).toBool();
 
@@ -2088,9 +2201,7 @@ void DkNoMacs::onWindowLoaded() {
 
 	checkForUpdate(true);
 
-	// load settings AFTER everything is initialized
-	getTabWidget()->loadSettings();
-
+	qDebug() << "[DkNoMacs] deferred ui created in" << dt.getTotal();
 }
 
 void DkNoMacs::keyPressEvent(QKeyEvent *event) {
@@ -2927,6 +3038,15 @@ void DkNoMacsSync::startTCPServer(bool start) {
 	emit startTCPServerSignal(start);
 }
 
+void DkNoMacsSync::initDeferred() {
+
+	// the LAN client is not needed to show the first image
+	if (!mDeferredInitDone && Settings::param().app().fastStart)
+		initLanClient();
+
+	DkNoMacs::initDeferred();
+}
+
 void DkNoMacsSync::settingsChanged() {
 	initLanClient();
 
@@ -2977,7 +3097,8 @@ DkNoMacsIpl::DkNoMacsIpl(QWidget *parent, Qt::WindowFlags flags) : DkNoMacsSync(
 	connect(vp, SIGNAL(newClientConnectedSignal(bool, bool)), this, SLOT(newClientConnected(bool, bool)));
 
 	Settings::param().app().appMode = 0;
-	initLanClient();
+	if (!Settings::param().app().fastStart)
+		initLanClient();
 	//emit sendTitleSignal(windowTitle());
 	qDebug() << "LAN client created in: " << dt.getTotal();
 	// show it...
@@ -3168,7 +3289,8 @@ DkNoMacsContrast::DkNoMacsContrast(QWidget *parent, Qt::WindowFlags flags)
 		// sync signals
 		connect(vp, SIGNAL(newClientConnectedSignal(bool, bool)), this, SLOT(newClientConnected(bool, bool)));
 		
-		initLanClient();
+		if (!Settings::param().app().fastStart)
+			initLanClient();
 		emit sendTitleSignal(windowTitle());
 
 		Settings::param().app().appMode = DkSettings::mode_contrast;
@@ -33,6 +33,7 @@
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QMainWindow>
 #include <QProcess>
+#include <QElapsedTimer>
 #pragma warning(pop)		// no warnings from includes - end
 
 #include "DkImageContainer.h"
@@ -80,6 +81,7 @@ class DkImageManipulationDialog;
 class DkUpdater;
 class DkInstallUpdater;
 class DkTranslationUpdater;
+class DkInstanceServer;
 class DkLocalManagerThread;
 class DkLanManagerThread;
 class DkRCManagerThread;
@@ -149,6 +151,8 @@ public:
 	virtual DkCentralWidget* getTabWidget() const;
 	
 	void loadFile(const QString& filePath);
+	void startWithFile(const QString& filePath);
+	void startInstanceServer();
 
 	static void updateAll();
 
@@ -257,6 +261,8 @@ public slots:
 	// batch actions
 	void computeThumbsBatch();
 	void onWindowLoaded();
+	virtual void initDeferred();
+	void loadFilesFromInstance(const QStringList& filePaths);
 
 protected:
 	
@@ -325,12 +331,17 @@ protected:
 	DkInstallUpdater* mInstallUpdater = 0;
 	DkUpdater* mUpdater = 0;
 	DkTranslationUpdater* mTranslationUpdater = 0;	
+	DkInstanceServer* mInstanceServer = 0;
 
 	QRect mOldGeometry;
 	QList<QToolBar *> mHiddenToolbars;
 
 	QProcess mProcess;
 
+	// startup
+	QElapsedTimer mStartupTimer;
+	bool mDeferredInitDone = false;
+
 	// functions
 	DkNoMacs(QWidget *parent = 0, Qt::WindowFlags flags = 0);
 
@@ -376,6 +387,7 @@ public slots:
 	void newClientConnected(bool connected, bool local);
 	void startTCPServer(bool start);
 	virtual void enableNoImageActions(bool enable = true);
+	virtual void initDeferred();
 
 protected:
 
@@ -388,6 +388,11 @@ void DkGeneralPreference::createLayout() {
 	cbCloseOnEsc->setToolTip(tr("Close nomacs if ESC is pressed."));
 	cbCloseOnEsc->setChecked(Settings::param().app().closeOnEsc);
 
+	QCheckBox* cbSingleInstance = new QCheckBox(tr("Open Images in Running nomacs"), this);
+	cbSingleInstance->setObjectName("singleInstance");
+	cbSingleInstance->setToolTip(tr("If checked, images are opened in a new tab of the running nomacs instead of starting a new nomacs."));
+	cbSingleInstance->setChecked(Settings::param().app().singleInstance);
+
 	QCheckBox* cbCheckForUpdates = new QCheckBox(tr("Check For Updates"), this);
 	cbCheckForUpdates->setObjectName("checkForUpdates");
 	cbCheckForUpdates->setToolTip(tr("Check for updates on start-up."));
@@ -401,6 +406,7 @@ void DkGeneralPreference::createLayout() {
 	generalGroup->addWidget(cbSwitchModifier);
 	generalGroup->addWidget(cbEnableNetworkSync);
 	generalGroup->addWidget(cbCloseOnEsc);
+	generalGroup->addWidget(cbSingleInstance);
 	generalGroup->addWidget(cbCheckForUpdates);
 
 	// language
@@ -472,6 +478,12 @@ void DkGeneralPreference::on_closeOnEsc_toggled(bool checked) const {
 		Settings::param().app().closeOnEsc = checked;
 }
 
+void DkGeneralPreference::on_singleInstance_toggled(bool checked) const {
+
+	if (Settings::param().app().singleInstance != checked)
+		Settings::param().app().singleInstance = checked;
+}
+
 void DkGeneralPreference::on_zoomOnWheel_toggled(bool checked) const {
 
 	if (Settings::param().global().zoomOnWheel != checked) {
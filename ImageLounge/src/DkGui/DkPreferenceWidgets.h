@@ -149,6 +149,7 @@ public slots:
 	void on_showRecentFiles_toggled(bool checked) const;
 	void on_logRecentFiles_toggled(bool checked) const;
 	void on_closeOnEsc_toggled(bool checked) const;
+	void on_singleInstance_toggled(bool checked) const;
 	void on_zoomOnWheel_toggled(bool checked) const;
 	void on_checkForUpdates_toggled(bool checked) const;
 	void on_switchModifier_toggled(bool checked) const;
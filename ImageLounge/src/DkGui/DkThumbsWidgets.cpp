@@ -56,11 +56,27 @@
 #include <QMessageBox>
 #include <QInputDialog>
 #include <QMimeData>
+#include <algorithm>
 #pragma warning(pop)		// no warnings from includes - end
 
 namespace nmc {
 
 // DkFilePreview --------------------------------------------------------------------
+/**
+ * Returns the device pixel ratio of a widget (1 for Qt4).
+ **/ 
+static qreal stripPixelRatio(const QWidget* widget) {
+
+#if QT_VERSION >= 0x050600
+	return widget->devicePixelRatioF();
+#elif QT_VERSION >= 0x050000
+	return widget->devicePixelRatio();
+#else
+	Q_UNUSED(widget);
+	return 1.0;
+#endif
+}
+
 DkFilePreview::DkFilePreview(QWidget* parent, Qt::WindowFlags flags) : DkWidget(parent, flags) {
 
 	orientation = Qt::Horizontal;
@@ -93,6 +109,7 @@ void DkFilePreview::init() {
 	mouseTrace = 0;
 	scrollToCurrentImage = false;
 	isPainted = false;
+	mLayoutDirty = true;
 
 	winPercent = 0.1f;
 	borderTrigger = (orientation == Qt::Horizontal) ? (float)width()*winPercent : (float)height()*winPercent;
@@ -103,14 +120,6 @@ void DkFilePreview::init() {
 	moveImageTimer->setInterval(5);	// reduce cpu utilization
 	connect(moveImageTimer, SIGNAL(timeout()), this, SLOT(moveImages()));
 
-	int borderTriggerI = qRound(borderTrigger);
-	leftGradient = (orientation == Qt::Horizontal) ? QLinearGradient(QPoint(0, 0), QPoint(borderTriggerI, 0)) : QLinearGradient(QPoint(0, 0), QPoint(0, borderTriggerI));
-	rightGradient = (orientation == Qt::Horizontal) ? QLinearGradient(QPoint(width()-borderTriggerI, 0), QPoint(width(), 0)) : QLinearGradient(QPoint(0, height()-borderTriggerI), QPoint(0, height()));
-	leftGradient.setColorAt(1, Qt::white);
-	leftGradient.setColorAt(0, Qt::black);
-	rightGradient.setColorAt(1, Qt::black);
-	rightGradient.setColorAt(0, Qt::white);
-
 	minHeight = Settings::param().display().thumbSize + yOffset;
 	//resize(parent->width(), minHeight);
 	
@@ -142,9 +151,6 @@ void DkFilePreview::initOrientations() {
 		setMaximumSize(QWIDGETSIZE_MAX, minHeight);
 		setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
 		borderTrigger = (float)width()*winPercent;
-		int borderTriggerI = qRound(borderTrigger);
-		leftGradient = QLinearGradient(QPoint(0, 0), QPoint(borderTriggerI, 0));
-		rightGradient = QLinearGradient(QPoint(width()-borderTriggerI, 0), QPoint(width(), 0));
 	}
 	else {
 
@@ -152,15 +158,11 @@ void DkFilePreview::initOrientations() {
 		setMaximumSize(minHeight, QWIDGETSIZE_MAX);
 		setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
 		borderTrigger = (float)height()*winPercent;
-		int borderTriggerI = qRound(borderTrigger);
-		leftGradient = QLinearGradient(QPoint(0, 0), QPoint(0, borderTriggerI));
-		rightGradient = QLinearGradient(QPoint(0, height()-borderTriggerI), QPoint(0, height()));
 	}
 
-	leftGradient.setColorAt(1, Qt::white);
-	leftGradient.setColorAt(0, Qt::black);
-	rightGradient.setColorAt(1, Qt::black);
-	rightGradient.setColorAt(0, Qt::white);
+	mLayoutDirty = true;
+	mLeftFade = QImage();
+	mRightFade = QImage();
 
 	worldMatrix.reset();
 	currentDx = 0;
@@ -227,6 +229,7 @@ void DkFilePreview::paintEvent(QPaintEvent*) {
 		yOffset = qCeil(Settings::param().display().thumbSize*0.1f);
 
 		minHeight = Settings::param().display().thumbSize + yOffset;
+		mLayoutDirty = true;
 		
 		if (orientation == Qt::Horizontal)
 			setMaximumSize(QWIDGETSIZE_MAX, minHeight);
@@ -256,10 +259,8 @@ void DkFilePreview::paintEvent(QPaintEvent*) {
 	painter.setWorldTransform(worldMatrix);
 	painter.setWorldMatrixEnabled(true);
 
-	if (mThumbs.empty()) {
-		thumbRects.clear();
+	if (mThumbs.empty())
 		return;
-	}
 
 	painter.setRenderHint(QPainter::SmoothPixmapTransform);
 	drawThumbs(&painter);
@@ -275,103 +276,252 @@ void DkFilePreview::paintEvent(QPaintEvent*) {
 
 void DkFilePreview::drawThumbs(QPainter* painter) {
 
-	//qDebug() << "drawing thumbs: " << worldMatrix.dx();
+	if (mLayoutDirty || mThumbOffsets.size() != mThumbs.size()+1)
+		updateLayout();
 
-	bufferDim = (orientation == Qt::Horizontal) ? QRectF(QPointF(0, yOffset/2), QSize(xOffset, 0)) : QRectF(QPointF(yOffset/2, 0), QSize(0, xOffset));
-	thumbRects.clear();
+	int first, last;
+	visibleThumbs(first, last);
 
-	DkTimer dt;
+	// images that were opened change the layout (loaded thumbnails invalidate it - see thumbLoaded())
+	bool changed = currentFileIdx >= 0 && currentFileIdx < mThumbs.size() && thumbSize(currentFileIdx) != mThumbSizes.at(currentFileIdx);
 
-	// mouse over effect
-	QPoint p = worldMatrix.inverted().map(mapFromGlobal(QCursor::pos()));
+	for (int idx = first; idx <= last && !changed; idx++)
+		changed = thumbSize(idx) != mThumbSizes.at(idx);
 
-	for (int idx = 0; idx < mThumbs.size(); idx++) {
+	if (changed) {
+		updateLayout();
+		visibleThumbs(first, last);
+	}
+
+	// update file rect for move to current file timer
+	if (scrollToCurrentImage && currentFileIdx >= 0 && currentFileIdx < mThumbs.size())
+		newFileRect = worldMatrix.mapRect(thumbRect(currentFileIdx));
+
+	// render at device resolution - otherwise the strip is upscaled on HiDPI screens
+	qreal dpr = stripPixelRatio(this);
+	QSize bufferSize = size() * dpr;
+
+	if (mStripBuffer.size() != bufferSize) {
+		mStripBuffer = QImage(bufferSize, QImage::Format_ARGB32_Premultiplied);
+#if QT_VERSION >= 0x050000
+		mStripBuffer.setDevicePixelRatio(dpr);
+#endif
+	}
+	mStripBuffer.fill(Qt::transparent);
+
+	QPainter bp(&mStripBuffer);
+	bp.setRenderHints(painter->renderHints());
+	bp.setWorldTransform(worldMatrix);
+
+	for (int idx = first; idx <= last; idx++) {
+
+		QRectF r = thumbRect(idx);
+
+		if (r.isEmpty())
+			continue;
 
 		QSharedPointer<DkThumbNailT> thumb = mThumbs.at(idx)->getThumb();
-		QImage img;
-		
-		// if the image is loaded draw that (it might be edited)
-		if (mThumbs.at(idx)->hasImage()) {
-			img = mThumbs.at(idx)->image();
+
+		if (thumb->hasImage() == DkThumbNail::not_loaded && 
+			Settings::param().resources().numThumbsLoading < Settings::param().resources().maxThumbsLoading) {
+				thumb->fetchThumb();
 		}
-		else {
 
-			if (thumb->hasImage() == DkThumbNail::exists_not) {
-				thumbRects.push_back(QRectF());
-				continue;
-			}
+		QPixmap pm = thumbPixmap(idx, (r.size() * dpr).toSize());
+
+		if (!pm.isNull())
+			bp.drawPixmap(r, pm, QRectF(pm.rect()));
+		else 
+			drawNoImgEffect(&bp, r);
+	}
 
-			if (thumb->hasImage() == DkThumbNail::loaded)
-				img = thumb->getImage();
+	// show that there are more images...
+	bp.setWorldMatrixEnabled(false);
+	drawFadeOut(&bp);
+	bp.end();
+
+	painter->setWorldMatrixEnabled(false);
+	painter->drawImage(QPoint(), mStripBuffer);
+	painter->setWorldMatrixEnabled(true);
+
+	// mouse over effect
+	QPoint p = worldMatrix.inverted().map(mapFromGlobal(QCursor::pos()));
+
+	if (currentFileIdx >= first && currentFileIdx <= last && !thumbRect(currentFileIdx).isEmpty())
+		drawCurrentImgEffect(painter, thumbRect(currentFileIdx));
+	if (selected != currentFileIdx && selected >= first && selected <= last && thumbRect(selected).contains(p))
+		drawSelectedEffect(painter, thumbRect(selected));
+
+	// keep the pixmaps of the visible thumbnails and their neighbours only
+	int margin = last - first + 1;
+	if (mThumbPixmaps.size() > 3*margin) {
+
+		QMutableHashIterator<int, DkThumbPixmap> pIt(mThumbPixmaps);
+		while (pIt.hasNext()) {
+			pIt.next();
+			if (pIt.key() < first - margin || pIt.key() > last + margin)
+				pIt.remove();
 		}
+	}
+}
 
-		QPointF anchor = orientation == Qt::Horizontal ? bufferDim.topRight() : bufferDim.bottomLeft();
-		QRectF r = !img.isNull() ? QRectF(anchor, img.size()) : QRectF(anchor, QSize(Settings::param().display().thumbSize, Settings::param().display().thumbSize));
-		if (orientation == Qt::Horizontal && height()-yOffset < r.height()*2)
-			r.setSize(QSizeF(qFloor(r.width()*(float)(height()-yOffset)/r.height()), height()-yOffset));
-		else if (orientation == Qt::Vertical && width()-yOffset < r.width()*2)
-			r.setSize(QSizeF(width()-yOffset, qFloor(r.height()*(float)(width()-yOffset)/r.width())));
+/**
+ * Recomputes the position of all thumbnails.
+ * The strip positions are prefix sums of the thumbnail sizes,
+ * so painting and hit testing just need a binary search for the visible range.
+ **/
+void DkFilePreview::updateLayout() {
 
-		// check if the size is still valid
-		if (r.width() < 1 || r.height() < 1) 
-			continue;	// this brings us in serious problems with the selection
+	mThumbSizes.resize(mThumbs.size());
+	mThumbOffsets.resize(mThumbs.size()+1);
 
-		// center vertically
-		if (orientation == Qt::Horizontal)
-			r.moveCenter(QPoint(qFloor(r.center().x()), height()/2));
-		else
-			r.moveCenter(QPoint(width()/2, qFloor(r.center().y())));
+	int pos = xOffset;
+
+	for (int idx = 0; idx < mThumbs.size(); idx++) {
+
+		mThumbOffsets[idx] = pos;
+		mThumbSizes[idx] = thumbSize(idx);
+
+		if (mThumbSizes[idx].isEmpty())
+			continue;
 
-		// update the buffer dim
 		if (orientation == Qt::Horizontal)
-			bufferDim.setRight(qFloor(bufferDim.right() + r.width()) + qCeil(xOffset/2.0f));
+			pos += qFloor(mThumbSizes[idx].width()) + qCeil(xOffset/2.0f);
 		else
-			bufferDim.setBottom(qFloor(bufferDim.bottom() + r.height()) + qCeil(xOffset/2.0f));
-		thumbRects.push_back(r);
+			pos += qFloor(mThumbSizes[idx].height()) + qCeil(xOffset/2.0f);
+	}
+	mThumbOffsets[mThumbs.size()] = pos;
 
-		QRectF imgWorldRect = worldMatrix.mapRect(r);
+	bufferDim = (orientation == Qt::Horizontal) ? QRectF(QPointF(0, yOffset/2), QSize(xOffset, 0)) : QRectF(QPointF(yOffset/2, 0), QSize(0, xOffset));
+	if (orientation == Qt::Horizontal)
+		bufferDim.setRight(pos);
+	else
+		bufferDim.setBottom(pos);
 
-		// update file rect for move to current file timer
-		if (scrollToCurrentImage && idx == currentFileIdx)
-			newFileRect = imgWorldRect;
+	mLayoutDirty = false;
+}
 
-		// is the current image within the canvas?
-		if (orientation == Qt::Horizontal && imgWorldRect.right() < 0 || orientation == Qt::Vertical && imgWorldRect.bottom() < 0)
-			continue;
-		if ((orientation == Qt::Horizontal && imgWorldRect.left() > width() || orientation == Qt::Vertical && imgWorldRect.top() > height()) && scrollToCurrentImage) 
-			continue;
-		else if (orientation == Qt::Horizontal && imgWorldRect.left() > width() || orientation == Qt::Vertical && imgWorldRect.top() > height())
-			break;
+/**
+ * Returns the size of the thumbnail idx within the strip.
+ * @param idx the thumbnail's index
+ * @return QSizeF the thumbnail's size or an empty size if the thumbnail is not shown
+ **/
+QSizeF DkFilePreview::thumbSize(int idx) {
 
-		if (thumb->hasImage() == DkThumbNail::not_loaded && 
-			Settings::param().resources().numThumbsLoading < Settings::param().resources().maxThumbsLoading) {
-				thumb->fetchThumb();
-				connect(thumb.data(), SIGNAL(thumbLoadedSignal()), this, SLOT(update()));
-		}
+	QSharedPointer<DkThumbNailT> thumb = mThumbs.at(idx)->getThumb();
+	QSize s;
 
-		bool isLeftGradient = (orientation == Qt::Horizontal && worldMatrix.dx() < 0 && imgWorldRect.left() < leftGradient.finalStop().x()) ||
-			(orientation == Qt::Vertical && worldMatrix.dy() < 0 && imgWorldRect.top() < leftGradient.finalStop().y());
-		bool isRightGradient = orientation == Qt::Horizontal && imgWorldRect.right() > rightGradient.start().x() ||
-			orientation == Qt::Vertical && imgWorldRect.bottom() > rightGradient.start().y();
-		// show that there are more images...
-		if (isLeftGradient && !img.isNull())
-			drawFadeOut(leftGradient, imgWorldRect, &img);
-		if (isRightGradient && !img.isNull())
-			drawFadeOut(rightGradient, imgWorldRect, &img);
-
-		if (!img.isNull())
-			painter->drawImage(r, img, QRect(QPoint(), img.size()));
-		else 
-			drawNoImgEffect(painter, r);
-				
-		if (idx == currentFileIdx)
-			drawCurrentImgEffect(painter, r);
-		else if (idx == selected && r.contains(p))
-			drawSelectedEffect(painter, r);
+	// if the image is loaded draw that (it might be edited)
+	if (mThumbs.at(idx)->hasImage())
+		s = mThumbs.at(idx)->image().size();
+	else if (thumb->hasImage() == DkThumbNail::exists_not)
+		return QSizeF();
+	else if (thumb->hasImage() == DkThumbNail::loaded)
+		s = thumb->getImage().size();
+
+	if (s.isEmpty())
+		s = QSize(Settings::param().display().thumbSize, Settings::param().display().thumbSize);
+
+	QSizeF r = s;
+	if (orientation == Qt::Horizontal && height()-yOffset < r.height()*2)
+		r = QSizeF(qFloor(r.width()*(float)(height()-yOffset)/r.height()), height()-yOffset);
+	else if (orientation == Qt::Vertical && width()-yOffset < r.width()*2)
+		r = QSizeF(width()-yOffset, qFloor(r.height()*(float)(width()-yOffset)/r.width()));
+
+	if (r.width() < 1 || r.height() < 1)
+		return QSizeF();
+
+	return r;
+}
+
+QRectF DkFilePreview::thumbRect(int idx) const {
+
+	if (idx < 0 || idx >= mThumbSizes.size() || mThumbSizes.at(idx).isEmpty())
+		return QRectF();
+
+	QRectF r;
+
+	// center vertically
+	if (orientation == Qt::Horizontal) {
+		r = QRectF(QPointF(mThumbOffsets.at(idx), yOffset/2), mThumbSizes.at(idx));
+		r.moveCenter(QPoint(qFloor(r.center().x()), height()/2));
+	}
+	else {
+		r = QRectF(QPointF(yOffset/2, mThumbOffsets.at(idx)), mThumbSizes.at(idx));
+		r.moveCenter(QPoint(width()/2, qFloor(r.center().y())));
+	}
+
+	return r;
+}
 
+/**
+ * Returns the index of the thumbnail at pos.
+ * @param pos the position in widget coordinates
+ * @return int the thumbnail's index or -1 if there is no thumbnail at pos
+ **/
+int DkFilePreview::thumbAt(const QPoint& pos) const {
 
-		//painter->fillRect(QRect(0,0,200, 110), leftGradient);
+	int n = mThumbOffsets.size()-1;
+
+	if (n <= 0)
+		return -1;
+
+	QPointF p = worldMatrix.inverted().map(QPointF(pos));
+	int sp = qFloor(orientation == Qt::Horizontal ? p.x() : p.y());
+	int idx = int(std::upper_bound(mThumbOffsets.constBegin(), mThumbOffsets.constBegin()+n, sp) - mThumbOffsets.constBegin()) - 1;
+
+	// neighbours might overlap by a pixel
+	for (int cIdx = idx; cIdx >= 0 && cIdx >= idx-1; cIdx--) {
+		if (thumbRect(cIdx).contains(p))
+			return cIdx;
 	}
+
+	return -1;
+}
+
+void DkFilePreview::visibleThumbs(int& first, int& last) const {
+
+	int n = mThumbOffsets.size()-1;
+	float translation = orientation == Qt::Horizontal ? (float)worldMatrix.dx() : (float)worldMatrix.dy();
+	int limit = orientation == Qt::Horizontal ? width() : height();
+
+	QVector<int>::const_iterator b = mThumbOffsets.constBegin();
+	first = qMax(int(std::upper_bound(b, b+n, qFloor(-translation)) - b) - 1, 0);
+	last = int(std::upper_bound(b, b+n, qCeil(limit-translation)) - b) - 1;
+}
+
+/**
+ * Returns the thumbnail idx scaled to size.
+ * The scaled pixmaps are cached so that we don't scale full resolution images while scrolling.
+ * @param idx the thumbnail's index
+ * @param size the target size
+ * @return QPixmap the scaled thumbnail or a null pixmap if nothing is loaded yet
+ **/
+QPixmap DkFilePreview::thumbPixmap(int idx, const QSize& size) {
+
+	QSharedPointer<DkThumbNailT> thumb = mThumbs.at(idx)->getThumb();
+	QImage img;
+
+	// if the image is loaded draw that (it might be edited)
+	if (mThumbs.at(idx)->hasImage())
+		img = mThumbs.at(idx)->image();
+	else if (thumb->hasImage() == DkThumbNail::loaded)
+		img = thumb->getImage();
+
+	if (img.isNull() || size.isEmpty())
+		return QPixmap();
+
+	QHash<int, DkThumbPixmap>::const_iterator pIt = mThumbPixmaps.constFind(idx);
+
+	if (pIt != mThumbPixmaps.constEnd() && pIt->key == img.cacheKey() && pIt->pixmap.size() == size)
+		return pIt->pixmap;
+
+	DkThumbPixmap tp;
+	tp.key = img.cacheKey();
+	tp.pixmap = QPixmap::fromImage(img.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+	mThumbPixmaps.insert(idx, tp);
+
+	return tp.pixmap;
 }
 
 void DkFilePreview::drawNoImgEffect(QPainter* painter, const QRectF& r) {
@@ -429,39 +579,44 @@ void DkFilePreview::drawCurrentImgEffect(QPainter* painter, const QRectF& r) {
 	painter->setPen(oldPen);
 }
 
-void DkFilePreview::drawFadeOut(QLinearGradient gradient, QRectF imgRect, QImage *img) {
+void DkFilePreview::drawFadeOut(QPainter* painter) {
 
-	if (img && img->format() == QImage::Format_Indexed8)
-		return;
+	if (mLeftFade.isNull() || mRightFade.isNull())
+		createFadeMasks();
 
-	// compute current scaling
-	QPointF scale(img->width()/imgRect.width(), img->height()/imgRect.height());
-	QTransform wm;
-	wm.scale(scale.x(), scale.y());
+	QPainter::CompositionMode oldMode = painter->compositionMode();
+	painter->setCompositionMode(QPainter::CompositionMode_DestinationIn);
+
+	float translation = orientation == Qt::Horizontal ? (float)worldMatrix.dx() : (float)worldMatrix.dy();
 	
+	if (translation < 0)
+		painter->drawImage(QPoint(), mLeftFade);
+
 	if (orientation == Qt::Horizontal)
-		wm.translate(-imgRect.left(), 0);
+		painter->drawImage(QPoint(width()-mRightFade.width(), 0), mRightFade);
 	else
-		wm.translate(0, -imgRect.top());
+		painter->drawImage(QPoint(0, height()-mRightFade.height()), mRightFade);
 
-	QLinearGradient imgGradient = gradient;
-	
-	if (orientation == Qt::Horizontal) {
-		imgGradient.setStart(wm.map(gradient.start()).x(), 0);
-		imgGradient.setFinalStop(wm.map(gradient.finalStop()).x(), 0);
-	}
-	else {
-		imgGradient.setStart(0, wm.map(gradient.start()).y());
-		imgGradient.setFinalStop(0, wm.map(gradient.finalStop()).y());
-	}
+	painter->setCompositionMode(oldMode);
+}
+
+void DkFilePreview::createFadeMasks() {
+
+	int borderTriggerI = qMax(qRound(borderTrigger), 1);
+	QSize s = (orientation == Qt::Horizontal) ? QSize(borderTriggerI, qMax(height(), 1)) : QSize(qMax(width(), 1), borderTriggerI);
+
+	QLinearGradient gradient = (orientation == Qt::Horizontal) ? QLinearGradient(QPoint(0, 0), QPoint(borderTriggerI, 0)) : QLinearGradient(QPoint(0, 0), QPoint(0, borderTriggerI));
+	gradient.setColorAt(0, QColor(0, 0, 0, 0));
+	gradient.setColorAt(1, QColor(0, 0, 0, 255));
 
-	QImage mask = *img;
-	QPainter painter(&mask);
-	painter.fillRect(img->rect(), Qt::black);
-	painter.fillRect(img->rect(), imgGradient);
+	mLeftFade = QImage(s, QImage::Format_ARGB32_Premultiplied);
+	mLeftFade.fill(Qt::transparent);
+
+	QPainter painter(&mLeftFade);
+	painter.fillRect(mLeftFade.rect(), gradient);
 	painter.end();
 
-	img->setAlphaChannel(mask);
+	mRightFade = mLeftFade.mirrored(orientation == Qt::Horizontal, orientation == Qt::Vertical);
 }
 
 void DkFilePreview::resizeEvent(QResizeEvent *event) {
@@ -483,10 +638,9 @@ void DkFilePreview::resizeEvent(QResizeEvent *event) {
 
 	// now update...
 	borderTrigger = (orientation == Qt::Horizontal) ? (float)width()*winPercent : (float)height()*winPercent;
-	int borderTriggerI = qRound(borderTrigger);
-	leftGradient.setFinalStop((orientation == Qt::Horizontal) ? QPoint(borderTriggerI, 0) : QPoint(0, borderTriggerI));
-	rightGradient.setStart((orientation == Qt::Horizontal) ? QPoint(width()-borderTriggerI, 0) : QPoint(0, height()-borderTriggerI));
-	rightGradient.setFinalStop((orientation == Qt::Horizontal) ?  QPoint(width(), 0) : QPoint(0, height()));
+	mLeftFade = QImage();
+	mRightFade = QImage();
+	mLayoutDirty = true;
 
 	qDebug() << "file preview size: " << event->size();
 
@@ -560,30 +714,23 @@ void DkFilePreview::mouseMoveEvent(QMouseEvent *event) {
 	if (dx > borderTrigger*0.5) {
 
 		int oldSelection = selected;
-		selected = -1;
 
 		// find out where the mouse is
-		for (int idx = 0; idx < thumbRects.size(); idx++) {
-
-			if (worldMatrix.mapRect(thumbRects.at(idx)).contains(event->pos())) {
-				selected = idx;
-
-				if (selected <= mThumbs.size() && selected >= 0) {
-					QSharedPointer<DkThumbNailT> thumb = mThumbs.at(selected)->getThumb();
-					//selectedImg = DkImage::colorizePixmap(QPixmap::fromImage(thumb->getImage()), Settings::param().display().highlightColor, 0.3f);
-
-					// important: setText shows the label - if you then hide it here again you'll get a stack overflow
-					//if (fileLabel->height() < height())
-					//	fileLabel->setText(thumbs.at(selected).getFile().fileName(), -1);
-					QFileInfo fileInfo(thumb->getFilePath());
-					QString toolTipInfo = tr("Name: ") + fileInfo.fileName() + 
-						"\n" + tr("Size: ") + DkUtils::readableByte((float)fileInfo.size()) + 
-						"\n" + tr("Created: ") + fileInfo.created().toString(Qt::SystemLocaleDate);
-					setToolTip(toolTipInfo);
-					setStatusTip(fileInfo.fileName());
-				}
-				break;
-			}
+		selected = thumbAt(event->pos());
+
+		if (selected < mThumbs.size() && selected >= 0) {
+			QSharedPointer<DkThumbNailT> thumb = mThumbs.at(selected)->getThumb();
+			//selectedImg = DkImage::colorizePixmap(QPixmap::fromImage(thumb->getImage()), Settings::param().display().highlightColor, 0.3f);
+
+			// important: setText shows the label - if you then hide it here again you'll get a stack overflow
+			//if (fileLabel->height() < height())
+			//	fileLabel->setText(thumbs.at(selected).getFile().fileName(), -1);
+			QFileInfo fileInfo(thumb->getFilePath());
+			QString toolTipInfo = tr("Name: ") + fileInfo.fileName() + 
+				"\n" + tr("Size: ") + DkUtils::readableByte((float)fileInfo.size()) + 
+				"\n" + tr("Created: ") + fileInfo.created().toString(Qt::SystemLocaleDate);
+			setToolTip(toolTipInfo);
+			setStatusTip(fileInfo.fileName());
 		}
 
 		if (selected != -1 || selected != oldSelection)
@@ -632,14 +779,13 @@ void DkFilePreview::mouseReleaseEvent(QMouseEvent *event) {
 	if (mouseTrace < 20) {
 
 		// find out where the mouse did click
-		for (int idx = 0; idx < thumbRects.size(); idx++) {
+		int idx = thumbAt(event->pos());
 
-			if (idx < mThumbs.size() && worldMatrix.mapRect(thumbRects.at(idx)).contains(event->pos())) {
-				if (mThumbs.at(idx)->isFromZip()) 
-					emit changeFileSignal(idx - currentFileIdx);
-				else 
-					emit loadFileSignal(mThumbs.at(idx)->filePath());
-			}
+		if (idx >= 0 && idx < mThumbs.size()) {
+			if (mThumbs.at(idx)->isFromZip()) 
+				emit changeFileSignal(idx - currentFileIdx);
+			else 
+				emit loadFileSignal(mThumbs.at(idx)->filePath());
 		}
 	}
 	else
@@ -665,6 +811,7 @@ void DkFilePreview::wheelEvent(QWheelEvent *event) {
 
 		if (newSize != Settings::param().display().thumbSize) {
 			Settings::param().display().thumbSize = newSize;
+			mLayoutDirty = true;
 			update();
 		}
 	}
@@ -839,9 +986,24 @@ void DkFilePreview::setFileInfo(QSharedPointer<DkImageContainerT> cImage) {
 
 }
 
+void DkFilePreview::thumbLoaded() {
+
+	mLayoutDirty = true;
+	update();
+}
+
 void DkFilePreview::updateThumbs(QVector<QSharedPointer<DkImageContainerT> > thumbs) {
 
+	for (const QSharedPointer<DkImageContainerT>& imgC : mThumbs)
+		disconnect(imgC.data(), SIGNAL(thumbLoadedSignal(bool)), this, SLOT(thumbLoaded()));
+
 	this->mThumbs = thumbs;
+	mThumbPixmaps.clear();
+	mLayoutDirty = true;
+
+	// any thumbnail that is (re)loaded might change its size - even if it is not visible
+	for (const QSharedPointer<DkImageContainerT>& imgC : mThumbs)
+		connect(imgC.data(), SIGNAL(thumbLoadedSignal(bool)), this, SLOT(thumbLoaded()), Qt::UniqueConnection);
 
 	for (int idx = 0; idx < thumbs.size(); idx++) {
 		if (thumbs.at(idx)->isSelected()) {
@@ -890,7 +1052,24 @@ DkThumbLabel::~DkThumbLabel() {}
 
 void DkThumbLabel::setThumb(QSharedPointer<DkThumbNailT> thumb) {
 
+	if (mThumb == thumb)
+		return;
+
+	// labels are recycled by the scene - forget everything about the last thumb
+	if (mThumb)
+		disconnect(mThumb.data(), SIGNAL(thumbLoadedSignal()), this, SLOT(updateLabel()));
+
 	this->mThumb = thumb;
+	mThumbInitialized = false;
+	mFetchingThumb = false;
+	mIsHovered = false;
+
+	prepareGeometryChange();
+	mIcon.setPixmap(QPixmap());
+	mIcon.setScale(1.0f);
+	mIcon.setPos(0,0);
+	mText.hide();
+	setFlag(ItemIsSelectable, true);
 
 	if (thumb.isNull())
 		return;
@@ -915,6 +1094,16 @@ void DkThumbLabel::setThumb(QSharedPointer<DkThumbNailT> thumb) {
 	//selectPen.setWidth(2);
 }
 
+void DkThumbLabel::setIndex(int idx) {
+
+	mIdx = idx;
+}
+
+int DkThumbLabel::index() const {
+
+	return mIdx;
+}
+
 QPixmap DkThumbLabel::pixmap() const {
 
 	return mIcon.pixmap();
@@ -938,6 +1127,15 @@ void DkThumbLabel::updateLabel() {
 	if (mThumb.isNull())
 		return;
 
+	// the scene answers selection queries without touching the thumbs
+	if (mThumb->hasImage() == DkThumbNail::exists_not) {
+
+		DkThumbScene* s = dynamic_cast<DkThumbScene*>(scene());
+
+		if (s)
+			s->setThumbUnreadable(mIdx);
+	}
+
 	QPixmap pm;
 
 	if (!mThumb->getImage().isNull()) {
@@ -1043,6 +1241,20 @@ void DkThumbLabel::hoverLeaveEvent(QGraphicsSceneHoverEvent*) {
 	update();
 }
 
+QVariant DkThumbLabel::itemChange(GraphicsItemChange change, const QVariant& value) {
+
+	// the scene keeps the selection since this label might be recycled
+	if (change == ItemSelectedHasChanged) {
+		
+		DkThumbScene* s = dynamic_cast<DkThumbScene*>(scene());
+		
+		if (s)
+			s->setThumbSelected(mIdx, value.toBool());
+	}
+
+	return QGraphicsObject::itemChange(change, value);
+}
+
 void DkThumbLabel::setVisible(bool visible) {
 
 	mIcon.setVisible(visible);
@@ -1051,7 +1263,8 @@ void DkThumbLabel::setVisible(bool visible) {
 
 void DkThumbLabel::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
 	
-	if (!mFetchingThumb && mThumb->hasImage() == DkThumbNail::not_loaded && 
+	// the thumb might have been evicted by the DkThumbPool before we could show it
+	if ((!mFetchingThumb || !mThumbInitialized) && mThumb->hasImage() == DkThumbNail::not_loaded && 
 		Settings::param().resources().numThumbsLoading < Settings::param().resources().maxThumbsLoading*2) {
 			mThumb->fetchThumb();
 			mFetchingThumb = true;
@@ -1143,7 +1356,7 @@ DkThumbScene::DkThumbScene(QWidget* parent /* = 0 */) : QGraphicsScene(parent) {
 
 void DkThumbScene::updateLayout() {
 
-	if (mThumbLabels.empty())
+	if (mThumbs.empty())
 		return;
 
 	QSize pSize;
@@ -1153,64 +1366,155 @@ void DkThumbScene::updateLayout() {
 
 	mXOffset = qCeil(Settings::param().display().thumbPreviewSize*0.1f);
 	mNumCols = qMax(qFloor(((float)pSize.width()-mXOffset)/(Settings::param().display().thumbPreviewSize + mXOffset)), 1);
-	mNumCols = qMin(mThumbLabels.size(), mNumCols);
-	mNumRows = qCeil((float)mThumbLabels.size()/mNumCols);
+	mNumCols = qMin(mThumbs.size(), mNumCols);
+	mNumRows = qCeil((float)mThumbs.size()/mNumCols);
 
 	qDebug() << "num rows x num cols: " << mNumCols*mNumRows;
-	qDebug() << " thumb labels size: " << mThumbLabels.size();
+	qDebug() << " thumbs size: " << mThumbs.size();
 
 	int tso = Settings::param().display().thumbPreviewSize+mXOffset;
 	setSceneRect(0, 0, mNumCols*tso+mXOffset, mNumRows*tso+mXOffset);
-	//int fileIdx = thumbPool->getCurrentFileIdx();
 
 	DkTimer dt;
-	int cYOffset = mXOffset;
 
-	for (int rIdx = 0; rIdx < mNumRows; rIdx++) {
+	// the positions are computed - we just move the labels that are currently materialized
+	for (DkThumbLabel* cLabel : mThumbLabels) {
+		cLabel->setPos(thumbRect(cLabel->index()).topLeft());
+		cLabel->updateSize();
+	}
+
+	updateVisibleThumbs();
 
-		int cXOffset = mXOffset;
+	qDebug() << "moving takes: " << dt.getTotal();
 
-		for (int cIdx = 0; cIdx < mNumCols; cIdx++) {
+	// scroll to the first selected thumb
+	for (int idx = 0; idx < mSelected.size(); idx++) {
 
-			int tIdx = rIdx*mNumCols+cIdx;
+		if (mSelected.testBit(idx)) {
+			if (!views().empty())
+				views().first()->ensureVisible(thumbRect(idx));
+			break;
+		}
+	}
 
-			if (tIdx < 0 || tIdx >= mThumbLabels.size())
-				break;
+	mFirstLayout = false;
+}
 
-			DkThumbLabel* cLabel = mThumbLabels.at(tIdx);
-			cLabel->setPos(cXOffset, cYOffset);
-			cLabel->updateSize();
+QRectF DkThumbScene::thumbRect(int idx) const {
 
-			//if (tIdx == fileIdx)
-			//	cLabel->ensureVisible();
+	if (idx < 0 || mNumCols <= 0)
+		return QRectF();
 
-			//cLabel->show();
+	int tso = Settings::param().display().thumbPreviewSize+mXOffset;
+	int ps = Settings::param().display().thumbPreviewSize;
 
-			cXOffset += Settings::param().display().thumbPreviewSize + mXOffset;
-		}
+	return QRectF(mXOffset + (idx % mNumCols)*tso, mXOffset + (idx / mNumCols)*tso, ps, ps);
+}
+
+QRectF DkThumbScene::visibleRect() const {
+
+	if (views().empty())
+		return sceneRect();
+
+	QGraphicsView* v = views().first();
+
+	return v->mapToScene(v->viewport()->rect()).boundingRect();
+}
+
+/**
+ * Materializes labels for the visible rows (plus a margin).
+ * Labels that scrolled out of the margin are recycled for the 
+ * thumbs that became visible. Hence, the number of graphic items
+ * is independent of the number of files in the folder.
+ **/ 
+void DkThumbScene::updateVisibleThumbs() {
+
+	if (mThumbs.empty() || mNumCols <= 0)
+		return;
+
+	int tso = Settings::param().display().thumbPreviewSize+mXOffset;
+	int margin = 2;		// rows materialized above and below the viewport
+	QRectF vr = visibleRect();
+
+	int firstRow = qMax(qFloor((vr.top()-mXOffset)/tso) - margin, 0);
+	int lastRow = qMin(qFloor((vr.bottom()-mXOffset)/tso) + margin, mNumRows-1);
+
+	int firstIdx = firstRow*mNumCols;
+	int lastIdx = qMin((lastRow+1)*mNumCols, mThumbs.size());	// exclusive
 
-		// update ypos
-		cYOffset += Settings::param().display().thumbPreviewSize + mXOffset;	// 20 for label 
+	if (lastIdx <= firstIdx)
+		return;
+
+	blockSignals(true);	// recycling does not change the selection
+
+	// keep labels that are still in range, recycle the others
+	QVector<DkThumbLabel*> labels(lastIdx-firstIdx, 0);
+	QVector<DkThumbLabel*> freeLabels;
+
+	for (DkThumbLabel* cLabel : mThumbLabels) {
+
+		int idx = cLabel->index();
+
+		if (idx >= firstIdx && idx < lastIdx && !labels[idx-firstIdx])
+			labels[idx-firstIdx] = cLabel;
+		else
+			freeLabels.append(cLabel);
 	}
 
-	qDebug() << "moving takes: " << dt.getTotal();
+	for (int idx = firstIdx; idx < lastIdx; idx++) {
+
+		if (labels[idx-firstIdx])
+			continue;
+
+		DkThumbLabel* cLabel = 0;
 
-	for (int idx = 0; idx < mThumbLabels.size(); idx++) {
+		if (!freeLabels.empty()) {
+			cLabel = freeLabels.takeLast();
+			releaseLabel(cLabel);
+		}
+		else {
+			cLabel = new DkThumbLabel();
+			connect(cLabel, SIGNAL(loadFileSignal(const QString&)), this, SLOT(loadFile(const QString&)));
+			connect(cLabel, SIGNAL(showFileSignal(const QString&)), this, SLOT(showFile(const QString&)));
+			addItem(cLabel);
+		}
 
-		//if (thumbs.at(idx)->isSelected()) {
-		//	thumbLabels.at(idx)->ensureVisible();
-		//	thumbLabels.at(idx)->setSelected(true);	// not working here?!
-		//}
-		if (mThumbLabels.at(idx)->isSelected())
-			mThumbLabels.at(idx)->ensureVisible();
+		assignLabel(cLabel, idx);
+		labels[idx-firstIdx] = cLabel;
 	}
 
-	//update();
+	// the pool never shrinks below the visible rows - just park the remaining labels
+	for (DkThumbLabel* cLabel : freeLabels)
+		releaseLabel(cLabel);
 
-	//if (verticalScrollBar()->isVisible())
-	//	verticalScrollBar()->update();
+	mThumbLabels = labels + freeLabels;
 
-	mFirstLayout = false;
+	blockSignals(false);
+}
+
+void DkThumbScene::assignLabel(DkThumbLabel* label, int idx) {
+
+	QSharedPointer<DkImageContainerT> imgC = mThumbs.at(idx);
+
+	label->setIndex(idx);	// first - otherwise setSelected would alter the wrong thumb
+	label->setThumb(imgC->getThumb());
+	label->setPos(thumbRect(idx).topLeft());
+	label->updateSize();
+	label->show();
+	label->setSelected(mSelected.testBit(idx));
+
+	connect(imgC.data(), SIGNAL(thumbLoadedSignal()), this, SIGNAL(thumbLoadedSignal()), Qt::UniqueConnection);
+}
+
+void DkThumbScene::releaseLabel(DkThumbLabel* label) {
+
+	int idx = label->index();
+
+	if (idx >= 0 && idx < mThumbs.size())
+		disconnect(mThumbs.at(idx).data(), SIGNAL(thumbLoadedSignal()), this, SIGNAL(thumbLoadedSignal()));
+
+	label->setIndex(-1);
+	label->hide();		// hidden items are deselected by Qt (ignored since idx = -1)
 }
 
 void DkThumbScene::updateThumbs(QVector<QSharedPointer<DkImageContainerT> > thumbs) {
@@ -1229,27 +1533,14 @@ void DkThumbScene::updateThumbLabels() {
 	clear();	// deletes the thumbLabels
 	blockSignals(false);
 
-	qDebug() << "clearing mViewport: " << dt.getTotal();
 	mThumbLabels.clear();
+	mSelected = QBitArray(mThumbs.size());
+	mUnreadable = QBitArray(mThumbs.size());
 
 	qDebug() << "clearing labels takes: " << dt.getTotal();
 
-	for (int idx = 0; idx < mThumbs.size(); idx++) {
-		DkThumbLabel* thumb = new DkThumbLabel(mThumbs.at(idx)->getThumb());
-		connect(thumb, SIGNAL(loadFileSignal(const QString&)), this, SLOT(loadFile(const QString&)));
-		connect(thumb, SIGNAL(showFileSignal(const QString&)), this, SLOT(showFile(const QString&)));
-		connect(mThumbs.at(idx).data(), SIGNAL(thumbLoadedSignal()), this, SIGNAL(thumbLoadedSignal()));
-
-		//thumb->show();
-		addItem(thumb);
-		mThumbLabels.append(thumb);
-		//thumbsNotLoaded.append(thumb);
-	}
-
 	showFile();
 
-	qDebug() << "creating labels takes: " << dt.getTotal();
-
 	if (!mThumbs.empty())
 		updateLayout();
 
@@ -1281,22 +1572,22 @@ void DkThumbScene::connectLoader(QSharedPointer<DkImageLoader> loader, bool conn
 void DkThumbScene::showFile(const QString& filePath) {
 
 	if (filePath == QDir::currentPath() || filePath.isEmpty())
-		DkStatusBarManager::instance().setMessage(tr("").arg(QString::number(mThumbLabels.size())));
+		DkStatusBarManager::instance().setMessage(tr("").arg(QString::number(mThumbs.size())));
 	else
 		DkStatusBarManager::instance().setMessage(QFileInfo(filePath).fileName());
 
-	DkStatusBarManager::instance().setMessage(tr("%1 Images").arg(QString::number(mThumbLabels.size())), DkStatusBar::status_filenumber_info);
+	DkStatusBarManager::instance().setMessage(tr("%1 Images").arg(QString::number(mThumbs.size())), DkStatusBar::status_filenumber_info);
 }
 
 void DkThumbScene::ensureVisible(QSharedPointer<DkImageContainerT> img) const {
 
-	if (!img)
+	if (!img || views().empty())
 		return;
 
-	for (DkThumbLabel* label : mThumbLabels) {
+	for (int idx = 0; idx < mThumbs.size(); idx++) {
 
-		if (label->getThumb()->getFilePath() == img->filePath()) {
-			label->ensureVisible();
+		if (mThumbs.at(idx)->filePath() == img->filePath()) {
+			views().first()->ensureVisible(thumbRect(idx));
 			break;
 		}
 	}
@@ -1364,11 +1655,11 @@ void DkThumbScene::selectAllThumbs(bool selected) {
 
 void DkThumbScene::selectThumbs(bool selected /* = true */, int from /* = 0 */, int to /* = -1 */) {
 
-	if (mThumbLabels.empty())
+	if (mThumbs.empty())
 		return;
 
 	if (to == -1)
-		to = mThumbLabels.size()-1;
+		to = mThumbs.size()-1;
 
 	if (from > to) {
 		int tmp = to;
@@ -1376,9 +1667,19 @@ void DkThumbScene::selectThumbs(bool selected /* = true */, int from /* = 0 */,
 		from = tmp;
 	}
 
+	from = qMax(from, 0);
+	to = qMin(to, mSelected.size()-1);
+
+	if (from > to)
+		return;
+
 	blockSignals(true);
-	for (int idx = from; idx <= to && idx < mThumbLabels.size(); idx++) {
-		mThumbLabels.at(idx)->setSelected(selected);
+	mSelected.fill(selected, from, to+1);
+	
+	// sync the materialized labels
+	for (DkThumbLabel* label : mThumbLabels) {
+		if (label->index() >= from && label->index() <= to)
+			label->setSelected(selected);
 	}
 	blockSignals(false);
 	emit selectionChanged();
@@ -1530,11 +1831,10 @@ QStringList DkThumbScene::getSelectedFiles() const {
 
 	QStringList fileList;
 
-	for (int idx = 0; idx < mThumbLabels.size(); idx++) {
+	for (int idx = 0; idx < mSelected.size() && idx < mThumbs.size(); idx++) {
 
-		if (mThumbLabels.at(idx) && mThumbLabels.at(idx)->isSelected()) {
-			fileList.append(mThumbLabels.at(idx)->getThumb()->getFilePath());
-		}
+		if (isThumbSelected(idx))
+			fileList.append(mThumbs.at(idx)->getThumb()->getFilePath());
 	}
 
 	return fileList;
@@ -1542,25 +1842,48 @@ QStringList DkThumbScene::getSelectedFiles() const {
 
 int DkThumbScene::findThumb(DkThumbLabel* thumb) const {
 
-	int thumbIdx = -1;
-
-	for (int idx = 0; idx < mThumbLabels.size(); idx++) {
-		if (thumb == mThumbLabels.at(idx)) {
-			thumbIdx = idx;
-			break;
-		}
-	}
+	if (!thumb)
+		return -1;
 
-	return thumbIdx;
+	return thumb->index();
 }
 
 bool DkThumbScene::allThumbsSelected() const {
 
-	for (DkThumbLabel* label : mThumbLabels)
-		if (label->flags() & QGraphicsItem::ItemIsSelectable && !label->isSelected())
-			return false;
+	// thumbs that cannot be loaded are never selected
+	QBitArray selected = mSelected | mUnreadable;
+
+	return selected.count(true) == selected.size();
+}
+
+void DkThumbScene::setThumbSelected(int idx, bool selected) {
+
+	if (idx < 0 || idx >= mSelected.size())
+		return;
+
+	mSelected.setBit(idx, selected);
+}
+
+void DkThumbScene::setThumbUnreadable(int idx) {
 
-	return true;
+	if (idx < 0 || idx >= mUnreadable.size())
+		return;
+
+	mUnreadable.setBit(idx);
+}
+
+/**
+ * Returns true if the thumb at idx is selected.
+ * Thumbs that cannot be loaded are never selected.
+ * @param idx the thumb's index
+ * @return bool true if the thumb is selected
+ **/ 
+bool DkThumbScene::isThumbSelected(int idx) const {
+
+	if (idx < 0 || idx >= mSelected.size())
+		return false;
+
+	return mSelected.testBit(idx) && !mUnreadable.testBit(idx);
 }
 
 // DkThumbView --------------------------------------------------------------------
@@ -1600,6 +1923,7 @@ void DkThumbsView::mousePressEvent(QMouseEvent *event) {
 
 	if (event->buttons() == Qt::LeftButton) {
 		mousePos = event->pos();
+		mDragged = false;
 	}
 
 	qDebug() << "mouse pressed";
@@ -1614,8 +1938,14 @@ void DkThumbsView::mousePressEvent(QMouseEvent *event) {
 	// what we want to achieve: if the user is selecting with e.g. shift or ctrl 
 	// and he clicks (unintentionally) into the background - the selection would be lost
 	// otherwise so we just don't propagate this event
-	if (itemClicked || event->modifiers() == Qt::NoModifier)	
+	if (itemClicked || event->modifiers() == Qt::NoModifier) {
+
+		// Qt only deselects the materialized labels - so we clear the selection of hidden thumbs too
+		if (event->modifiers() == Qt::NoModifier && (!itemClicked || !itemClicked->isSelected()))
+			scene->selectThumbs(false);
+
 		QGraphicsView::mousePressEvent(event);
+	}
 }
 
 void DkThumbsView::mouseMoveEvent(QMouseEvent *event) {
@@ -1639,6 +1969,7 @@ void DkThumbsView::mouseMoveEvent(QMouseEvent *event) {
 				mimeData->setUrls(urls);
 				QDrag* drag = new QDrag(this);
 				drag->setMimeData(mimeData);
+				mDragged = true;
 				drag->exec(Qt::CopyAction);
 			}
 		}
@@ -1664,12 +1995,26 @@ void DkThumbsView::mouseReleaseEvent(QMouseEvent *event) {
 	else if (itemClicked != 0) {
 		lastShiftIdx = scene->findThumb(itemClicked);
 		qDebug() << "starting shift: " << lastShiftIdx;
+
+		// a plain click on a selected thumb selects just this one
+		if (event->modifiers() == Qt::NoModifier && !mDragged && lastShiftIdx != -1) {
+			scene->selectThumbs(false);
+			scene->selectThumbs(true, lastShiftIdx, lastShiftIdx);
+		}
 	}
 	else
 		lastShiftIdx = -1;
 
 }
 
+void DkThumbsView::scrollContentsBy(int dx, int dy) {
+
+	QGraphicsView::scrollContentsBy(dx, dy);
+	
+	// recycle the labels that scrolled out of view
+	scene->updateVisibleThumbs();
+}
+
 void DkThumbsView::dragEnterEvent(QDragEnterEvent *event) {
 
 	qDebug() << event->source() << " I am: " << this;
@@ -2022,6 +2367,8 @@ void DkThumbScrollWidget::resizeEvent(QResizeEvent *event) {
 
 	if (event->oldSize().width() != event->size().width() && isVisible())
 		mThumbsScene->updateLayout();
+	else if (isVisible())
+		mThumbsScene->updateVisibleThumbs();
 
 	DkWidget::resizeEvent(event);
 
@@ -36,6 +36,8 @@
 #include <QPen>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QBitArray>
+#include <QHash>
 #pragma warning(pop)		// no warnings from includes - end
 
 #include "DkBaseWidgets.h"
@@ -101,6 +103,7 @@ public slots:
 	void updateThumbs(QVector<QSharedPointer<DkImageContainerT> > thumbs);
 	void setFileInfo(QSharedPointer<DkImageContainerT> cImage);
 	void newPosition();
+	void thumbLoaded();
 
 signals:
 	void loadFileSignal(const QString& filePath) const;
@@ -130,10 +133,21 @@ private:
 	QTimer* moveImageTimer;
 
 	QRectF bufferDim;
-	QVector<QRectF> thumbRects;
 
-	QLinearGradient leftGradient;
-	QLinearGradient rightGradient;
+	// cached layout: mThumbOffsets[idx] is the strip position of a thumbnail, the last entry marks the strip's end
+	QVector<int> mThumbOffsets;
+	QVector<QSizeF> mThumbSizes;
+	bool mLayoutDirty;
+
+	struct DkThumbPixmap {
+		qint64 key;
+		QPixmap pixmap;
+	};
+	QHash<int, DkThumbPixmap> mThumbPixmaps;
+
+	QImage mStripBuffer;
+	QImage mLeftFade;
+	QImage mRightFade;
 	//QPixmap selectedImg;
 	//QPixmap currentImg;
 
@@ -164,7 +178,14 @@ private:
 	void init();
 	void initOrientations();
 	void drawThumbs(QPainter* painter);
-	void drawFadeOut(QLinearGradient gradient, QRectF imgRect, QImage *img);
+	void drawFadeOut(QPainter* painter);
+	void createFadeMasks();
+	void updateLayout();
+	QSizeF thumbSize(int idx);
+	QRectF thumbRect(int idx) const;
+	int thumbAt(const QPoint& pos) const;
+	void visibleThumbs(int& first, int& last) const;
+	QPixmap thumbPixmap(int idx, const QSize& size);
 	void drawSelectedEffect(QPainter* painter, const QRectF& r);
 	void drawCurrentImgEffect(QPainter* painter, const QRectF& r);
 	void drawNoImgEffect(QPainter* painter, const QRectF& r);
@@ -181,6 +202,8 @@ public:
 
 	void setThumb(QSharedPointer<DkThumbNailT> thumb);
 	QSharedPointer<DkThumbNailT> getThumb() {return mThumb;};
+	void setIndex(int idx);
+	int index() const;
 	QRectF boundingRect() const;
 	QPainterPath shape() const;
 	void updateSize();
@@ -199,8 +222,10 @@ protected:
 	void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget * widget = 0);
 	void hoverEnterEvent(QGraphicsSceneHoverEvent *event);
 	void hoverLeaveEvent(QGraphicsSceneHoverEvent *event);
+	QVariant itemChange(GraphicsItemChange change, const QVariant& value);
 
 	QSharedPointer<DkThumbNailT> mThumb;
+	int mIdx = -1;
 	QGraphicsPixmapItem mIcon;
 	QGraphicsTextItem mText;
 	bool mThumbInitialized = false;
@@ -226,6 +251,11 @@ public:
 	int findThumb(DkThumbLabel* thumb) const;
 	bool allThumbsSelected() const;
 	void ensureVisible(QSharedPointer<DkImageContainerT> img) const;
+	void setThumbSelected(int idx, bool selected);
+	bool isThumbSelected(int idx) const;
+	void setThumbUnreadable(int idx);
+	QRectF thumbRect(int idx) const;
+	void updateVisibleThumbs();
 
 public slots:
 	void updateThumbLabels();
@@ -251,13 +281,18 @@ signals:
 
 protected:
 	void connectLoader(QSharedPointer<DkImageLoader> loader, bool connectSignals = true);
+	void assignLabel(DkThumbLabel* label, int idx);
+	void releaseLabel(DkThumbLabel* label);
+	QRectF visibleRect() const;
 	
 	int mXOffset = 0;
 	int mNumRows = 0;
 	int mNumCols = 0;
 	bool mFirstLayout = true;
 
-	QVector<DkThumbLabel* > mThumbLabels;
+	QVector<DkThumbLabel* > mThumbLabels;	// materialized labels only (visible rows + margin)
+	QBitArray mSelected;					// selection state of all thumbs
+	QBitArray mUnreadable;					// thumbs that could not be loaded (reported by their labels)
 	QSharedPointer<DkImageLoader> mLoader;
 	QVector<QSharedPointer<DkImageContainerT> > mThumbs;
 };
@@ -282,9 +317,11 @@ protected:
 	void mousePressEvent(QMouseEvent *event);
 	void mouseMoveEvent(QMouseEvent *event);
 	void mouseReleaseEvent(QMouseEvent *event);
+	void scrollContentsBy(int dx, int dy);
 
 	DkThumbScene* scene;
 	QPointF mousePos;
+	bool mDragged = false;
 	int lastShiftIdx;
 
 };
@@ -216,6 +216,52 @@ void DkViewPort::updateImage(QSharedPointer<DkImageContainerT> image, bool loade
 		setImage(mLoader->getImage());
 }
 
+/**
+ * Replaces the preview with the full resolution image.
+ * In contrast to setImage() the view (zoom & position) is kept.
+ * @param image the image container which was upgraded
+ **/ 
+void DkViewPort::upgradeImage(QSharedPointer<DkImageContainerT> image) {
+
+	if (!mLoader || !image || image != mLoader->getCurrentImage())
+		return;
+
+	QImage newImg = image->getLoader()->image();
+
+	if (newImg.isNull() || mImgRect.isEmpty())
+		return;
+
+	DkTimer dt;
+
+	// the scale between preview & full image (the preview's aspect ratio might differ slightly due to rounding)
+	double sx = mImgRect.width() / newImg.width();
+	double sy = mImgRect.height() / newImg.height();
+	QTransform oldImgMatrix = mImgMatrix;
+	QTransform oldWorldMatrix = mWorldMatrix;
+
+	mImgStorage.setImage(newImg);
+	mImgRect = QRectF(QPoint(), getImageSize());
+	mOldImgRect = mImgRect;
+
+	// reset the world matrix - otherwise updateImageMatrix() compensates the changed image matrix
+	mWorldMatrix.reset();
+	updateImageMatrix();
+
+	// map the full image to the same view rect as the preview
+	mWorldMatrix = mImgMatrix.inverted() * QTransform::fromScale(sx, sy) * oldImgMatrix * oldWorldMatrix;
+
+	mController->getOverview()->setImage(newImg);
+	if (mController->getHistogram()) mController->getHistogram()->drawHistogram(newImg, imageContainer());
+
+	update();
+
+	emit newImageSignal(&newImg);
+	emit zoomSignal((float)(mWorldMatrix.m11()*mImgMatrix.m11()*100));
+	DkStatusBarManager::instance().setMessage(QString::number(qRound((float)(mWorldMatrix.m11()*mImgMatrix.m11() * 100))) + "%", DkStatusBar::status_zoom_info);
+
+	qDebug() << "[DkViewPort] preview upgraded to" << newImg.size() << "in" << dt.getTotal();
+}
+
 void DkViewPort::loadImage(QImage newImg) {
 
 	// delete current information
@@ -287,12 +333,18 @@ void DkViewPort::setImage(QImage newImg) {
 
 	mController->getPlayer()->startTimer();
 	mController->getOverview()->setImage(newImg);	// TODO: maybe we could make use of the image pyramid here
+
+	// report frames that were not ready when the slideshow requested them
+	DkSlideshowScheduler& slideshow = DkSlideshowScheduler::instance();
+	if (mLoader && slideshow.frameShown(mLoader->filePath()))
+		DkStatusBarManager::instance().setMessage(tr("Slideshow: %1 ms late (%2 missed)").arg(slideshow.lastDelay()).arg(slideshow.missedDeadlines()));
 	mController->stopLabels();
 
 	mOldImgRect = mImgRect;
 	
 	// init fading
 	if (Settings::param().display().fadeSec && (mController->getPlayer()->isPlaying() || (DkActionManager::instance().getMainWindow()->isFullScreen()))) {
+		createFadeBuffers();
 		mFadeTimer->start();
 		mFadeTime.start();
 	}
@@ -302,7 +354,7 @@ void DkViewPort::setImage(QImage newImg) {
 	update();
 
 	// draw a histogram from the image -> does nothing if the histogram is invisible
-	if (mController->getHistogram()) mController->getHistogram()->drawHistogram(newImg);
+	if (mController->getHistogram()) mController->getHistogram()->drawHistogram(newImg, imageContainer());
 	if (Settings::param().sync().syncMode == DkSettings::sync_mode_remote_display)
 		tcpSendImage(true);
 
@@ -635,6 +687,7 @@ void DkViewPort::tcpShowConnections(QList<DkPeer*> peers) {
 void DkViewPort::applyPlugin(DkPluginInterface* plugin, const QString& key) {
 	
 #ifdef WITH_PLUGINS
+	loadFullImage();
 	QSharedPointer<DkImageContainerT> result = DkImageContainerT::fromImageContainer(plugin->runPlugin(key, imageContainer()));
 	if (result) 
 		setEditedImage(result);
@@ -643,6 +696,23 @@ void DkViewPort::applyPlugin(DkPluginInterface* plugin, const QString& key) {
 #endif
 }
 
+/**
+ * Returns the device pixel ratio of a widget.
+ * Fade buffers are rendered at device resolution, otherwise
+ * they are upscaled on HiDPI screens.
+ **/ 
+static qreal fadePixelRatio(const QWidget* widget) {
+
+#if QT_VERSION >= 0x050600
+	return widget->devicePixelRatioF();
+#elif QT_VERSION >= 0x050000
+	return widget->devicePixelRatio();
+#else
+	Q_UNUSED(widget);
+	return 1.0;
+#endif
+}
+
 void DkViewPort::paintEvent(QPaintEvent* event) {
 
 	QPainter painter(viewport());
@@ -664,14 +734,23 @@ void DkViewPort::paintEvent(QPaintEvent* event) {
 			qDebug() << "added to image...";
 		}
 
-		// TODO: if fading is active we interpolate with background instead of the other image
-		draw(&painter, 1.0f-mFadeOpacity);
-
-		if (/*mFadeTimer->isActive() && */!mFadeBuffer.isNull()) {
-			float oldOp = (float)painter.opacity();
-			painter.setOpacity(mFadeOpacity);
-			painter.drawImage(mFadeImgViewRect, mFadeBuffer, mFadeBuffer.rect());
-			painter.setOpacity(oldOp);
+		// blit the blended frame if the view was not changed while fading
+		if (!mFadeFrame.isNull() && mFadeWorldMatrix == mWorldMatrix && mFadeFrame.size() == viewport()->size() * fadePixelRatio(viewport())) {
+			painter.setWorldMatrixEnabled(false);
+			painter.drawImage(QPoint(), mFadeFrame);
+			mFadeFrames++;
+		}
+		else {
+			// TODO: if fading is active we interpolate with background instead of the other image
+			draw(&painter, 1.0f-mFadeOpacity);
+
+			if (/*mFadeTimer->isActive() && */!mFadeBuffer.isNull()) {
+				float oldOp = (float)painter.opacity();
+				painter.setOpacity(mFadeOpacity);
+				painter.drawImage(mFadeImgViewRect, mFadeBuffer, mFadeBuffer.rect());
+				painter.setOpacity(oldOp);
+				mFadeFrames++;
+			}
 		}
 
 		//Now disable matrixWorld for overlay display
@@ -817,6 +896,9 @@ void DkViewPort::resizeEvent(QResizeEvent *event) {
 
 	mViewportRect = QRect(0, 0, width(), height());
 
+	if (mLoader)
+		mLoader->setPreviewSize(size());
+
 	// >DIR: diem - bug if zoom factor is large and window becomes small
 	updateImageMatrix();
 	centerImage();
@@ -1213,19 +1295,80 @@ void DkViewPort::copyImageBuffer() {
 
 void DkViewPort::animateFade() {
 
-	mFadeOpacity = 1.0f-(float)mFadeTime.getTotalTime()/Settings::param().display().fadeSec;
+	mFadeOpacity = 1.0f-(float)mFadeTime.elapsed()/(Settings::param().display().fadeSec*1000.0f);
 	
 	if (mFadeOpacity <= 0) {
+		qDebug() << "[DkViewPort] fade:" << mFadeFrames << "frames in" << mFadeTime.elapsed() << "ms (" 
+			<< qRound(mFadeFrames*1000.0/qMax(mFadeTime.elapsed(), (qint64)1)) << "fps)" << (mFadeFrom.isNull() ? "" : "blended");
+		
 		mFadeBuffer = QImage();
+		clearFadeBuffers();
 		mFadeTimer->stop();
 		mFadeOpacity = 0;
 	}
-
-	qDebug() << "new opacity: " << mFadeOpacity;
+	else if (!mFadeFrom.isNull())
+		DkImage::crossFade(mFadeFrom, mFadeTo, mFadeOpacity, mFadeFrame);
 
 	update();
 }
 
+/**
+ * Renders the old and the new image into device sized frames.
+ * While fading, these frames are just blended (see DkImage::crossFade)
+ * rather than scaling both images at every animation tick.
+ **/ 
+void DkViewPort::createFadeBuffers() {
+
+	clearFadeBuffers();
+	mFadeFrames = 0;
+
+	// movies & svgs are not static - so they are painted as before
+	if (mFadeBuffer.isNull() || mMovie || mSvg || viewport()->size().isEmpty())
+		return;
+
+	DkTimer dt;
+
+	qreal dpr = fadePixelRatio(viewport());
+	QRect vpRect(QPoint(), viewport()->size());	// logical pixels
+
+	mFadeTo = QImage(viewport()->size() * dpr, QImage::Format_ARGB32_Premultiplied);
+#if QT_VERSION >= 0x050000
+	mFadeTo.setDevicePixelRatio(dpr);
+#endif
+	mFadeTo.fill(0);	// transparent
+	mFadeFrom = mFadeTo.copy();
+
+	// the new image (including the background)
+	QPainter painter(&mFadeTo);
+	painter.setWorldTransform(mWorldMatrix);
+	painter.setRenderHints(QPainter::SmoothPixmapTransform | QPainter::Antialiasing);
+	draw(&painter, 1.0f);
+	painter.end();
+
+	// the old image
+	painter.begin(&mFadeFrom);
+	if (DkActionManager::instance().getMainWindow()->isFullScreen())
+		painter.fillRect(vpRect, Settings::param().slideShow().backgroundColor);
+	if (backgroundBrush() != Qt::NoBrush)
+		painter.fillRect(vpRect, backgroundBrush());
+	painter.setWorldTransform(mWorldMatrix);
+	painter.setRenderHints(QPainter::SmoothPixmapTransform | QPainter::Antialiasing);
+	painter.drawImage(mFadeImgViewRect, mFadeBuffer, mFadeBuffer.rect());
+	painter.end();
+
+	mFadeWorldMatrix = mWorldMatrix;
+	DkImage::crossFade(mFadeFrom, mFadeTo, 1.0f, mFadeFrame);
+
+	qDebug() << "[DkViewPort] fade buffers created in" << dt.getTotal();
+}
+
+void DkViewPort::clearFadeBuffers() {
+
+	mFadeFrom = QImage();
+	mFadeTo = QImage();
+	mFadeFrame = QImage();
+}
+
 void DkViewPort::togglePattern(bool show) {
 
 	mController->setInfo((show) ? tr("Transparency Pattern Enabled") : tr("Transparency Pattern Disabled"));
@@ -1591,13 +1734,28 @@ QSharedPointer<DkImageContainerT> DkViewPort::imageContainer() const {
 	return mLoader->getCurrentImage();
 }
 
+/**
+ * Replaces a preview with the full resolution image.
+ * This function blocks until the image is decoded.
+ * Call it before an edit reads getImage().
+ **/ 
+void DkViewPort::loadFullImage() {
+
+	QSharedPointer<DkImageContainerT> imgC = imageContainer();
+
+	if (imgC)
+		imgC->loadFullImage();
+}
+
 void DkViewPort::setImageLoader(QSharedPointer<DkImageLoader> newLoader) {
 	
 	mLoader = newLoader;
 	connectLoader(newLoader);
 
-	if (mLoader)
+	if (mLoader) {
+		mLoader->setPreviewSize(size());
 		mLoader->activate();
+	}
 }
 
 void DkViewPort::connectLoader(QSharedPointer<DkImageLoader> loader, bool connectSignals) {
@@ -1608,6 +1766,7 @@ void DkViewPort::connectLoader(QSharedPointer<DkImageLoader> loader, bool connec
 	if (connectSignals) {
 		//connect(mLoader.data(), SIGNAL(imageLoadedSignal(QSharedPointer<DkImageContainerT>, bool)), this, SLOT(updateImage(QSharedPointer<DkImageContainerT>, bool)), Qt::UniqueConnection);
 		connect(loader.data(), SIGNAL(imageUpdatedSignal(QSharedPointer<DkImageContainerT>)), this, SLOT(updateImage(QSharedPointer<DkImageContainerT>)), Qt::UniqueConnection);
+		connect(loader.data(), SIGNAL(imageUpgradedSignal(QSharedPointer<DkImageContainerT>)), this, SLOT(upgradeImage(QSharedPointer<DkImageContainerT>)), Qt::UniqueConnection);
 
 		connect(loader.data(), SIGNAL(updateDirSignal(QVector<QSharedPointer<DkImageContainerT> >)), mController->getFilePreview(), SLOT(updateThumbs(QVector<QSharedPointer<DkImageContainerT> >)), Qt::UniqueConnection);
 		connect(loader.data(), SIGNAL(imageUpdatedSignal(QSharedPointer<DkImageContainerT>)), mController->getFilePreview(), SLOT(setFileInfo(QSharedPointer<DkImageContainerT>)), Qt::UniqueConnection);
@@ -1628,6 +1787,7 @@ void DkViewPort::connectLoader(QSharedPointer<DkImageLoader> loader, bool connec
 	else {
 		//connect(mLoader.data(), SIGNAL(imageLoadedSignal(QSharedPointer<DkImageContainerT>, bool)), this, SLOT(updateImage(QSharedPointer<DkImageContainerT>, bool)), Qt::UniqueConnection);
 		disconnect(loader.data(), SIGNAL(imageUpdatedSignal(QSharedPointer<DkImageContainerT>)), this, SLOT(updateImage(QSharedPointer<DkImageContainerT>)));
+		disconnect(loader.data(), SIGNAL(imageUpgradedSignal(QSharedPointer<DkImageContainerT>)), this, SLOT(upgradeImage(QSharedPointer<DkImageContainerT>)));
 
 		disconnect(loader.data(), SIGNAL(updateDirSignal(QVector<QSharedPointer<DkImageContainerT> >)), mController->getFilePreview(), SLOT(updateThumbs(QVector<QSharedPointer<DkImageContainerT> >)));
 		disconnect(loader.data(), SIGNAL(imageUpdatedSignal(QSharedPointer<DkImageContainerT>)), mController->getFilePreview(), SLOT(setFileInfo(QSharedPointer<DkImageContainerT>)));
@@ -1660,6 +1820,17 @@ void DkViewPort::cropImage(const DkRotatingRect& rect, const QColor& bgCol) {
 
 	rect.getTransform(tForm, cImgSize);
 
+	// the rect refers to the displayed image - which might be a preview
+	QSize previewSize = getImageSize();
+	loadFullImage();
+	QSize imgSize = getImageSize();
+
+	if (!previewSize.isEmpty() && imgSize != previewSize) {
+		QTransform s = QTransform::fromScale((double)imgSize.width() / previewSize.width(), (double)imgSize.height() / previewSize.height());
+		tForm = s.inverted() * tForm * s;
+		cImgSize = QPointF(cImgSize.x() * s.m11(), cImgSize.y() * s.m22());
+	}
+
 	if (cImgSize.x() < 0.5f || cImgSize.y() < 0.5f) {
 		mController->setInfo(tr("I cannot crop an image that has 0 px, sorry."));
 		return;
@@ -1686,6 +1857,17 @@ void DkViewPort::cropImage(const DkRotatingRect& rect, const QColor& bgCol) {
 
 	QSharedPointer<DkImageContainerT> imgC = mLoader->getCurrentImage();
 
+	// axis aligned crops just cut off borders - so we can update the histogram
+	QImage srcImg = getImage();
+	if (imgC->hasHistogram(srcImg) && !srcImg.hasAlphaChannel() && tForm.type() <= QTransform::TxTranslate &&
+		tForm.dx() == qRound(tForm.dx()) && tForm.dy() == qRound(tForm.dy())) {
+		
+		QRect cropRect(-qRound(tForm.dx()), -qRound(tForm.dy()), img.width(), img.height());
+
+		if (srcImg.rect().contains(cropRect))
+			imgC->setHistogram(imgC->histogram().cropped(srcImg, cropRect), img);
+	}
+
 	imgC->setImage(img, tr("Cropped"));
 	setEditedImage(imgC);
 
@@ -2266,6 +2448,31 @@ void DkViewPortContrast::setImage(QImage newImg) {
 	if (newImg.isNull())
 		return;
 
+	splitChannels();
+	update();
+}
+
+/**
+ * Replaces the preview with the full resolution image.
+ * The channels are split again since they still have the preview's resolution.
+ * @param image the image container which was upgraded
+ **/ 
+void DkViewPortContrast::upgradeImage(QSharedPointer<DkImageContainerT> image) {
+
+	QSize oldSize = getImageSize();
+
+	DkViewPort::upgradeImage(image);
+
+	if (getImageSize() == oldSize)
+		return;
+
+	splitChannels();
+	drawImageHistogram();
+	update();
+}
+
+void DkViewPortContrast::splitChannels() {
+
 	if (mImgStorage.getImage().format() == QImage::Format_Indexed8) {
 		mImgs = QVector<QImage>(1);
 		mImgs[0] = mImgStorage.getImage();
@@ -2278,7 +2485,9 @@ void DkViewPortContrast::setImage(QImage newImg) {
 			mImgs = QVector<QImage>(4);
 			std::vector<cv::Mat> planes;
 			
-			cv::Mat imgUC3 = DkImage::qImage2Mat(mImgStorage.getImage());
+			// read only - we just split the channels
+			DkMatView view(mImgStorage.getImage(), false);
+			cv::Mat imgUC3 = view.mat();
 			//int format = imgQt.format();
 			//if (format == QImage::Format_RGB888)
 			//	imgUC3 = Mat(imgQt.height(), imgQt.width(), CV_8UC3, (uchar*)imgQt.bits(), imgQt.bytesPerLine());
@@ -2325,10 +2534,6 @@ void DkViewPortContrast::setImage(QImage newImg) {
 		emit imageModeSet(mode_gray);
 	else
 		emit imageModeSet(mode_rgb);
-
-	update();
-
-	
 }
 
 void DkViewPortContrast::pickColor(bool enable) {
@@ -2415,7 +2620,7 @@ void DkViewPortContrast::drawImageHistogram() {
 
 	if (mController->getHistogram() && mController->getHistogram()->isVisible()) {
 		if(mDrawFalseColorImg) mController->getHistogram()->drawHistogram(mFalseColorImg);
-		else mController->getHistogram()->drawHistogram(mImgStorage.getImage());
+		else mController->getHistogram()->drawHistogram(mImgStorage.getImage(), imageContainer());
 	}
 
 }
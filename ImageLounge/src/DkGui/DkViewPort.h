@@ -33,6 +33,7 @@
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QTimer>	// needed to construct mTimers
+#include <QElapsedTimer>
 #pragma warning(pop)		// no warnings from includes - end
 
 #ifndef DllGuiExport
@@ -99,6 +100,7 @@ public:
 
 	// getter
 	QSharedPointer<DkImageContainerT> imageContainer() const;
+	void loadFullImage();
 	void setImageLoader(QSharedPointer<DkImageLoader> newLoader);
 	DkControlWidget* getController();
 	bool isTestLoaded() { return mTestLoaded; };
@@ -168,6 +170,7 @@ public slots:
 	void copyImage();
 
 	virtual void updateImage(QSharedPointer<DkImageContainerT> image, bool loaded = true);
+	virtual void upgradeImage(QSharedPointer<DkImageContainerT> image);
 	virtual void loadImage(QImage newImg);
 	virtual void loadImage(QSharedPointer<DkImageContainerT> img);
 	virtual void setEditedImage(const QImage& newImg, const QString& editName);
@@ -205,12 +208,19 @@ protected:
 	
 	// fading stuff
 	QTimer* mFadeTimer;// = new QTimer(this);
-	DkTimer mFadeTime;
+	QElapsedTimer mFadeTime;
 	QImage mFadeBuffer;
 	float mFadeOpacity;
 	QRectF mFadeImgViewRect;
 	QRectF mFadeImgRect;
 	
+	// device sized frames that are blended while fading
+	QImage mFadeFrom;
+	QImage mFadeTo;
+	QImage mFadeFrame;
+	QTransform mFadeWorldMatrix;
+	int mFadeFrames = 0;
+	
 	// fun
 	bool mDissolveImage = false;
 	
@@ -234,6 +244,8 @@ protected:
 
 	void drawPolygon(QPainter *painter, QPolygon *polygon);
 	virtual void drawBackground(QPainter *painter);
+	void createFadeBuffers();
+	void clearFadeBuffers();
 	virtual void updateImageMatrix();
 	void showZoom();
 	void toggleLena(bool fullscreen);
@@ -308,6 +320,7 @@ public slots:
 	QImage getImage() const override;
 
 	virtual void setImage(QImage newImg);
+	virtual void upgradeImage(QSharedPointer<DkImageContainerT> image) override;
 
 protected:
 	virtual void draw(QPainter *painter, float opacity = 1.0f);
@@ -327,6 +340,7 @@ private:
 
 	// functions
 	void drawImageHistogram();
+	void splitChannels();
 };
 
 };
@@ -35,6 +35,7 @@
 #include "DkImageStorage.h"
 #include "DkSettings.h"
 #include "DkStatusBar.h"
+#include "DkMetaData.h"
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QObject>
@@ -92,6 +93,7 @@
 #include <QDirModel>
 #include <QSvgRenderer>
 #include <QFileDialog>
+#include <QTime>
 
 #pragma warning(pop)		// no warnings from includes - end
 
@@ -275,76 +277,201 @@ void DkFolderScrollBar::animateOpacityDown() {
 }
 
 // DkThumbsSaver --------------------------------------------------------------------
+/**
+ * Functor which embeds the thumbnail of a single file.
+ * It is mapped concurrently over all files of a DkThumbsSaver job.
+ **/ 
+class DkSaveThumbJob {
+
+public:
+	typedef int result_type;
+
+	DkSaveThumbJob(bool forceSave = false) : mForceSave(forceSave) {}
+
+	int operator()(const QString& filePath) const {
+		return DkThumbsSaver::saveThumb(filePath, mForceSave);
+	}
+
+protected:
+	bool mForceSave;
+};
+
 DkThumbsSaver::DkThumbsSaver(QWidget* parent) : DkWidget(parent) {
-	mStop = false;
-	mCLoadIdx = 0;
-	mNumSaved = 0;
+	
+	connect(&mWatcher, SIGNAL(resultReadyAt(int)), this, SLOT(thumbSaved(int)));
+	connect(&mWatcher, SIGNAL(finished()), this, SLOT(processingFinished()));
 }
 
+DkThumbsSaver::~DkThumbsSaver() {
+
+	// running jobs write to the files - let them finish
+	mWatcher.cancel();
+	mWatcher.waitForFinished();
+}
+
+/**
+ * Embeds thumbnails into all images.
+ * The files are processed concurrently by QtConcurrent's thread pool
+ * (which is bounded by the number of cores). If a canceled job is
+ * started again with the same files, only the remaining files are processed.
+ * @param images the images to be processed
+ * @param forceSave if true, existing thumbnails are replaced
+ **/ 
 void DkThumbsSaver::processDir(QVector<QSharedPointer<DkImageContainerT> > images, bool forceSave) {
 
 	if (images.empty())
 		return;
 
+	if (mWatcher.isRunning()) {
+		qDebug() << "[thumbs saver] I am already saving thumbnails...";
+		return;
+	}
+
+	QStringList files;
+	for (QSharedPointer<DkImageContainerT> img : images)
+		files << img->filePath();
+
+	// resume if the last job was canceled
+	bool resume = files == mFiles && forceSave == mForceSave && mProcessed.count(true) < mProcessed.size();
+
+	if (!resume) {
+		mFiles = files;
+		mProcessed = QBitArray(mFiles.size());
+		mNumSaved = 0;
+		mNumSkipped = 0;
+		mNumFailed = 0;
+	}
+	else
+		qDebug() << "[thumbs saver] resuming at" << mProcessed.count(true) << "/" << mFiles.size();
+
 	mStop = false;
-	mCLoadIdx = 0;
-	mNumSaved = 0;
+	mForceSave = forceSave;
+	mCurrentDir = QFileInfo(mFiles.first()).absolutePath();
+	mNumProcessed = 0;
 
-	mPd = new QProgressDialog(tr("\nCreating thumbnails...\n") + images.first()->filePath(), tr("Cancel"), 0, (int)images.size(), QApplication::activeWindow());
-	mPd->setWindowTitle(tr("Thumbnails"));
+	QStringList pendingFiles;
+	mPending.clear();
+
+	for (int idx = 0; idx < mFiles.size(); idx++) {
+
+		if (!mProcessed.testBit(idx)) {
+			mPending << idx;
+			pendingFiles << mFiles.at(idx);
+		}
+	}
 
-	//pd->setWindowModality(Qt::WindowModal);
+	mTimer.invalidate();
+	mPd = new QProgressDialog(progressText(), tr("Cancel"), 0, mFiles.size(), QApplication::activeWindow());
+	mPd->setWindowTitle(tr("Thumbnails"));
+	mPd->setValue(mFiles.size() - mPending.size());
 
 	connect(this, SIGNAL(numFilesSignal(int)), mPd, SLOT(setValue(int)));
 	connect(mPd, SIGNAL(canceled()), this, SLOT(stopProgress()));
 
 	mPd->show();
 
-	this->mForceSave = forceSave;
-	this->mImages = images;
-	loadNext();
-
+	mTimer.start();
+	mWatcher.setFuture(QtConcurrent::mapped(pendingFiles, DkSaveThumbJob(forceSave)));
 }
 
-void DkThumbsSaver::thumbLoaded(bool) {
+/**
+ * Embeds a thumbnail into the file's metadata.
+ * Files that already have a valid thumbnail are skipped unless
+ * forceSave is set. This method is called concurrently.
+ * @param filePath the file to be processed
+ * @param forceSave if true, existing thumbnails are replaced
+ * @return int thumb_saved, thumb_skipped or thumb_failed
+ **/ 
+int DkThumbsSaver::saveThumb(const QString& filePath, bool forceSave) {
 
-	mNumSaved++;
-	emit numFilesSignal(mNumSaved);
+	if (!forceSave) {
 
-	if (mNumSaved == mImages.size() || mStop) {
-		if (mPd) {
-			mPd->close();
-			mPd->deleteLater();
-			mPd = 0;
+		try {
+			// probing the exif header is much cheaper than decoding the image
+			DkMetaDataT metaData;
+			
+			if (metaData.probeMetaData(filePath)) {
+				
+				QImage thumb = metaData.getThumbnail();
+				int minSize = Settings::param().display().thumbSize;
+
+				// DkThumbNail would accept this thumbnail
+				if (!thumb.isNull() && (thumb.width() >= minSize || thumb.height() >= minSize))
+					return thumb_skipped;
+			}
+		}
+		catch(...) {
+			// we'll compute the thumbnail
 		}
-		mStop = true;
 	}
-	else
-		loadNext();
+
+	// computes the thumbnail from the full image, sets it (DkMetaDataT::setThumbnail) & saves the metadata in place
+	DkThumbNail thumb(filePath);
+	thumb.compute(DkThumbNail::force_save_thumb);
+
+	return (thumb.hasImage() == DkThumbNail::loaded) ? thumb_saved : thumb_failed;
 }
 
-void DkThumbsSaver::loadNext() {
+void DkThumbsSaver::thumbSaved(int idx) {
+
+	mProcessed.setBit(mPending.at(idx));
+	mNumProcessed++;
+
+	switch (mWatcher.resultAt(idx)) {
+	case thumb_saved:	mNumSaved++;	break;
+	case thumb_skipped:	mNumSkipped++;	break;
+	default:			mNumFailed++;	break;
+	}
+
+	emit numFilesSignal(mProcessed.count(true));
+
+	if (mPd)
+		mPd->setLabelText(progressText());
+}
+
+void DkThumbsSaver::processingFinished() {
+
+	double sec = mTimer.elapsed() / 1000.0;
 	
+	qDebug() << "[thumbs saver]" << mNumProcessed << "files in" << sec << "sec (" << mNumProcessed / qMax(sec, 0.001) << "images/s) - "
+		<< mNumSaved << "saved," << mNumSkipped << "skipped," << mNumFailed << "failed";
+
 	if (mStop)
-		return;
+		qDebug() << "[thumbs saver] canceled -" << mFiles.size() - mProcessed.count(true) << "files left, run it again to resume";
+
+	if (mPd) {
+		mPd->close();
+		mPd->deleteLater();
+		mPd = 0;
+	}
+	mStop = true;
+}
 
-	int missing = Settings::param().resources().maxThumbsLoading-Settings::param().resources().numThumbsLoading;
-	int numLoading = mCLoadIdx+missing;
-	int force = (mForceSave) ? DkThumbNail::force_save_thumb : DkThumbNail::save_thumb;
+/**
+ * Returns the progress dialog's text.
+ * @return QString the processed folder, the throughput and an ETA.
+ **/ 
+QString DkThumbsSaver::progressText() const {
+
+	QString text = tr("\nCreating thumbnails...\n") + mCurrentDir.absoluteFilePath();
 
-	qDebug() << "missing: " << missing << " num loading: " << numLoading;
-	qDebug() << "loading bounds: " << mCLoadIdx << " - " << numLoading;
+	if (mNumProcessed > 0 && mTimer.isValid()) {
 
-	for (int idx = mCLoadIdx; idx < mImages.size() && idx < numLoading; idx++) {
-		mCLoadIdx++;
-		connect(mImages.at(idx)->getThumb().data(), SIGNAL(thumbLoadedSignal(bool)), this, SLOT(thumbLoaded(bool)));
-		mImages.at(idx)->getThumb()->fetchThumb(force);
+		double rate = mNumProcessed / qMax(mTimer.elapsed() / 1000.0, 0.001);
+		int eta = qRound((mFiles.size() - mProcessed.count(true)) / rate);
+
+		text += "\n" + tr("%1 images/s - %2 remaining")
+			.arg(rate, 0, 'f', 1)
+			.arg(QTime(0, 0).addSecs(eta).toString(eta >= 3600 ? "hh:mm:ss" : "mm:ss"));
 	}
+
+	return text;
 }
 
 void DkThumbsSaver::stopProgress() {
 
 	mStop = true;
+	mWatcher.cancel();	// running jobs are finished
 }
 
 // DkFileSystemModel --------------------------------------------------------------------
@@ -1335,6 +1462,9 @@ void DkPlayer::play(bool play) {
 	}
 	else
 		displayTimer->stop();
+
+	// the cacher preloads images according to the interval
+	DkSlideshowScheduler::instance().setInterval(play ? displayTimer->interval() : 0);
 }
 
 void DkPlayer::togglePlay() {
@@ -1348,10 +1478,12 @@ void DkPlayer::startTimer() {
 	if (playing) {
 		displayTimer->setInterval(qRound(Settings::param().slideShow().time*1000));	// if it was updated...
 		displayTimer->start();
+		DkSlideshowScheduler::instance().setInterval(displayTimer->interval());
 	}
 }
 
 void DkPlayer::autoNext() {
+	DkSlideshowScheduler::instance().startFrame();	// the next image is due now
 	emit nextSignal();
 }
 
@@ -1373,6 +1505,9 @@ void DkPlayer::setTimeToDisplay(int ms) {
 
 	timeToDisplay = ms;
 	displayTimer->setInterval(ms);
+
+	if (playing)
+		DkSlideshowScheduler::instance().setInterval(ms);
 }
 
 void DkPlayer::show(int ms) {		
@@ -2162,102 +2297,80 @@ void DkHistogram::paintEvent(QPaintEvent*) {
 }
 
 /**
- * Goes through the image and counts pixels values. They are used to create the image histogram.
- * @param currently displayed image
+ * Draws the image histogram.
+ * If the histogram of large images is not cached, a coarse histogram is drawn
+ * immediately and it is refined in the background.
+ * @param img currently displayed image
+ * @param imgC the image's container which caches the histogram
  **/ 
-void DkHistogram::drawHistogram(QImage imgQt) {
+void DkHistogram::drawHistogram(QImage img, QSharedPointer<DkImageContainerT> imgC) {
+
+	// a refinement of the previous image must not overwrite this histogram
+	mHistImg = QImage();
+	mHistContainer.clear();
 
-	if (!isVisible() || imgQt.isNull()) {
+	if (!isVisible() || img.isNull()) {
 		setPainted(false);
 		return;
 	}
 
 	DkTimer dt;
 
-#ifdef WITH_OPENCV
-	
-	int histValues[3][256];
-
-	for (int idx = 0; idx < 256; idx++) {
-		histValues[0][idx] = 0;
-		histValues[1][idx] = 0;
-		histValues[2][idx] = 0;
+	if (imgC && imgC->hasHistogram(img)) {
+		setHistogram(imgC->histogram());
+		return;
 	}
-	
 
-	// 8 bit images
-	if (imgQt.depth() == 8) {
+	int level = DkImageHistogram::level(img.size(), 512*512);
+	DkImageHistogram hist = DkImageHistogram::compute(img, level);
+	setHistogram(hist);
 
-		qDebug() << "8 bit histogram -------------------";
+	if (hist.isApproximate()) {
+		mHistImg = img;
+		mHistContainer = imgC;
+		connect(&mHistWatcher, SIGNAL(finished()), this, SLOT(histogramComputed()), Qt::UniqueConnection);
+		mHistWatcher.setFuture(QtConcurrent::run(&DkImageHistogram::compute, img, 0));
+	}
+	else if (imgC)
+		imgC->setHistogram(hist, img);
 
-		for (int rIdx = 0; rIdx < imgQt.height(); rIdx++) {
+	qDebug() << "drawing the histogram took me: " << dt.getTotal();
+}
 
-			const unsigned char* pixel = imgQt.constScanLine(rIdx);
+void DkHistogram::histogramComputed() {
 
-			for (int cIdx = 0; cIdx < imgQt.width(); cIdx++, pixel++) {
+	// another image was drawn in the meantime
+	if (mHistImg.isNull())
+		return;
 
-				histValues[0][*pixel]++;
-				histValues[1][*pixel]++;
-				histValues[2][*pixel]++;
-			}
-		}
-	}
-	// 24 bit images
-	else if (imgQt.depth() == 24) {
-		
-		qDebug() << "24 bit histogram -------------------";
+	DkImageHistogram hist = mHistWatcher.result();
 
-		// TODO: not tested!!
-		for (int rIdx = 0; rIdx < imgQt.height(); rIdx++) {
+	if (mHistContainer)
+		mHistContainer->setHistogram(hist, mHistImg);
 
-			const unsigned char* pixel = imgQt.constScanLine(rIdx);
+	mHistImg = QImage();
+	mHistContainer.clear();
 
-			for (int cIdx = 0; cIdx < imgQt.width(); cIdx++) {
+	if (isVisible())
+		setHistogram(hist);
+}
 
-				// If I understood the api correctly, the first bits are 0 if we have 24bpp & < 8 bits per channel
-				histValues[0][*pixel]++; pixel++;
-				histValues[1][*pixel]++; pixel++;
-				histValues[2][*pixel]++; pixel++;
-			}
-		}
-	}
-	// 32 bit images
-	else if (imgQt.depth() == 32) {
-		
-		for (int rIdx = 0; rIdx < imgQt.height(); rIdx++) {
-		
-			const QRgb* pixel = (QRgb*)(imgQt.constScanLine(rIdx));
-	
-			for (int cIdx = 0; cIdx < imgQt.width(); cIdx++, pixel++) {
+void DkHistogram::setHistogram(const DkImageHistogram& hist) {
 
-				histValues[0][qRed(*pixel)]++;
-				histValues[1][qGreen(*pixel)]++;
-				histValues[2][qBlue(*pixel)]++;
-			}
-		}
+	if (hist.isEmpty()) {
+		setPainted(false);
+		update();
+		return;
 	}
 
-	int maxHistValue = 0;
-
-	for (int idx = 0; idx < 256; idx++) {
-		
-		if (histValues[0][idx] > maxHistValue)
-			maxHistValue = histValues[0][idx];
-		if (histValues[1][idx] > maxHistValue)
-			maxHistValue = histValues[1][idx];
-		if (histValues[2][idx] > maxHistValue)
-			maxHistValue = histValues[2][idx];
+	for (int cIdx = 0; cIdx < DkImageHistogram::num_channels; cIdx++) {
+		const int* c = hist.channel(cIdx);
+		for (int idx = 0; idx < DkImageHistogram::num_bins; idx++)
+			mHist[cIdx][idx] = c[idx];
 	}
 
-	setMaxHistogramValue(maxHistValue);
-	updateHistogramValues(histValues);
 	setPainted(true);
-
-#else
-	setPainted(false);
-#endif
-	
-	qDebug() << "drawing the histogram took me: " << dt.getTotal();
+	setMaxHistogramValue(hist.maxCount());
 
 	update();
 }
@@ -2267,6 +2380,9 @@ void DkHistogram::drawHistogram(QImage imgQt) {
  **/ 
 void DkHistogram::clearHistogram() {
 
+	mHistImg = QImage();
+	mHistContainer.clear();
+
 	setPainted(false);
 	update();
 }
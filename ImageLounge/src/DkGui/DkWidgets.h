@@ -38,6 +38,8 @@
 #include <QFutureWatcher>
 #include <QLineEdit>
 #include <QListWidget>
+#include <QBitArray>
+#include <QElapsedTimer>
 #pragma warning(pop)		// no warnings from includes - end
 
 #pragma warning(disable: 4251)	// TODO: remove
@@ -322,26 +324,43 @@ class DkThumbsSaver : public DkWidget {
 
 public:
 	DkThumbsSaver(QWidget* parent = 0);
+	~DkThumbsSaver();
+
+	enum {
+		thumb_failed,
+		thumb_saved,
+		thumb_skipped,
+	};
 
 	void processDir(QVector<QSharedPointer<DkImageContainerT> > images, bool forceSave);
+	static int saveThumb(const QString& filePath, bool forceSave);
 
 signals:
 	void numFilesSignal(int currentFileIdx);
 
 public slots:
 	void stopProgress();
-	void thumbLoaded(bool loaded);
-	void loadNext();
+	void thumbSaved(int idx);
+	void processingFinished();
 
 protected:
+	QString progressText() const;
 
 	QFileInfo mCurrentDir;
 	QProgressDialog* mPd = 0;
-	int mCLoadIdx = 0;
 	bool mStop = false;
 	bool mForceSave = false;
-	int mNumSaved = false;
-	QVector<QSharedPointer<DkImageContainerT> > mImages;
+	
+	QStringList mFiles;				// all files of the current job
+	QVector<int> mPending;			// indexes (into mFiles) processed by the current run
+	QBitArray mProcessed;			// files that are done - kept for resuming a canceled job
+	QFutureWatcher<int> mWatcher;
+	QElapsedTimer mTimer;
+
+	int mNumProcessed = 0;			// files processed by the current run
+	int mNumSaved = 0;
+	int mNumSkipped = 0;
+	int mNumFailed = 0;
 };
 
 class DkFileSystemModel : public QFileSystemModel {
@@ -665,7 +684,8 @@ class DkHistogram : public DkWidget {
 public:
 	DkHistogram(QWidget *parent);
 	~DkHistogram();
-	void drawHistogram(QImage img);
+	void drawHistogram(QImage img, QSharedPointer<DkImageContainerT> imgC = QSharedPointer<DkImageContainerT>());
+	void setHistogram(const DkImageHistogram& hist);
 	void clearHistogram();
 	void setMaxHistogramValue(int maxValue);
 	void updateHistogramValues(int histValues[][256]);
@@ -677,7 +697,14 @@ protected:
 	virtual void mouseReleaseEvent(QMouseEvent *event);
 	virtual void paintEvent(QPaintEvent* event);
 
+protected slots:
+	void histogramComputed();
+
 private:
+	QFutureWatcher<DkImageHistogram> mHistWatcher;
+	QImage mHistImg;
+	QSharedPointer<DkImageContainerT> mHistContainer;
+
 	int mHist[3][256];
 	int mMaxValue = 20;
 	bool mIsPainted = false;
@@ -46,6 +46,7 @@
 #include <QPixmap>
 #include <QIcon>
 #include <QDebug>
+#include <QElapsedTimer>
 
 #include <qmath.h>
 
@@ -155,6 +156,7 @@ bool DkBasicLoader::loadGeneral(const QString& filePath, bool loadMetaData, bool
  **/ 
 bool DkBasicLoader::loadGeneral(const QString& filePath, QSharedPointer<QByteArray> ba, bool loadMetaData, bool fast) {
 
+	DK_TRACE("decode", "loadGeneral");
 
 	bool imgLoaded = false;
 	
@@ -167,7 +169,6 @@ bool DkBasicLoader::loadGeneral(const QString& filePath, QSharedPointer<QByteArr
 	
 
 	fInfo = QFileInfo(mFile);	// resolved lnk
-	QString newSuffix = fInfo.suffix();
 
 	release();
 
@@ -186,12 +187,14 @@ bool DkBasicLoader::loadGeneral(const QString& filePath, QSharedPointer<QByteArr
 	if (loadMetaData && mMetaData) {
 
 		try {
-			mMetaData->readMetaData(filePath, ba);
+			// fast loads only need the orientation - so we don't parse the full metadata
+			if (!fast || !mMetaData->probeMetaData(filePath, ba))
+				mMetaData->readMetaData(filePath, ba);
 
 			if (!Settings::param().metaData().ignoreExifOrientation) {
 				orientation = mMetaData->getOrientation();
 				
-				if (orientation == -1) {
+				if (orientation == -1 && !mMetaData->isProbed()) {
 					mMetaData->clearOrientation();
 					mMetaData->saveMetaData(ba);
 					qWarning() << "deleting illegal EXIV orientation: " << orientation;
@@ -204,130 +207,316 @@ bool DkBasicLoader::loadGeneral(const QString& filePath, QSharedPointer<QByteArr
 		qDebug() << "metaData is NULL!";
 	}
 
-	qDebug() << "ba size: " << ba;
-
-	QList<QByteArray> qtFormats = QImageReader::supportedImageFormats();
 	QString suf = fInfo.suffix().toLower();
-
 	QImage img;
 
-	if (!imgLoaded && !fInfo.exists() && ba && !ba->isEmpty()) {
-		imgLoaded = img.loadFromData(*ba.data());
+	// identify the format by its magic bytes and dispatch directly to the decoders that can handle it
+	// this makes failures cheap since we do not try every decoder (and read the file several times)
+	QByteArray format;
+	QVector<int> decoders = DkDecoderRegistry::instance().findDecoders(loadFileHeader(mFile, ba), suf, format);
+
+	for (int lId : decoders) {
 
 		if (imgLoaded)
-			mLoader = qt_loader;
+			break;
+
+		// wall time - DkTimer uses clock() which sums up the CPU time of all threads
+		QElapsedTimer dt;
+		dt.start();
+		imgLoaded = loadWithDecoder(lId, mFile, format, img, ba, fast);
+		DkDecoderRegistry::instance().addTiming(lId, dt.nsecsElapsed() / 1e9, imgLoaded);
+
+		if (imgLoaded) {
+			mLoader = lId;
+			qDebug() << "[DkBasicLoader]" << DkDecoderRegistry::instance().decoder(lId).name() << "decoded" << fInfo.fileName() << "in" << dt.elapsed() << "ms";
+		}
+	}
+
+	if (!imgLoaded)
+		qDebug() << "[DkBasicLoader] no decoder could load" << fInfo.fileName() << "format:" << format << "decoders:" << decoders;
+
+	// tiff things
+	if (imgLoaded && !mPageIdxDirty) {
+
+		// e.g. TIFF based RAW files are loaded with a single page
+		if (DkDecoderRegistry::instance().decoder(mLoader).hasCapability(DkImageDecoder::cap_multi_page))
+			indexPages(mFile);
+		else {
+			mNumPages = 1;
+			mPageIdx = 1;
+		}
+	}
+	mPageIdxDirty = false;
+
+	if (imgLoaded && loadMetaData && mMetaData) {
+		
+		try {
+			mMetaData->setQtValues(img);
+		
+			if (orientation != -1 && !mMetaData->isTiff() && !Settings::param().metaData().ignoreExifOrientation)
+				img = rotate(img, orientation);
+
+		} catch(...) {}	// ignore if we cannot read the metadata
+	}
+	else if (!mMetaData) {
+		qDebug() << "metaData is NULL!";
 	}
 
+	if (imgLoaded)
+		setEditImage(img, tr("Original Image"));
+
+	//qDebug() << qImg.text();
+
+	return imgLoaded;
+}
+
+/**
+ * Loads the image with the decoder specified.
+ * @param loaderId the decoder's id (see loaderID)
+ * @param filePath the file path
+ * @param format the format (Qt notation) if it was identified
+ * @param img the image - Qt decoders write here, all others set the edit image
+ * @param ba the file buffer (might be empty)
+ * @param fast if true, (RAW) previews are loaded
+ * @return bool true if the image was loaded
+ **/ 
+bool DkBasicLoader::loadWithDecoder(int loaderId, const QString& filePath, const QByteArray& format, QImage& img, QSharedPointer<QByteArray> ba, bool fast) {
+
+	DK_TRACE("decode", "loadWithDecoder");
+
+	switch (loaderId) {
+	case qt_loader:		return loadQtFile(filePath, format, img, ba);
+	case psd_loader:	return loadPSDFile(filePath, ba);
+	case webp_loader:	return loadWebPFile(filePath, ba);
+	case raw_loader:	return loadRawFile(filePath, ba, fast);
+	case roh_loader:	return loadRohFile(filePath, ba);
+	case vec_loader:	return loadOpenCVVecFile(filePath, ba);
+	}
+
+	return false;
+}
+
+bool DkBasicLoader::loadQtFile(const QString& filePath, const QByteArray& format, QImage& img, QSharedPointer<QByteArray> ba) {
+
 	// load large icons
-	if (!imgLoaded && suf == "ico") {
+	if (format == "ico" && QFileInfo(filePath).exists()) {
 
-		QIcon icon(mFile);
+		QIcon icon(filePath);
 
 		if (!icon.isNull()) {
 			img = icon.pixmap(QSize(256, 256)).toImage();
-			imgLoaded = true;
+			return !img.isNull();
 		}
 	}
 
-	// default Qt loader
-	// here we just try those formats that are officially supported
-	if (!imgLoaded && qtFormats.contains(suf.toStdString().c_str())) {
+	// decode large JPGs in the DCT domain if we just need a preview
+	if (format == "jpg" && mTargetSize.isValid() && loadScaledJpgFile(filePath, img, ba))
+		return true;
 
-		// if image has Indexed8 + alpha channel -> we crash... sorry for that
-		if (!ba || ba->isEmpty())
-			imgLoaded = img.load(mFile, suf.toStdString().c_str());
-		else
-			imgLoaded = img.loadFromData(*ba.data(), suf.toStdString().c_str());	// toStdString() in order get 1 byte per char
+	// an empty format lets Qt guess the format
+	// if image has Indexed8 + alpha channel -> we crash... sorry for that
+	if (!ba || ba->isEmpty())
+		return img.load(filePath, format.isEmpty() ? 0 : format.constData());
+	else
+		return img.loadFromData(*ba.data(), format.isEmpty() ? 0 : format.constData());
+}
 
-		if (imgLoaded) mLoader = qt_loader;
-	}
+/**
+ * Decodes a JPG with a reduced resolution.
+ * libjpeg can scale by 1/2, 1/4 and 1/8 while decoding which is
+ * considerably faster than decoding the full image (e.g. 40 MP) and resizing it.
+ * @param filePath the file path
+ * @param img the decoded image
+ * @param ba the file buffer (might be empty)
+ * @return bool false if the image was not decoded (e.g. because it is too small to be scaled)
+ **/ 
+bool DkBasicLoader::loadScaledJpgFile(const QString& filePath, QImage& img, QSharedPointer<QByteArray> ba) {
 
-	// PSD loader
-	if (!imgLoaded) {
+	QBuffer buffer;
+	QImageReader reader;
 
-		imgLoaded = loadPSDFile(mFile, ba);
-		if (imgLoaded) mLoader = psd_loader;
+	if (ba && !ba->isEmpty()) {
+		buffer.setData(*ba);
+		buffer.open(QIODevice::ReadOnly);
+		reader.setDevice(&buffer);
 	}
+	else
+		reader.setFileName(filePath);
 
-#if QT_VERSION < 0x050000	// >DIR: qt5 ships with webp : ) [23.4.2015 markus]
-	// WEBP loader
-	if (!imgLoaded) {
+	reader.setFormat("jpg");
 
-		imgLoaded = loadWebPFile(file, ba);
-		if (imgLoaded) loader = webp_loader;
-	}
-#endif
+	QSize imgSize = reader.size();
+	int denom = dctScaleDenom(imgSize, mTargetSize);
 
-	// RAW loader
-	if (!imgLoaded && !qtFormats.contains(suf.toStdString().c_str())) {
-		
-		// TODO: sometimes (e.g. _DSC6289.tif) strange opencv errors are thrown - catch them!
-		// load raw files
-		imgLoaded = loadRawFile(mFile, ba, fast);
-		if (imgLoaded) mLoader = raw_loader;
+	if (denom == 1)
+		return false;
+
+	// Qt's jpg plugin maps the scaled size to libjpeg's scale_denom
+	// libjpeg rounds up - so requesting exactly its output size prevents Qt from resampling the image
+	reader.setScaledSize(QSize((imgSize.width() + denom - 1) / denom, (imgSize.height() + denom - 1) / denom));
+	img = reader.read();
+
+	if (img.isNull())
+		return false;
+
+	mPreview = true;
+	qDebug() << "[DkBasicLoader] jpg decoded with 1 /" << denom << "of its resolution:" << img.size();
+
+	return true;
+}
+
+/**
+ * Returns the largest DCT scale denominator (1, 2, 4 or 8) so that
+ * the scaled image still covers the target size.
+ * Since the EXIF orientation is not known, the target size is checked in both orientations.
+ * @param imgSize the image size
+ * @param targetSize the size the image is displayed at
+ * @return int the scale denominator, 1 if the image should not be scaled
+ **/ 
+int DkBasicLoader::dctScaleDenom(const QSize& imgSize, const QSize& targetSize) {
+
+	if (imgSize.isEmpty() || targetSize.isEmpty())
+		return 1;
+
+	double sw = (double)targetSize.width() / imgSize.width();
+	double sh = (double)targetSize.height() / imgSize.height();
+	double swr = (double)targetSize.height() / imgSize.width();
+	double shr = (double)targetSize.width() / imgSize.height();
+	double scale = qMax(qMin(sw, sh), qMin(swr, shr));
+
+	for (int denom = 8; denom > 1; denom /= 2) {
+		if (1.0 / denom >= scale)
+			return denom;
 	}
 
-	// default Qt loader
-	if (!imgLoaded && !newSuffix.contains(QRegExp("(roh)", Qt::CaseInsensitive))) {
+	return 1;
+}
 
-		// if we first load files to buffers, we can additionally load images with wrong extensions (rainer bugfix : )
-		// TODO: add warning here
-		QByteArray lba;
-		loadFileToBuffer(mFile, lba);
-		imgLoaded = img.loadFromData(lba);
-		
-		qDebug() << "lba size: " << lba.size();
+void DkBasicLoader::setTargetSize(const QSize& size) {
+	mTargetSize = size;
+}
 
-		if (imgLoaded) mLoader = qt_loader;
-	}  
+QSize DkBasicLoader::targetSize() const {
+	return mTargetSize;
+}
 
-	// this loader is a bit buggy -> be carefull
-	if (!imgLoaded && newSuffix.contains(QRegExp("(roh)", Qt::CaseInsensitive))) {
-		
-		imgLoaded = loadRohFile(mFile, ba);
-		if (imgLoaded) mLoader = roh_loader;
+bool DkBasicLoader::isPreview() const {
+	return mPreview;
+}
 
-	} 
+/**
+ * Replaces a preview (see isPreview()) with the fully decoded image.
+ * The image is not replaced if it was edited in the meantime.
+ * @param img the full resolution image
+ * @return bool true if the preview was replaced
+ **/ 
+bool DkBasicLoader::upgradeImage(const QImage& img) {
 
-	// this loader is for OpenCV cascade training files
-	if (!imgLoaded && newSuffix.contains(QRegExp("(vec)", Qt::CaseInsensitive))) {
+	if (!mPreview || img.isNull() || mImages.size() != 1)
+		return false;
 
-		imgLoaded = loadOpenCVVecFile(mFile, ba);
-		if (imgLoaded) mLoader = roh_loader;
+	mImages[0].setImage(img);
+	mPreview = false;
 
-	} 
+	return true;
+}
 
-	//if (!imgLoaded && (training || file.suffix().contains(QRegExp("(hdr)", Qt::CaseInsensitive)))) {
+/**
+ * Takes an image which was decoded by another loader (see DkImageCache).
+ * Only the metadata is read, the image is used as is (it was rotated already).
+ * @param filePath the file path
+ * @param img the decoded image
+ * @param ba the file buffer (might be empty)
+ * @return bool true if the image was set
+ **/ 
+bool DkBasicLoader::loadCached(const QString& filePath, const QImage& img, const QSharedPointer<QByteArray> ba) {
+
+	if (img.isNull())
+		return false;
 
-	//	// load hdr here...
-	//	if (imgLoaded) loader = hdr_loader;
-	//} 
+	QFileInfo fInfo(filePath);
+	mFile = fInfo.isSymLink() ? fInfo.symLinkTarget() : filePath;
 
-	// tiff things
-	if (imgLoaded && !mPageIdxDirty)
-		indexPages(mFile);
-	mPageIdxDirty = false;
+	release();
 
-	if (imgLoaded && loadMetaData && mMetaData) {
-		
+	if (mMetaData) {
 		try {
+			mMetaData->readMetaData(filePath, ba);
 			mMetaData->setQtValues(img);
-		
-			if (orientation != -1 && !mMetaData->isTiff() && !Settings::param().metaData().ignoreExifOrientation)
-				img = rotate(img, orientation);
-
-		} catch(...) {}	// ignore if we cannot read the metadata
-	}
-	else if (!mMetaData) {
-		qDebug() << "metaData is NULL!";
+		}
+		catch (...) {}	// ignore if we cannot read the metadata
 	}
 
-	if (imgLoaded)
-		setEditImage(img, tr("Original Image"));
+	indexPages(mFile);
+	mPageIdxDirty = false;
 
-	//qDebug() << qImg.text();
+	setEditImage(img, tr("Original Image"));
 
-	return imgLoaded;
+	return true;
+}
+
+/**
+ * Replaces the original image with the same image owned by the DkImageCache.
+ * Our own copy is freed if the image is not edited.
+ * @param img the cached image
+ * @return bool true if the image was replaced
+ **/ 
+bool DkBasicLoader::shareImage(const QImage& img) {
+
+	if (mPreview || mImages.empty() || img.isNull())
+		return false;
+
+	QImage cImg = mImages[0].image();
+
+	if (img.cacheKey() == cImg.cacheKey() || img.size() != cImg.size() || img.format() != cImg.format())
+		return false;
+
+	mImages[0].setImage(img);
+
+	return true;
+}
+
+/**
+ * Downscales the image so that it fits the target size.
+ * Slideshows preload screen sized images so that they can be faded
+ * without resampling. Since the image is marked as preview, it is
+ * upgraded to full resolution if the user stays with it.
+ * @return bool true if the image was scaled
+ **/ 
+bool DkBasicLoader::prescale() {
+
+	if (mPreview || mTargetSize.isEmpty() || mImages.size() != 1)
+		return false;
+
+	QImage img = mImages[0].image();
+	QSize s = img.size().scaled(mTargetSize, Qt::KeepAspectRatio);
+
+	if (s.isEmpty() || s.width() >= img.width())
+		return false;
+
+	mImages[0].setImage(img.scaled(s, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+	mPreview = true;
+
+	return true;
+}
+
+/**
+ * Returns the first bytes of a file which are needed to identify its format.
+ * @param filePath the file path
+ * @param ba the file buffer - if it is not empty, the file is not read
+ * @return QByteArray the header
+ **/ 
+QByteArray DkBasicLoader::loadFileHeader(const QString& filePath, QSharedPointer<QByteArray> ba) const {
+
+	if (ba && !ba->isEmpty())
+		return ba->left(DkDecoderRegistry::header_size);
+
+	QFile file(filePath);
+	
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+
+	return file.read(DkDecoderRegistry::header_size);
 }
 
 /**
@@ -412,12 +601,17 @@ bool DkBasicLoader::loadRawFile(const QString& filePath, QSharedPointer<QByteArr
 	DkTimer dt;
 	QImage img;
 
+	// if a preview is requested, we show the embedded preview first - the full RAW is decoded later on
+	bool previewRequested = !fast && mTargetSize.isValid() && Settings::param().resources().loadRawThumb != DkSettings::raw_thumb_always;
+
 	try {
 
 		// try to get preview image from exiv2
 		if (mMetaData) {
-			if (fast || Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_always ||
-				Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_if_large) {
+			bool thumbOnly = fast || Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_always ||
+				Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_if_large;
+
+			if (thumbOnly || previewRequested) {
 
 				mMetaData->readMetaData(filePath, ba);
 
@@ -427,12 +621,14 @@ bool DkBasicLoader::loadRawFile(const QString& filePath, QSharedPointer<QByteArr
 				if (Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_if_large)
 					minWidth = 1920;
 #endif
-				img = mMetaData->getPreviewImage(minWidth);
+				img = mMetaData->getPreviewImage(previewRequested ? 0 : minWidth);
 
 				if (!img.isNull()) {
 					
+					// a small preview is just a preview if the user wants large previews only
+					mPreview = previewRequested && (!thumbOnly || qMax(img.width(), img.height()) < minWidth);
 					setEditImage(img, tr("Original Image"));
-					qDebug() << "[RAW] loaded with exiv2";
+					qDebug() << "[RAW] loaded with exiv2" << (mPreview ? "(preview)" : "");
 					return true;
 				}
 			}
@@ -477,8 +673,10 @@ bool DkBasicLoader::loadRawFile(const QString& filePath, QSharedPointer<QByteArr
 		// TODO: check actual screen resolution
 		qDebug() << "max thumb size: " << tM;
 
-		if (fast || Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_always ||
-			(Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_if_large && tM >= 1920)) {
+		bool thumbOnly = fast || Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_always ||
+			(Settings::param().resources().loadRawThumb == DkSettings::raw_thumb_if_large && tM >= 1920);
+
+		if (thumbOnly || previewRequested) {
 
 			// crashes here if image is broken
 			int err = iProcessor.unpack_thumb();
@@ -490,8 +688,9 @@ bool DkBasicLoader::loadRawFile(const QString& filePath, QSharedPointer<QByteArr
 
 				if (!img.isNull()) {
 					imgLoaded = true;
+					mPreview = !thumbOnly;
 					setEditImage(img, tr("Original Image"));
-					qDebug() << "[RAW] I loaded the RAW's thumbnail";
+					qDebug() << "[RAW] I loaded the RAW's thumbnail" << (mPreview ? "(preview)" : "");
 
 					return imgLoaded;
 				}
@@ -1109,6 +1308,8 @@ void DkBasicLoader::setHistoryIndex(int idx) {
 
 void DkBasicLoader::loadFileToBuffer(const QString& fileInfo, QByteArray& ba) const {
 
+	DK_TRACE("load", "loadFileToBuffer");
+
 #ifdef WITH_QUAZIP
 	if (QFileInfo(fileInfo).dir().path().contains(DkZipContainer::zipMarker())) 
 		DkZipContainer::extractImage(DkZipContainer::decodeZipFile(fileInfo), DkZipContainer::decodeImageFile(fileInfo), ba);
@@ -1122,6 +1323,8 @@ void DkBasicLoader::loadFileToBuffer(const QString& fileInfo, QByteArray& ba) co
 
 QSharedPointer<QByteArray> DkBasicLoader::loadFileToBuffer(const QString& fileInfo) const {
 
+	DK_TRACE("load", "loadFileToBuffer");
+
 #ifdef WITH_QUAZIP
 	if (QFileInfo(fileInfo).dir().path().contains(DkZipContainer::zipMarker())) 
 		return DkZipContainer::extractImage(DkZipContainer::decodeZipFile(fileInfo), DkZipContainer::decodeImageFile(fileInfo));
@@ -1480,6 +1683,7 @@ void DkBasicLoader::release(bool clear) {
 	saveMetaData(mFile);
 
 	mImages.clear();
+	mPreview = false;
 	//metaData.clear();
 	
 	// TODO: where should we clear the metadata?
@@ -1739,6 +1943,270 @@ bool DkBasicLoader::saveWindowsIcon(const QImage& img, QSharedPointer<QByteArray
 
 #endif
 
+// DkImageDecoder --------------------------------------------------------------------
+DkImageDecoder::DkImageDecoder(int id, const QString& name, int capabilities) {
+
+	mId = id;
+	mName = name;
+	mCapabilities = capabilities;
+}
+
+int DkImageDecoder::id() const {
+	return mId;
+}
+
+QString DkImageDecoder::name() const {
+	return mName;
+}
+
+int DkImageDecoder::capabilities() const {
+	return mCapabilities;
+}
+
+bool DkImageDecoder::hasCapability(Capability cap) const {
+	return (mCapabilities & cap) != 0;
+}
+
+void DkImageDecoder::addCall(double sec, bool loaded) {
+
+	mNumCalls++;
+	mTotalTime += sec;
+
+	if (loaded)
+		mNumLoaded++;
+}
+
+int DkImageDecoder::numCalls() const {
+	return mNumCalls;
+}
+
+int DkImageDecoder::numLoaded() const {
+	return mNumLoaded;
+}
+
+double DkImageDecoder::totalTime() const {
+	return mTotalTime;
+}
+
+QString DkImageDecoder::toString() const {
+
+	double meanMs = mNumCalls ? mTotalTime / mNumCalls * 1000.0 : 0.0;
+
+	return mName + ": " + QString::number(mNumLoaded) + "/" + QString::number(mNumCalls) + 
+		" loaded, total: " + QString::number(mTotalTime, 'f', 3) + " sec, mean: " + QString::number(meanMs, 'f', 1) + " ms";
+}
+
+// DkDecoderRegistry --------------------------------------------------------------------
+DkDecoderRegistry::DkDecoderRegistry() {
+
+	mQtFormats = QImageReader::supportedImageFormats();
+
+	int qtCaps = DkImageDecoder::cap_scaled | DkImageDecoder::cap_region | DkImageDecoder::cap_metadata;
+#ifdef WITH_LIBTIFF
+	qtCaps |= DkImageDecoder::cap_multi_page;
+#endif
+
+	// the order defines the priority if several decoders can handle a format
+	registerDecoder(DkImageDecoder(DkBasicLoader::qt_loader, "Qt", qtCaps));
+	registerDecoder(DkImageDecoder(DkBasicLoader::psd_loader, "PSD"));
+#ifdef WITH_WEBP
+	registerDecoder(DkImageDecoder(DkBasicLoader::webp_loader, "WebP", DkImageDecoder::cap_scaled | DkImageDecoder::cap_region | DkImageDecoder::cap_metadata));
+#endif
+	registerDecoder(DkImageDecoder(DkBasicLoader::raw_loader, "RAW", DkImageDecoder::cap_scaled | DkImageDecoder::cap_metadata));
+	registerDecoder(DkImageDecoder(DkBasicLoader::roh_loader, "ROH"));
+#ifdef WITH_OPENCV
+	registerDecoder(DkImageDecoder(DkBasicLoader::vec_loader, "OpenCV vec"));
+#endif
+}
+
+DkDecoderRegistry& DkDecoderRegistry::instance() {
+
+	static DkDecoderRegistry inst;
+	return inst;
+}
+
+void DkDecoderRegistry::registerDecoder(const DkImageDecoder& decoder) {
+
+	mDecoders.append(decoder);
+}
+
+/**
+ * Identifies the image format by its magic bytes.
+ * @param header the first bytes of the file (see header_size)
+ * @return QByteArray the format in Qt notation (e.g. jpg, png), raw, psd or an empty string if unknown
+ **/ 
+QByteArray DkDecoderRegistry::sniffFormat(const QByteArray& header) const {
+
+	if (header.size() < 4)
+		return QByteArray();
+
+	if (header.startsWith("\xff\xd8\xff"))
+		return "jpg";
+	if (header.startsWith("\x89PNG"))
+		return "png";
+	if (header.startsWith("GIF8"))
+		return "gif";
+	if (header.startsWith("8BPS"))
+		return "psd";
+	if (header.startsWith("RIFF") && header.mid(8, 4) == "WEBP")
+		return "webp";
+	if (header.startsWith("IIRO") || header.startsWith("IIRS") || header.startsWith("MMOR") ||	// Olympus
+		header.startsWith(QByteArray("IIU\0", 4)) ||											// Panasonic
+		header.startsWith("FUJIFILM") ||															// Fujifilm
+		header.startsWith("FOVb") ||																// Sigma
+		header.startsWith(QByteArray("\0MRM", 4)) ||											// Minolta
+		header.mid(6, 8) == "HEAPCCDR")															// Canon CRW
+		return "raw";
+	if (header.startsWith(QByteArray("II*\0", 4)) || header.startsWith(QByteArray("MM\0*", 4)))
+		return "tif";	// NOTE: most RAW formats are TIFF based too
+	if (header.startsWith(QByteArray("\0\0\0\x0cjP  ", 8)))
+		return "jp2";
+	// uncompressed true-color TGAs start with 0 0 2 0 too - so we need a non-zero image count
+	bool hasIconCount = header.size() >= 6 && (header[4] != 0 || header[5] != 0);
+	if (header.startsWith(QByteArray("\0\0\1\0", 4)) && hasIconCount)
+		return "ico";
+	if (header.startsWith(QByteArray("\0\0\2\0", 4)) && hasIconCount)
+		return "cur";
+	if (header.startsWith("icns"))
+		return "icns";
+	if (header.startsWith("DDS "))
+		return "dds";
+	if (header.startsWith("BM"))
+		return "bmp";
+	if (header[0] == 'P' && header[1] >= '1' && header[1] <= '6' && QChar::fromLatin1(header[2]).isSpace()) {
+		if (header[1] == '1' || header[1] == '4')
+			return "pbm";
+		if (header[1] == '2' || header[1] == '5')
+			return "pgm";
+		return "ppm";
+	}
+	if (header.contains("<svg"))
+		return "svg";
+	if (header.contains("/* XPM */"))
+		return "xpm";
+
+	return QByteArray();
+}
+
+/**
+ * Returns the decoders that should be tried in the given order.
+ * @param header the first bytes of the file
+ * @param suffix the file's suffix (lower case)
+ * @param format the identified format in Qt notation
+ * @return QVector<int> the ids of the decoders (see DkBasicLoader::loaderID)
+ **/ 
+QVector<int> DkDecoderRegistry::findDecoders(const QByteArray& header, const QString& suffix, QByteArray& format) const {
+
+	QVector<int> ids;
+	format = sniffFormat(header);
+
+	if (format == "psd")
+		ids << DkBasicLoader::psd_loader;
+	else if (format == "raw")
+		ids << DkBasicLoader::raw_loader;
+	else if (format == "tif") {
+		// TIFF based RAW files (nef, cr2, dng...)
+		if (isRawSuffix(suffix) || !mQtFormats.contains(suffix.toLatin1()))
+			ids << DkBasicLoader::raw_loader;
+		ids << DkBasicLoader::qt_loader;
+	}
+	else if (format == "webp" && !mQtFormats.contains(format)) {
+		ids << DkBasicLoader::webp_loader;
+	}
+	else if (!format.isEmpty()) {
+		ids << DkBasicLoader::qt_loader;
+	}
+	// formats without magic bytes
+	else if (suffix == "roh")
+		ids << DkBasicLoader::roh_loader;
+	else if (suffix == "vec")
+		ids << DkBasicLoader::vec_loader;
+	else if (mQtFormats.contains(suffix.toLatin1())) {
+		format = suffix.toLatin1();	// e.g. tga - Qt knows it by its suffix
+		ids << DkBasicLoader::qt_loader;
+	}
+	else {
+		// unknown: libraw knows more formats than we do & Qt can guess the rest
+		ids << DkBasicLoader::raw_loader;
+		ids << DkBasicLoader::qt_loader;
+	}
+
+	// remove decoders that are not compiled
+	QMutexLocker locker(&mMutex);
+	QVector<int> available;
+	for (int id : ids) {
+		for (const DkImageDecoder& d : mDecoders) {
+			if (d.id() == id) {
+				available << id;
+				break;
+			}
+		}
+	}
+
+	return available;
+}
+
+bool DkDecoderRegistry::isRawSuffix(const QString& suffix) const {
+
+	if (suffix.isEmpty())
+		return false;
+
+	for (const QString& filter : Settings::param().app().rawFilters) {
+		if (filter.contains("*." + suffix + " ") || filter.contains("*." + suffix + ")"))
+			return true;
+	}
+
+	return false;
+}
+
+DkImageDecoder DkDecoderRegistry::decoder(int id) const {
+
+	QMutexLocker locker(&mMutex);
+
+	for (const DkImageDecoder& d : mDecoders) {
+		if (d.id() == id)
+			return d;
+	}
+
+	return DkImageDecoder();
+}
+
+QVector<DkImageDecoder> DkDecoderRegistry::decoders() const {
+
+	QMutexLocker locker(&mMutex);
+	return mDecoders;
+}
+
+/**
+ * Updates the timing counters of a decoder.
+ * This function is thread-safe.
+ * @param id the decoder's id
+ * @param sec the decoding time in seconds
+ * @param loaded true if the decoder could load the image
+ **/ 
+void DkDecoderRegistry::addTiming(int id, double sec, bool loaded) {
+
+	QMutexLocker locker(&mMutex);
+
+	for (DkImageDecoder& d : mDecoders) {
+		if (d.id() == id) {
+			d.addCall(sec, loaded);
+			break;
+		}
+	}
+}
+
+QString DkDecoderRegistry::timingReport() const {
+
+	QMutexLocker locker(&mMutex);
+
+	QStringList report;
+	for (const DkImageDecoder& d : mDecoders)
+		report << d.toString();
+
+	return report.join("\n");
+}
+
 // FileDownloader --------------------------------------------------------------------
 FileDownloader::FileDownloader(QUrl imageUrl, QObject *parent) : QObject(parent) {
 	QNetworkProxyQuery npq(QUrl("http://www.nomacs.org"));
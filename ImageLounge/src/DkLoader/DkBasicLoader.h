@@ -32,6 +32,8 @@
 #include <QSharedPointer>
 #include <QUrl>
 #include <QImage>
+#include <QMutex>
+#include <QVector>
 #pragma warning(pop)
 
 #pragma warning(disable: 4251)	// TODO: remove
@@ -134,6 +136,7 @@ public:
 		raw_loader,
 		roh_loader,
 		hdr_loader,
+		vec_loader,
 	};
 
 	DkBasicLoader(int mode = mode_default);
@@ -154,6 +157,27 @@ public:
 	 * @return bool true if the image was loaded
 	 **/
 	bool loadGeneral(const QString& filePath, const QSharedPointer<QByteArray> ba, bool loadMetaData = false, bool fast = false);
+	bool loadCached(const QString& filePath, const QImage& img, const QSharedPointer<QByteArray> ba);
+	bool shareImage(const QImage& img);
+
+	/**
+	 * Sets the size the image is displayed at.
+	 * If set, JPGs are decoded with a reduced resolution (1/2, 1/4 or 1/8)
+	 * that still covers this size. Pass an invalid size to always decode the full image.
+	 * @param size the target size
+	 **/
+	void setTargetSize(const QSize& size);
+	QSize targetSize() const;
+
+	/**
+	 * Returns true if the current image was decoded with a reduced resolution.
+	 * @return bool true if the image is a preview
+	 **/
+	bool isPreview() const;
+	bool upgradeImage(const QImage& img);
+	bool prescale();
+
+	static int dctScaleDenom(const QSize& imgSize, const QSize& targetSize);
 
 	/**
 	 * Loads the page requested (with respect to the current page)
@@ -291,6 +315,10 @@ public slots:
 	QImage rotate(const QImage& img, int orientation);
 
 protected:
+	bool loadWithDecoder(int loaderId, const QString& filePath, const QByteArray& format, QImage& img, QSharedPointer<QByteArray> ba, bool fast);
+	bool loadQtFile(const QString& filePath, const QByteArray& format, QImage& img, QSharedPointer<QByteArray> ba);
+	bool loadScaledJpgFile(const QString& filePath, QImage& img, QSharedPointer<QByteArray> ba);
+	QByteArray loadFileHeader(const QString& filePath, QSharedPointer<QByteArray> ba) const;
 	bool loadRohFile(const QString& filePath, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
 	bool loadRawFile(const QString& filePath, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>(), bool fast = false);
 	void indexPages(const QString& filePath);
@@ -307,6 +335,82 @@ protected:
 	QSharedPointer<DkMetaDataT> mMetaData;
 	QVector<DkEditImage> mImages;
 	int mImageIndex = 0;
+	QSize mTargetSize;
+	bool mPreview = false;
+};
+
+/**
+ * Describes an image decoder of DkBasicLoader.
+ * Besides its capabilities it counts how often it was
+ * called and how long decoding took.
+ **/ 
+class DllLoaderExport DkImageDecoder {
+
+public:
+	enum Capability {
+		cap_none		= 0x00,
+		cap_scaled		= 0x01,	// can decode at a reduced resolution
+		cap_region		= 0x02,	// can decode a region of interest
+		cap_multi_page	= 0x04,	// can decode multiple pages
+		cap_metadata	= 0x08,	// metadata is readable by Exiv2
+	};
+
+	DkImageDecoder(int id = DkBasicLoader::no_loader, const QString& name = QString(), int capabilities = cap_none);
+
+	int id() const;
+	QString name() const;
+	int capabilities() const;
+	bool hasCapability(Capability cap) const;
+
+	void addCall(double sec, bool loaded);
+	int numCalls() const;
+	int numLoaded() const;
+	double totalTime() const;
+	QString toString() const;
+
+protected:
+	int mId;
+	QString mName;
+	int mCapabilities;
+
+	int mNumCalls = 0;
+	int mNumLoaded = 0;
+	double mTotalTime = 0.0;
+};
+
+/**
+ * Identifies image formats by their magic bytes.
+ * DkBasicLoader asks the registry which decoders should be
+ * used for a file so that it does not have to try them all.
+ **/ 
+class DllLoaderExport DkDecoderRegistry {
+
+public:
+	static DkDecoderRegistry& instance();
+
+	enum {
+		header_size = 512,	// number of bytes needed for sniffing
+	};
+
+	QVector<int> findDecoders(const QByteArray& header, const QString& suffix, QByteArray& format) const;
+	QByteArray sniffFormat(const QByteArray& header) const;
+
+	DkImageDecoder decoder(int id) const;
+	QVector<DkImageDecoder> decoders() const;
+	void addTiming(int id, double sec, bool loaded);
+	QString timingReport() const;
+
+protected:
+	DkDecoderRegistry();
+	DkDecoderRegistry(DkDecoderRegistry const&);	// hide
+	void operator=(DkDecoderRegistry const&);		// hide
+
+	void registerDecoder(const DkImageDecoder& decoder);
+	bool isRawSuffix(const QString& suffix) const;
+
+	QVector<DkImageDecoder> mDecoders;
+	QList<QByteArray> mQtFormats;
+	mutable QMutex mMutex;
 };
 
 // file downloader from: http://qt-project.org/wiki/Download_Data_from_URL
@@ -0,0 +1,349 @@
+/*******************************************************************************************************
+ DkDirScanner.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkDirScanner.h"
+
+#include "DkSettings.h"
+#include "DkUtils.h"
+#include "DkTimer.h"
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#pragma warning(pop)	// no warnings from includes - end
+
+namespace nmc {
+
+// DkSuffixFilter --------------------------------------------------------------------
+DkSuffixFilter::DkSuffixFilter(const QStringList& filters) {
+
+	for (const QString& filter : filters) {
+
+		QString suffix = filter.trimmed().toLower();
+
+		if (suffix.startsWith("*."))
+			suffix.remove(0, 2);
+		else if (suffix.startsWith("."))
+			suffix.remove(0, 1);
+
+		if (suffix.isEmpty())
+			continue;
+
+		if (suffix.contains(QRegExp("[*?\\[]")))
+			mWildcards << QRegExp(filter.trimmed(), Qt::CaseInsensitive, QRegExp::Wildcard);
+		else
+			mSuffixes.insert(suffix);
+	}
+}
+
+/**
+ * Checks if a file name matches the filters.
+ * All suffixes are checked, so *.tar.gz matches too.
+ * @param fileName the file name (not the path).
+ * @return bool true if the file matches.
+ **/
+bool DkSuffixFilter::matches(const QString& fileName) const {
+
+	for (int idx = fileName.indexOf('.'); idx != -1; idx = fileName.indexOf('.', idx + 1)) {
+
+		if (mSuffixes.contains(fileName.mid(idx + 1).toLower()))
+			return true;
+	}
+
+	for (const QRegExp& wildcard : mWildcards) {
+
+		QRegExp exp = wildcard;		// QRegExp keeps a match state - don't share it between threads
+		if (exp.exactMatch(fileName))
+			return true;
+	}
+
+	return false;
+}
+
+// DkDirScanRunnable --------------------------------------------------------------------
+class DkDirScanRunnable : public QRunnable {
+
+public:
+	DkDirScanRunnable(DkDirScanner* scanner, const QString& dirPath, int generation) :
+		mScanner(scanner), mDirPath(dirPath), mGeneration(generation) {};
+
+	void run() override {
+		mScanner->scanFolder(mDirPath, mGeneration);
+	};
+
+protected:
+	DkDirScanner* mScanner;
+	QString mDirPath;
+	int mGeneration;
+};
+
+// DkDirScanner --------------------------------------------------------------------
+DkDirScanner::DkDirScanner(QObject* parent) : QObject(parent) {
+
+	// scanning is I/O bound - don't block the global pool (image loading, thumbnails)
+	mPool.setMaxThreadCount(max_threads);
+}
+
+DkDirScanner::~DkDirScanner() {
+
+	cancel();
+	mPool.waitForDone();
+}
+
+/**
+ * Starts scanning a directory tree.
+ * A running scan is cancelled.
+ * @param rootDirPath the root directory.
+ * @param maxFolders the maximal number of sub folders (-1 for no limit).
+ **/
+void DkDirScanner::scan(const QString& rootDirPath, int maxFolders) {
+
+	int generation = mGeneration.fetchAndAddOrdered(1) + 1;
+
+	QMutexLocker locker(&mMutex);
+	mRootDirPath = rootDirPath;
+	mFolders.clear();
+	mFilter = DkSuffixFilter(Settings::param().app().browseFilters);
+	mMaxFolders = maxFolders;
+	mPending = 0;
+	locker.unlock();
+
+	enqueue(rootDirPath, generation);
+}
+
+/**
+ * Cancels the current scan and discards its results.
+ **/
+void DkDirScanner::cancel() {
+
+	mGeneration.fetchAndAddOrdered(1);
+
+	QMutexLocker locker(&mMutex);
+	mRootDirPath.clear();
+	mFolders.clear();
+	mPending = 0;
+}
+
+/**
+ * Blocks until the current scan is finished.
+ **/
+void DkDirScanner::waitForFinished() {
+
+	mPool.waitForDone();
+}
+
+bool DkDirScanner::isScanning() const {
+
+	QMutexLocker locker(&mMutex);
+	return mPending > 0;
+}
+
+QString DkDirScanner::rootDirPath() const {
+
+	QMutexLocker locker(&mMutex);
+	return mRootDirPath;
+}
+
+/**
+ * Returns all folders found so far (including the root directory).
+ * @return QStringList the folders sorted logically.
+ **/
+QStringList DkDirScanner::folders() const {
+
+	QMutexLocker locker(&mMutex);
+	QStringList folders = mFolders.keys();
+	locker.unlock();
+
+	qSort(folders.begin(), folders.end(), DkUtils::compLogicQString);
+
+	return folders;
+}
+
+/**
+ * Returns the number of images in a folder.
+ * @param dirPath the folder.
+ * @return int the number of images or -1 if the folder is not scanned (yet).
+ **/
+int DkDirScanner::numImages(const QString& dirPath) const {
+
+	QMutexLocker locker(&mMutex);
+	return mFolders.value(dirPath, -1);
+}
+
+void DkDirScanner::enqueue(const QString& dirPath, int generation) {
+
+	QMutexLocker locker(&mMutex);
+
+	if (generation != mGeneration.load() || mFolders.contains(dirPath))
+		return;
+
+	// the root directory is not counted
+	if (mMaxFolders >= 0 && mFolders.size() > mMaxFolders) {
+		qDebug() << "[DkDirScanner] folder limit reached, ignoring: " << dirPath;
+		return;
+	}
+
+	mFolders.insert(dirPath, -1);
+	mPending++;
+	locker.unlock();
+
+	mPool.start(new DkDirScanRunnable(this, dirPath, generation));
+}
+
+void DkDirScanner::scanFolder(const QString& dirPath, int generation) {
+
+	// cancelled?
+	if (generation != mGeneration.load())
+		return;
+
+	DK_TRACE("scan", "scanFolder");
+
+	QMutexLocker locker(&mMutex);
+	DkSuffixFilter filter = mFilter;
+	locker.unlock();
+
+	QStringList subDirs;
+	QStringList fileNames = listDir(dirPath, filter, &subDirs);
+
+	// enqueue the sub folders before we are done - so that the scan does not finish early
+	QString basePath = dirPath.endsWith("/") ? dirPath : dirPath + "/";
+	for (const QString& subDir : subDirs)
+		enqueue(basePath + subDir, generation);
+
+	locker.relock();
+
+	if (generation != mGeneration.load())
+		return;
+
+	mFolders.insert(dirPath, fileNames.size());
+	bool finished = --mPending == 0;
+	locker.unlock();
+
+	emit folderScanned(dirPath, fileNames.size());
+
+	if (finished)
+		emit scanFinished();
+}
+
+/**
+ * Lists the images and sub folders of a directory.
+ * The entry types are taken from the directory listing,
+ * files are only stat'ed if the file system does not report their type.
+ * Hidden and linked folders are not reported.
+ * @param dirPath the directory.
+ * @param filter the image filter.
+ * @param subDirs if not 0, the sub folder names are appended.
+ * @return QStringList the (unsorted) image file names.
+ **/
+QStringList DkDirScanner::listDir(const QString& dirPath, const DkSuffixFilter& filter, QStringList* subDirs) {
+
+	QStringList fileNames;
+
+#ifdef WIN32
+
+	QString winPath = QDir::toNativeSeparators(dirPath) + "\\*.*";
+
+	WIN32_FIND_DATAW findFileData;
+	HANDLE handle = FindFirstFileW(reinterpret_cast<const wchar_t *>(winPath.utf16()), &findFileData);
+
+	if (handle == INVALID_HANDLE_VALUE)
+		return fileNames;
+
+	do {
+		QString fileName = QString::fromWCharArray(findFileData.cFileName);
+		DWORD attributes = findFileData.dwFileAttributes;
+
+		if (fileName == "." || fileName == "..")
+			continue;
+
+		if (attributes & FILE_ATTRIBUTE_DIRECTORY) {
+			if (subDirs && !(attributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_REPARSE_POINT)))
+				subDirs->append(fileName);
+		}
+		else if (filter.matches(fileName))
+			fileNames.append(fileName);
+
+	} while (FindNextFileW(handle, &findFileData) != 0);
+
+	FindClose(handle);
+
+#else
+
+	QByteArray encodedPath = QFile::encodeName(dirPath);
+	DIR* dir = opendir(encodedPath.constData());
+
+	if (!dir)
+		return fileNames;
+
+	encodedPath += '/';
+
+	while (struct dirent* entry = readdir(dir)) {
+
+		// hidden files, . and ..
+		if (entry->d_name[0] == '.')
+			continue;
+
+		unsigned char type = entry->d_type;
+
+		// some (network) file systems do not report the type
+		if (type == DT_UNKNOWN) {
+
+			struct stat st;
+			if (lstat((encodedPath + entry->d_name).constData(), &st) != 0)
+				continue;
+
+			type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISLNK(st.st_mode) ? DT_LNK : DT_REG);
+		}
+
+		QString fileName = QFile::decodeName(entry->d_name);
+
+		if (type == DT_DIR) {
+			if (subDirs)
+				subDirs->append(fileName);
+		}
+		else if (filter.matches(fileName))
+			fileNames.append(fileName);
+	}
+
+	closedir(dir);
+
+#endif
+
+	return fileNames;
+}
+
+}
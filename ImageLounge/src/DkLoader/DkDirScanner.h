@@ -0,0 +1,122 @@
+/*******************************************************************************************************
+ DkDirScanner.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QObject>
+#include <QStringList>
+#include <QSet>
+#include <QHash>
+#include <QVector>
+#include <QRegExp>
+#include <QMutex>
+#include <QThreadPool>
+#include <QAtomicInt>
+#pragma warning(pop)	// no warnings from includes - end
+
+#ifndef DllLoaderExport
+#ifdef DK_LOADER_DLL_EXPORT
+#define DllLoaderExport Q_DECL_EXPORT
+#elif DK_DLL_IMPORT
+#define DllLoaderExport Q_DECL_IMPORT
+#else
+#define DllLoaderExport Q_DECL_IMPORT
+#endif
+#endif
+
+namespace nmc {
+
+/**
+ * Matches file names against file filters (e.g. *.jpg).
+ * Plain suffix filters are looked up in a hash set,
+ * only filters with other wildcards fall back to a QRegExp.
+ **/
+class DllLoaderExport DkSuffixFilter {
+
+public:
+	DkSuffixFilter(const QStringList& filters = QStringList());
+
+	bool matches(const QString& fileName) const;
+
+protected:
+	QSet<QString> mSuffixes;		// lower case, without the leading *.
+	QVector<QRegExp> mWildcards;
+};
+
+/**
+ * Walks directory trees with several threads.
+ * Every folder is listed by a worker (readdir/FindFirstFile), its
+ * sub folders are queued again so that wide trees are listed in parallel.
+ * folderScanned() is emitted as soon as a folder is listed, hence
+ * the first folders can be used while the scan continues.
+ **/
+class DllLoaderExport DkDirScanner : public QObject {
+	Q_OBJECT
+
+public:
+	DkDirScanner(QObject* parent = 0);
+	~DkDirScanner();
+
+	void scan(const QString& rootDirPath, int maxFolders = -1);
+	void cancel();
+	void waitForFinished();
+	bool isScanning() const;
+
+	QString rootDirPath() const;
+	QStringList folders() const;
+	int numImages(const QString& dirPath) const;
+
+	static QStringList listDir(const QString& dirPath, const DkSuffixFilter& filter, QStringList* subDirs = 0);
+
+	enum {
+		max_threads = 4,
+	};
+
+signals:
+	void folderScanned(const QString& dirPath, int numImages) const;
+	void scanFinished() const;
+
+protected:
+	friend class DkDirScanRunnable;
+
+	void enqueue(const QString& dirPath, int generation);
+	void scanFolder(const QString& dirPath, int generation);
+
+	QThreadPool mPool;
+	mutable QMutex mMutex;
+	QAtomicInt mGeneration;
+
+	// guarded by mMutex
+	QString mRootDirPath;
+	QHash<QString, int> mFolders;	// folder -> number of images (-1 if not listed yet)
+	DkSuffixFilter mFilter;
+	int mMaxFolders = -1;
+	int mPending = 0;
+};
+
+};
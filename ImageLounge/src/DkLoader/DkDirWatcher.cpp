@@ -0,0 +1,327 @@
+/*******************************************************************************************************
+ DkDirWatcher.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkDirWatcher.h"
+
+#include "DkSettings.h"
+#include "DkTimer.h"
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QFileInfo>
+#include <QFile>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#include <limits.h>
+#endif
+#pragma warning(pop)	// no warnings from includes - end
+
+namespace nmc {
+
+DkDirWatcher::DkDirWatcher(QObject* parent) : QObject(parent) {
+
+	mDebounceTimer.setSingleShot(true);
+	mDebounceTimer.setInterval(debounce_ms);
+	connect(&mDebounceTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+	mPollTimer.setInterval(poll_ms);
+	connect(&mPollTimer, SIGNAL(timeout()), this, SLOT(pollCurrentFile()));
+
+#ifdef Q_OS_LINUX
+	mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (mFd != -1) {
+		mNotifier = new QSocketNotifier(mFd, QSocketNotifier::Read, this);
+		connect(mNotifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+	}
+	else
+		qWarning() << "[DkDirWatcher] inotify is not available - falling back to QFileSystemWatcher";
+#endif
+
+	if (mFd == -1) {
+		mWatcher = new QFileSystemWatcher(this);
+		connect(mWatcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(watcherDirChanged(const QString&)));
+	}
+}
+
+DkDirWatcher::~DkDirWatcher() {
+
+	clearWatch();
+
+#ifdef Q_OS_LINUX
+	if (mFd != -1)
+		close(mFd);
+#endif
+}
+
+/**
+ * Starts watching a directory (the previous directory is not watched anymore).
+ * @param dirPath the directory.
+ **/
+void DkDirWatcher::setDirPath(const QString& dirPath) {
+
+	if (dirPath == mDirPath)
+		return;
+
+	clearWatch();
+	mDirPath = dirPath;
+	mFilter = DkSuffixFilter(Settings::param().app().browseFilters);
+
+	if (mDirPath.isEmpty())
+		return;
+
+	if (mWatcher) {
+		mWatcher->addPath(mDirPath);
+		return;
+	}
+
+#ifdef Q_OS_LINUX
+	// we want completely written files only (no IN_CREATE/IN_MODIFY)
+	mWd = inotify_add_watch(mFd, QFile::encodeName(mDirPath).constData(),
+		IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+
+	if (mWd == -1)
+		qWarning() << "[DkDirWatcher] cannot watch" << mDirPath;
+#endif
+}
+
+QString DkDirWatcher::dirPath() const {
+	return mDirPath;
+}
+
+/**
+ * Sets the file that is polled if file changes cannot be reported.
+ * Files on network file systems are polled in any case.
+ * @param filePath the currently displayed file.
+ * @param poll if true, the file is polled in any case (e.g. archives).
+ **/
+void DkDirWatcher::setCurrentFile(const QString& filePath, bool poll) {
+
+	if (!mWatcher && !poll && !isNetworkPath(filePath)) {
+		mCurrentFile.clear();
+		mPollTimer.stop();
+		return;
+	}
+
+	mCurrentFile = filePath;
+
+	QFileInfo fileInfo(filePath);
+	mCurrentExists = fileInfo.exists();
+	mCurrentModified = fileInfo.lastModified();
+
+	if (filePath.isEmpty())
+		mPollTimer.stop();
+	else if (!mPollTimer.isActive())
+		mPollTimer.start();
+}
+
+/**
+ * Returns true if single file changes are reported (filesChanged()).
+ * Otherwise only dirChanged() is emitted.
+ * @return bool true if the inotify backend is used.
+ **/
+bool DkDirWatcher::isIncremental() const {
+	return mWatcher == 0;
+}
+
+void DkDirWatcher::readEvents() {
+
+#ifdef Q_OS_LINUX
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	bool dirChangedEvent = false;
+	bool watchRemoved = false;
+
+	for (;;) {
+
+		ssize_t len = read(mFd, buffer, sizeof(buffer));
+
+		if (len <= 0)
+			break;
+
+		for (char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len) {
+
+			const struct inotify_event* event = (const struct inotify_event*)ptr;
+
+			// events of previous directories
+			if (event->wd != mWd && !(event->mask & IN_Q_OVERFLOW))
+				continue;
+
+			// the event queue overflowed or the directory itself was (re)moved
+			if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+				dirChangedEvent = true;
+
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+				watchRemoved = true;
+			else if (event->len > 0 && !(event->mask & IN_ISDIR))
+				addEvent(QFile::decodeName(event->name));
+		}
+	}
+
+	if (dirChangedEvent) {
+		QString dirPath = mDirPath;
+
+		// the watch is gone - the next setDirPath() adds it again (e.g. if the folder is recreated)
+		if (watchRemoved)
+			clearWatch();
+
+		mPending.clear();
+		mDebounceTimer.stop();
+		emit dirChanged(dirPath);
+	}
+#endif
+}
+
+void DkDirWatcher::addEvent(const QString& fileName) {
+
+	if (fileName.startsWith(".") || !mFilter.matches(fileName))
+		return;
+
+	if (mPending.empty())
+		mPendingTimer.start();
+
+	mPending.insert(fileName);
+
+	// restart the timer unless we are delayed for too long already (continuous writes)
+	if (mPendingTimer.elapsed() < max_delay_ms || !mDebounceTimer.isActive())
+		mDebounceTimer.start();
+}
+
+void DkDirWatcher::flush() {
+
+	if (mPending.empty())
+		return;
+
+	DK_TRACE("load", "dirWatcher");
+
+	QStringList changed;
+	QStringList removed;
+	QString basePath = mDirPath.endsWith("/") ? mDirPath : mDirPath + "/";
+
+	for (const QString& fileName : mPending) {
+
+		QString filePath = basePath + fileName;
+
+		// we just check the final state - e.g. a file that was replaced is changed
+		if (QFileInfo(filePath).exists())
+			changed << filePath;
+		else
+			removed << filePath;
+	}
+
+	mPending.clear();
+	qDebug() << "[DkDirWatcher]" << changed.size() << "changed," << removed.size() << "removed";
+
+	emit filesChanged(changed, removed);
+}
+
+void DkDirWatcher::watcherDirChanged(const QString& dirPath) {
+
+	// the QFileSystemWatcher drops deleted directories - the next setDirPath() adds it again
+	if (!mWatcher->directories().contains(dirPath))
+		mDirPath.clear();
+
+	emit dirChanged(dirPath);
+}
+
+void DkDirWatcher::pollCurrentFile() {
+
+	QFileInfo fileInfo(mCurrentFile);
+
+	if (fileInfo.exists() == mCurrentExists && fileInfo.lastModified() == mCurrentModified)
+		return;
+
+	// the file is still written (e.g. locked on Windows) - try again with the next poll
+	if (fileInfo.exists() && !fileInfo.isReadable())
+		return;
+
+	mCurrentExists = fileInfo.exists();
+	mCurrentModified = fileInfo.lastModified();
+
+	if (mCurrentExists)
+		emit filesChanged(QStringList() << mCurrentFile, QStringList());
+	else
+		emit filesChanged(QStringList(), QStringList() << mCurrentFile);
+}
+
+/**
+ * Returns true if the file is on a network file system (Linux only).
+ * inotify does not report changes of other clients on these.
+ * @param filePath the file path.
+ * @return bool true for e.g. NFS, SMB or FUSE (sshfs) mounts.
+ **/
+bool DkDirWatcher::isNetworkPath(const QString& filePath) {
+
+#ifdef Q_OS_LINUX
+	if (filePath.isEmpty())
+		return false;
+
+	struct statfs fs;
+	if (statfs(QFile::encodeName(filePath).constData(), &fs) != 0)
+		return false;
+
+	switch ((unsigned long)fs.f_type) {
+	case 0x6969:		// NFS
+	case 0x517B:		// SMB
+	case 0xFF534D42:	// CIFS
+	case 0xFE534D42:	// SMB2
+	case 0x65735546:	// FUSE (e.g. sshfs)
+	case 0x5346414F:	// AFS
+	case 0x73757245:	// CODA
+	case 0x01021997:	// 9P
+		return true;
+	}
+#else
+	Q_UNUSED(filePath);
+#endif
+
+	return false;
+}
+
+void DkDirWatcher::clearWatch() {
+
+	mPending.clear();
+	mDebounceTimer.stop();
+
+	if (mWatcher && !mWatcher->directories().isEmpty())
+		mWatcher->removePaths(mWatcher->directories());
+
+#ifdef Q_OS_LINUX
+	if (mWd != -1) {
+		inotify_rm_watch(mFd, mWd);
+		mWd = -1;
+	}
+#endif
+
+	mDirPath.clear();
+}
+
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************************************
+ DkDirWatcher.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QObject>
+#include <QStringList>
+#include <QSet>
+#include <QTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#pragma warning(pop)	// no warnings from includes - end
+
+#include "DkDirScanner.h"
+
+#ifndef DllLoaderExport
+#ifdef DK_LOADER_DLL_EXPORT
+#define DllLoaderExport Q_DECL_EXPORT
+#elif DK_DLL_IMPORT
+#define DllLoaderExport Q_DECL_IMPORT
+#else
+#define DllLoaderExport Q_DECL_IMPORT
+#endif
+#endif
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+
+namespace nmc {
+
+/**
+ * Watches the current directory and reports which images changed.
+ * On Linux, inotify events are collected and reported once the directory
+ * is quiet for debounce_ms (but at least every max_delay_ms).
+ * Other systems fall back to the QFileSystemWatcher: dirChanged() is
+ * emitted instead and only the current file is polled.
+ * The current file is polled with inotify too if it is on a network
+ * file system (inotify misses remote writes) or if it is an archive.
+ **/
+class DllLoaderExport DkDirWatcher : public QObject {
+	Q_OBJECT
+
+public:
+	DkDirWatcher(QObject* parent = 0);
+	~DkDirWatcher();
+
+	void setDirPath(const QString& dirPath);
+	QString dirPath() const;
+	void setCurrentFile(const QString& filePath, bool poll = false);
+	bool isIncremental() const;
+
+	enum {
+		debounce_ms = 250,
+		max_delay_ms = 2000,
+		poll_ms = 500,
+	};
+
+signals:
+	void filesChanged(const QStringList& changed, const QStringList& removed) const;
+	void dirChanged(const QString& dirPath) const;
+
+protected slots:
+	void readEvents();
+	void flush();
+	void watcherDirChanged(const QString& dirPath);
+	void pollCurrentFile();
+
+protected:
+	void addEvent(const QString& fileName);
+	void clearWatch();
+	static bool isNetworkPath(const QString& filePath);
+
+	QString mDirPath;
+	DkSuffixFilter mFilter;
+	QSet<QString> mPending;			// file names changed since the last flush
+	QTimer mDebounceTimer;
+	QElapsedTimer mPendingTimer;	// started with the first pending event
+
+	// fallback
+	QFileSystemWatcher* mWatcher = 0;
+
+	// polling of the current file
+	QTimer mPollTimer;
+	QString mCurrentFile;
+	QDateTime mCurrentModified;
+	bool mCurrentExists = false;
+
+	// inotify
+	int mFd = -1;
+	int mWd = -1;
+	QSocketNotifier* mNotifier = 0;
+};
+
+};
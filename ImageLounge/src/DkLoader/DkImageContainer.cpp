@@ -68,6 +68,7 @@ DkImageContainer::DkImageContainer(const QString& filePath) {
 
 DkImageContainer::~DkImageContainer() {
 
+	releaseImage();
 }
 
 void DkImageContainer::init() {
@@ -118,9 +119,40 @@ void DkImageContainer::clear() {
 		mLoader->release();
 	if (mFileBuffer)
 		mFileBuffer->clear();
+	mHistogram = DkImageHistogram();
+	releaseImage();
 	init();
 }
 
+/**
+ * Shares the decoded image with all other containers of the same file.
+ * If another tab decoded the file already, our copy is replaced by the cached
+ * image so that the memory is just used once.
+ **/ 
+void DkImageContainer::shareImage() {
+
+	if (!mLoader || !mLoader->hasImage() || mLoader->isPreview() || !mCacheKey.isEmpty())
+		return;
+
+	QString key = DkImageCache::key(mFilePath, mLoader->getPageIdx());
+
+	if (key.isEmpty())
+		return;
+
+	QImage img = DkImageCache::instance().insert(key, mLoader->image());
+	mLoader->shareImage(img);
+	mCacheKey = key;
+}
+
+void DkImageContainer::releaseImage() {
+
+	if (mCacheKey.isEmpty())
+		return;
+
+	DkImageCache::instance().release(mCacheKey);
+	mCacheKey.clear();
+}
+
 void DkImageContainer::undo() {
 
 	getLoader()->undo();
@@ -249,6 +281,46 @@ QSharedPointer<QByteArray> DkImageContainer::getFileBuffer() {
 	return mFileBuffer;
 }
 
+/**
+ * Returns the histogram of the current image.
+ * The histogram is cached until the image changes.
+ * @return DkImageHistogram the image's histogram
+ **/ 
+DkImageHistogram DkImageContainer::histogram() {
+
+	QImage img = image();
+
+	if (!hasHistogram(img))
+		setHistogram(DkImageHistogram::compute(img), img);
+
+	return mHistogram;
+}
+
+/**
+ * Returns true if the cached histogram belongs to the image.
+ * @param img the image (e.g. the current image)
+ * @return bool true if a histogram of img is cached
+ **/ 
+bool DkImageContainer::hasHistogram(const QImage& img) const {
+
+	return !mHistogram.isEmpty() && !img.isNull() && mHistogramKey == img.cacheKey();
+}
+
+/**
+ * Caches the histogram of an image.
+ * Approximate histograms are not cached.
+ * @param hist the histogram
+ * @param img the image the histogram was computed from
+ **/ 
+void DkImageContainer::setHistogram(const DkImageHistogram& hist, const QImage& img) {
+
+	if (hist.isEmpty() || hist.isApproximate() || img.isNull())
+		return;
+
+	mHistogram = hist;
+	mHistogramKey = img.cacheKey();
+}
+
 float DkImageContainer::getMemoryUsage() const {
 
 	if (!mLoader)
@@ -369,10 +441,24 @@ QSharedPointer<QByteArray> DkImageContainer::loadFileToBuffer(const QString& fil
 
 QSharedPointer<DkBasicLoader> DkImageContainer::loadImageIntern(const QString& filePath, QSharedPointer<DkBasicLoader> loader, const QSharedPointer<QByteArray> fileBuffer) {
 
+	QElapsedTimer dt;
+	dt.start();
+
 	try {
 		loader->loadGeneral(filePath, fileBuffer, true);
 	} catch(...) {}
 
+	if (loader->hasImage()) {
+		
+		DkSlideshowScheduler& scheduler = DkSlideshowScheduler::instance();
+
+		// slideshow images are faded - so we pre-scale them to the screen
+		if (scheduler.isActive())
+			loader->prescale();
+
+		scheduler.addDecodeTime(filePath, dt.elapsed());
+	}
+
 	return loader;
 }
 
@@ -495,15 +581,338 @@ bool imageContainerLessThan(const DkImageContainer& l, const DkImageContainer& r
 	
 }
 
+// DkSlideshowScheduler --------------------------------------------------------------------
+DkSlideshowScheduler& DkSlideshowScheduler::instance() {
+
+	static DkSlideshowScheduler inst;
+	return inst;
+}
+
+/**
+ * Sets the display interval of the slideshow.
+ * A report is logged if the slideshow is stopped.
+ * @param ms the interval in ms, 0 if the slideshow is stopped
+ **/ 
+void DkSlideshowScheduler::setInterval(int ms) {
+
+	if (ms <= 0 && isActive())
+		qDebug() << "[slideshow]" << report();
+	else if (ms > 0 && !isActive()) {
+		mNumFrames = 0;
+		mNumMissed = 0;
+		mMaxDelay = 0;
+		mLastDelay = 0;
+	}
+
+	mInterval.store(qMax(ms, 0));
+
+	if (!isActive())
+		mFrameTimer.invalidate();
+}
+
+int DkSlideshowScheduler::interval() const {
+	return mInterval.load();
+}
+
+bool DkSlideshowScheduler::isActive() const {
+	return interval() > 0;
+}
+
+QString DkSlideshowScheduler::format(const QString& filePath) {
+	return QFileInfo(filePath).suffix().toLower();
+}
+
+/**
+ * Adds a measured decode time.
+ * This method is called by the loading threads.
+ * @param filePath the decoded file
+ * @param ms the time needed for decoding
+ **/ 
+void DkSlideshowScheduler::addDecodeTime(const QString& filePath, qint64 ms) {
+
+	QMutexLocker locker(&mMutex);
+	
+	QString f = format(filePath);
+	QHash<QString, double>::iterator it = mDecodeTimes.find(f);
+
+	if (it == mDecodeTimes.end())
+		mDecodeTimes.insert(f, (double)ms);
+	else
+		*it = 0.7 * *it + 0.3 * ms;	// running average - file sizes differ within a format too
+}
+
+/**
+ * Returns the expected decode time of a file.
+ * Unknown formats are estimated by the mean of all known formats.
+ * @param filePath the file to be decoded
+ * @return double the expected decode time in ms
+ **/ 
+double DkSlideshowScheduler::decodeTime(const QString& filePath) const {
+
+	QMutexLocker locker(&mMutex);
+
+	QHash<QString, double>::const_iterator it = mDecodeTimes.constFind(format(filePath));
+
+	if (it != mDecodeTimes.constEnd())
+		return *it;
+	else if (mDecodeTimes.isEmpty())
+		return default_decode_ms;
+
+	double sum = 0;
+	for (double t : mDecodeTimes)
+		sum += t;
+
+	return sum / mDecodeTimes.size();
+}
+
+/**
+ * Returns true if an image should be preloaded now.
+ * An image that is shown in stepsAhead intervals is preloaded if its
+ * expected decode time (+50% for concurrent decodes) exceeds the
+ * time that is left until it becomes the next image.
+ * @param filePath the image's file path
+ * @param stepsAhead the number of frames before the image is shown (1 = next)
+ * @return bool true if the image should be loaded now
+ **/ 
+bool DkSlideshowScheduler::preloadNow(const QString& filePath, int stepsAhead) const {
+
+	if (!isActive() || stepsAhead < 1)
+		return false;
+
+	return (stepsAhead-1) * (double)interval() < decodeTime(filePath) * 1.5;
+}
+
+/**
+ * Starts the deadline of the next frame.
+ * Call this if the player requests the next image.
+ **/ 
+void DkSlideshowScheduler::startFrame() {
+
+	if (isActive())
+		mFrameTimer.start();
+}
+
+/**
+ * Checks the deadline of a frame that is displayed.
+ * @param filePath the displayed file
+ * @return bool true if the frame missed its deadline
+ **/ 
+bool DkSlideshowScheduler::frameShown(const QString& filePath) {
+
+	if (!isActive() || !mFrameTimer.isValid())
+		return false;
+
+	mLastDelay = mFrameTimer.elapsed();
+	mFrameTimer.invalidate();
+	
+	mMaxDelay = qMax(mMaxDelay, mLastDelay);
+	mNumFrames++;
+
+	if (mLastDelay <= deadline_tolerance_ms)
+		return false;
+
+	mNumMissed++;
+	qDebug() << "[slideshow]" << QFileInfo(filePath).fileName() << "missed its deadline by" << mLastDelay << "ms - expected decode time:" << decodeTime(filePath) << "ms";
+
+	return true;
+}
+
+qint64 DkSlideshowScheduler::lastDelay() const {
+	return mLastDelay;
+}
+
+int DkSlideshowScheduler::missedDeadlines() const {
+	return mNumMissed;
+}
+
+QString DkSlideshowScheduler::report() const {
+
+	QString msg = QString("%1/%2 frames missed their deadline (max delay: %3 ms) - decode times:")
+		.arg(mNumMissed).arg(mNumFrames).arg(mMaxDelay);
+
+	QMutexLocker locker(&mMutex);
+
+	for (QHash<QString, double>::const_iterator it = mDecodeTimes.constBegin(); it != mDecodeTimes.constEnd(); it++)
+		msg += QString(" %1: %2 ms").arg(it.key()).arg(qRound(it.value()));
+
+	return msg;
+}
+
+// DkImageCache --------------------------------------------------------------------
+DkImageCache& DkImageCache::instance() {
+
+	static DkImageCache inst;
+	return inst;
+}
+
+/**
+ * Returns the file identity used as cache key.
+ * @param filePath the image's file path
+ * @param pageIdx the page of multi-page images
+ * @return QString the key or an empty string if the file cannot be shared (e.g. zip files, downloads)
+ **/ 
+QString DkImageCache::key(const QString& filePath, int pageIdx) {
+
+	QFileInfo fInfo(filePath);
+	QString path = fInfo.canonicalFilePath();
+
+	if (path.isEmpty())
+		return QString();
+
+	return path + QString("|%1|%2|%3").arg(fInfo.lastModified().toMSecsSinceEpoch()).arg(fInfo.size()).arg(pageIdx);
+}
+
+/**
+ * Looks up a decoded image.
+ * The image is not referenced before it is inserted by the container that uses it.
+ * @param key the file identity (see key())
+ * @return QImage the cached image or a null image
+ **/ 
+QImage DkImageCache::find(const QString& key) {
+
+	QMutexLocker locker(&mMutex);
+
+	QHash<QString, DkCacheEntry>::iterator it = mImages.find(key);
+
+	if (it == mImages.end())
+		return QImage();
+
+	it->lastUsed = ++mUseCount;
+	return it->img;
+}
+
+/**
+ * Adds a reference to the image of key.
+ * If the image is cached already, the cached image is returned and the
+ * caller should drop its own copy.
+ * @param key the file identity (see key())
+ * @param img the decoded image
+ * @return QImage the image shared by all containers
+ **/ 
+QImage DkImageCache::insert(const QString& key, const QImage& img) {
+
+	QMutexLocker locker(&mMutex);
+
+	QHash<QString, DkCacheEntry>::iterator it = mImages.find(key);
+
+	if (it == mImages.end()) {
+		DkCacheEntry e;
+		e.img = img;
+		e.refs = 0;
+		it = mImages.insert(key, e);
+		mMemory += DkImage::getBufferSizeFloat(img.size(), img.depth());
+	}
+
+	it->refs++;
+	it->lastUsed = ++mUseCount;
+	QImage sharedImg = it->img;
+
+	evict();
+
+	return sharedImg;
+}
+
+void DkImageCache::release(const QString& key) {
+
+	QMutexLocker locker(&mMutex);
+
+	QHash<QString, DkCacheEntry>::iterator it = mImages.find(key);
+
+	if (it == mImages.end())
+		return;
+
+	if (it->refs > 0)
+		it->refs--;
+
+	evict();
+}
+
+void DkImageCache::clear() {
+
+	QMutexLocker locker(&mMutex);
+
+	QHash<QString, DkCacheEntry>::iterator it = mImages.begin();
+
+	while (it != mImages.end()) {
+
+		if (it->refs == 0) {
+			mMemory -= DkImage::getBufferSizeFloat(it->img.size(), it->img.depth());
+			it = mImages.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+/**
+ * Removes unreferenced images (least recently used first) until the cache fits the budget.
+ * Referenced images are never removed since their memory is held by the containers anyway.
+ **/ 
+void DkImageCache::evict() {
+
+	float budget = Settings::param().resources().cacheMemory;
+
+	while (mMemory > budget) {
+
+		QHash<QString, DkCacheEntry>::iterator lru = mImages.end();
+
+		for (QHash<QString, DkCacheEntry>::iterator it = mImages.begin(); it != mImages.end(); ++it) {
+			if (it->refs == 0 && (lru == mImages.end() || it->lastUsed < lru->lastUsed))
+				lru = it;
+		}
+
+		if (lru == mImages.end())
+			break;
+
+		mMemory -= DkImage::getBufferSizeFloat(lru->img.size(), lru->img.depth());
+		mImages.erase(lru);
+	}
+}
+
+float DkImageCache::memoryUsage() const {
+
+	QMutexLocker locker(&mMutex);
+	return mMemory;
+}
+
+float DkImageCache::referencedMemory() const {
+
+	QMutexLocker locker(&mMutex);
+
+	float mem = 0;
+	for (const DkCacheEntry& e : mImages) {
+		if (e.refs > 0)
+			mem += DkImage::getBufferSizeFloat(e.img.size(), e.img.depth());
+	}
+
+	return mem;
+}
+
+/**
+ * Returns true if the images used by all tabs fit into the cache memory.
+ * @return bool true if more images can be cached
+ **/ 
+bool DkImageCache::withinBudget() const {
+
+	return referencedMemory() < Settings::param().resources().cacheMemory;
+}
+
+int DkImageCache::size() const {
+
+	QMutexLocker locker(&mMutex);
+	return mImages.size();
+}
+
 // DkImageContainerT --------------------------------------------------------------------
 DkImageContainerT::DkImageContainerT(const QString& filePath) : DkImageContainer(filePath) {
 	
-	// our file watcher
-	mFileUpdateTimer.setSingleShot(false);
-	mFileUpdateTimer.setInterval(500);
-
-	connect(&mFileUpdateTimer, SIGNAL(timeout()), this, SLOT(checkForFileUpdates()), Qt::UniqueConnection);
 	//connect(&metaDataWatcher, SIGNAL(finished()), this, SLOT(metaDataLoaded()));
+
+	// the full image is decoded if the user stays with a preview
+	// (so we do not decode full images while skipping through a folder)
+	mUpgradeTimer.setSingleShot(true);
+	mUpgradeTimer.setInterval(200);
+	connect(&mUpgradeTimer, SIGNAL(timeout()), this, SLOT(upgradeImage()), Qt::UniqueConnection);
 }
 
 DkImageContainerT::~DkImageContainerT() {
@@ -512,6 +921,8 @@ DkImageContainerT::~DkImageContainerT() {
 	mBufferWatcher.cancel();
 	mImageWatcher.blockSignals(true);
 	mImageWatcher.cancel();
+	mUpgradeWatcher.blockSignals(true);
+	mUpgradeWatcher.cancel();
 
 	saveMetaData();
 
@@ -530,8 +941,15 @@ void DkImageContainerT::clear() {
 	DkImageContainer::clear();
 }
 
+/**
+ * Reloads the image if its file was modified.
+ * This is called by the DkImageLoader if the DkDirWatcher reports a change.
+ **/
 void DkImageContainerT::checkForFileUpdates() {
 
+	if (!mWatchFile)
+		return;
+
 #ifdef WITH_QUAZIP
 	if(isFromZip()) 
 		setFilePath(getZipData()->getZipFilePath());
@@ -556,7 +974,7 @@ void DkImageContainerT::checkForFileUpdates() {
 #endif
 
 	if (changed) {
-		mFileUpdateTimer.stop();
+		mWatchFile = false;
 		if (Settings::param().global().askToSaveDeletedFiles) {
 			mEdited = changed;
 			emit fileLoadedSignal(true);
@@ -564,11 +982,6 @@ void DkImageContainerT::checkForFileUpdates() {
 		return;
 	}
 
-	// we use our own file watcher, since the qt watcher
-	// uses locks to check for updates. this might
-	// be more accurate. however, the locks are pretty nasty
-	// if the user e.g. wants to delete the file while watching
-	// it in nomacs
 	if (mWaitForUpdate && mFileInfo.isReadable()) {
 		mWaitForUpdate = false;
 		getThumb()->setImage(QImage());
@@ -619,6 +1032,7 @@ bool DkImageContainerT::loadImageThreaded(bool force) {
 #endif
 	
 	mLoadState = loading;
+	mLoadTimer.start();
 	fetchFile();
 	return true;
 }
@@ -682,6 +1096,9 @@ void DkImageContainerT::fetchImage() {
 	qDebug() << "fetching: " << filePath();
 	mFetchingImage = true;
 
+	// decode a preview if the file allows for it
+	getLoader()->setTargetSize(mPreviewSize);
+
 	connect(&mImageWatcher, SIGNAL(finished()), this, SLOT(imageLoaded()), Qt::UniqueConnection);
 
 	mImageWatcher.setFuture(QtConcurrent::run(this, 
@@ -715,7 +1132,7 @@ void DkImageContainerT::loadingFinished() {
 	}
 
 	if (!getLoader()->hasImage()) {
-		mFileUpdateTimer.stop();
+		mWatchFile = false;
 		mEdited = false;
 		QString msg = tr("Sorry, I could not load: %1").arg(fileName());
 		emit showInfoSignal(msg);
@@ -727,10 +1144,17 @@ void DkImageContainerT::loadingFinished() {
 		getThumb()->setImage(getLoader()->image());
 	}
 
+	if (getLoader()->isPreview()) {
+		qDebug() << "[DkImageContainerT]" << fileName() << "preview ready after" << mLoadTimer.elapsed() << "ms";
+		mUpgradeTimer.start();
+	}
+
 	// clear file buffer if it exceeds a certain size?! e.g. psd files
 	if (mFileBuffer && mFileBuffer->size()/(1024.0f*1024.0f) > Settings::param().resources().cacheMemory*0.5f)
 		mFileBuffer->clear();
 	
+	shareImage();
+
 	mLoadState = loaded;
 	emit fileLoadedSignal(true);
 }
@@ -769,6 +1193,96 @@ void DkImageContainerT::fileDownloaded() {
 	fetchImage();
 }
 
+/**
+ * Sets the size of the preview that is decoded before the full image.
+ * If the size is invalid (default), full images are loaded.
+ * @param size the preview size (e.g. the viewport's size)
+ **/ 
+void DkImageContainerT::setPreviewSize(const QSize& size) {
+
+	mPreviewSize = size;
+}
+
+void DkImageContainerT::upgradeImage() {
+
+	if (!mSelected || mUpgrading || !getLoader()->isPreview())
+		return;
+
+	// slideshow frames are prescaled to the screen - decoding them twice would defeat preloading
+	// so we wait until the slideshow is stopped (or the next frame deselects us)
+	if (DkSlideshowScheduler::instance().isActive()) {
+		mUpgradeTimer.start();
+		return;
+	}
+
+	mUpgrading = true;
+
+	// copy the buffer since it might be cleared while we are decoding
+	QSharedPointer<QByteArray> ba;
+	if (mFileBuffer)
+		ba = QSharedPointer<QByteArray>(new QByteArray(*mFileBuffer));
+
+	connect(&mUpgradeWatcher, SIGNAL(finished()), this, SLOT(upgradeLoaded()), Qt::UniqueConnection);
+
+	mUpgradeWatcher.setFuture(QtConcurrent::run(this, 
+		&nmc::DkImageContainerT::loadFullImageIntern, filePath(), ba));
+}
+
+void DkImageContainerT::upgradeLoaded() {
+
+	mUpgrading = false;
+
+	if (mUpgradeWatcher.isCanceled())
+		return;
+
+	setFullImage(mUpgradeWatcher.result());
+}
+
+/**
+ * Replaces the preview with the full resolution image.
+ * This function blocks until the image is decoded. Call it before
+ * an edit is computed - edits of the preview cannot be upgraded.
+ * @return bool true if the full resolution image is available
+ **/ 
+bool DkImageContainerT::loadFullImage() {
+
+	if (!getLoader()->isPreview())
+		return true;
+
+	DkTimer dt;
+	mUpgradeTimer.stop();
+
+	QImage img;
+
+	// the full image is decoded already - just wait for it
+	if (mUpgrading) {
+		mUpgradeWatcher.waitForFinished();
+
+		if (!mUpgradeWatcher.isCanceled())
+			img = mUpgradeWatcher.result();
+	}
+
+	if (img.isNull())
+		img = loadFullImageIntern(filePath(), mFileBuffer);
+
+	qDebug() << "[DkImageContainerT] waited" << dt.getTotal() << "for the full image";
+
+	return setFullImage(img);
+}
+
+bool DkImageContainerT::setFullImage(const QImage& img) {
+
+	// the preview is not replaced if it was edited already
+	if (!getLoader()->upgradeImage(img))
+		return false;
+
+	qDebug() << "[DkImageContainerT]" << fileName() << "full image ready after" << mLoadTimer.elapsed() << "ms";
+	shareImage();
+	emit imageUpgradedSignal();
+
+	return true;
+}
+
 void DkImageContainerT::cancel() {
 
 	if (mLoadState != loading)
@@ -786,7 +1300,8 @@ void DkImageContainerT::receiveUpdates(QObject* obj, bool connectSignals /* = tr
 		connect(this, SIGNAL(showInfoSignal(const QString&, int, int)), obj, SIGNAL(showInfoSignal(const QString&, int, int)), Qt::UniqueConnection);
 		connect(this, SIGNAL(fileSavedSignal(const QString&, bool)), obj, SLOT(imageSaved(const QString&, bool)), Qt::UniqueConnection);
 		connect(this, SIGNAL(imageUpdatedSignal()), obj, SLOT(currentImageUpdated()), Qt::UniqueConnection);
-		mFileUpdateTimer.start();
+		connect(this, SIGNAL(imageUpgradedSignal()), obj, SLOT(currentImageUpgraded()), Qt::UniqueConnection);
+		mWatchFile = true;
 	}
 	else if (!connectSignals) {
 		disconnect(this, SIGNAL(errorDialogSignal(const QString&)), obj, SLOT(errorDialog(const QString&)));
@@ -794,7 +1309,8 @@ void DkImageContainerT::receiveUpdates(QObject* obj, bool connectSignals /* = tr
 		disconnect(this, SIGNAL(showInfoSignal(const QString&, int, int)), obj, SIGNAL(showInfoSignal(const QString&, int, int)));
 		disconnect(this, SIGNAL(fileSavedSignal(const QString&, bool)), obj, SLOT(imageSaved(const QString&, bool)));
 		disconnect(this, SIGNAL(imageUpdatedSignal()), obj, SLOT(currentImageUpdated()));
-		mFileUpdateTimer.stop();
+		disconnect(this, SIGNAL(imageUpgradedSignal()), obj, SLOT(currentImageUpgraded()));
+		mWatchFile = false;
 	}
 
 	mSelected = connectSignals;
@@ -806,7 +1322,7 @@ void DkImageContainerT::saveMetaDataThreaded() {
 	if (!exists() || (getLoader()->getMetaData() && !getLoader()->getMetaData()->isDirty()))
 		return;
 
-	mFileUpdateTimer.stop();
+	mWatchFile = false;
 	QFuture<void> future = QtConcurrent::run(this, 
 		&nmc::DkImageContainerT::saveMetaDataIntern, filePath(), getLoader(), getFileBuffer());
 
@@ -814,6 +1330,7 @@ void DkImageContainerT::saveMetaDataThreaded() {
 
 bool DkImageContainerT::saveImageThreaded(const QString& filePath, int compression /* = -1 */) {
 
+	loadFullImage();
 	return saveImageThreaded(filePath, getLoader()->image(), compression);
 }
 
@@ -829,6 +1346,11 @@ bool DkImageContainerT::saveImageThreaded(const QString& filePath, const QImage
 		emit errorDialogSignal(msg);
 		return false;
 	}
+	if (getLoader()->isPreview()) {
+		QString msg = tr("Sorry, %1 is not fully loaded yet.").arg(fileName());
+		emit errorDialogSignal(msg);
+		return false;
+	}
 	if (!fInfo.absoluteDir().exists()) {
 		QString msg = tr("Sorry, the directory: %1  does not exist\n").arg(filePath);
 		emit errorDialogSignal(msg);
@@ -842,7 +1364,7 @@ bool DkImageContainerT::saveImageThreaded(const QString& filePath, const QImage
 
 	qDebug() << "attempting to save: " << filePath;
 
-	mFileUpdateTimer.stop();
+	mWatchFile = false;
 	connect(&mSaveImageWatcher, SIGNAL(finished()), this, SLOT(savingFinished()), Qt::UniqueConnection);
 
 	mSaveImageWatcher.setFuture(QtConcurrent::run(this, 
@@ -872,7 +1394,7 @@ void DkImageContainerT::savingFinished() {
 		mDownloaded = false;
 		if (mSelected) {
 			loadImageThreaded(true);	// force a reload
-			mFileUpdateTimer.start();
+			mWatchFile = true;
 		}
 		emit fileSavedSignal(savePath);
 	}
@@ -885,7 +1407,76 @@ QSharedPointer<QByteArray> DkImageContainerT::loadFileToBuffer(const QString& fi
 
 QSharedPointer<DkBasicLoader> DkImageContainerT::loadImageIntern(const QString& filePath, QSharedPointer<DkBasicLoader> loader, const QSharedPointer<QByteArray> fileBuffer) {
 
-	return DkImageContainer::loadImageIntern(filePath, loader, fileBuffer);
+	DK_TRACE("load", "loadImageIntern");
+
+	// another tab might have decoded this image already
+	if (!loader->isDirty()) {
+
+		QImage img = DkImageCache::instance().find(DkImageCache::key(filePath, loader->getPageIdx()));
+
+		if (!img.isNull() && loader->loadCached(filePath, img, fileBuffer))
+			qDebug() << "[DkImageContainerT]" << QFileInfo(filePath).fileName() << "shared with another tab";
+	}
+
+	if (!loader->hasImage())
+		loader = DkImageContainer::loadImageIntern(filePath, loader, fileBuffer);
+
+	// the GUI just applies the resolved metadata
+	if (loader->hasImage())
+		resolveMetaData(loader->getMetaData());
+
+	return loader;
+}
+
+/**
+ * Returns the resolved metadata entries (see DkMetaDataHelper::resolveEntries()).
+ * They are resolved while the image is loaded. If the metadata was changed
+ * since (e.g. the rating), the entries are resolved again.
+ * @return QVector<DkMetaDataEntry> the metadata entries
+ **/ 
+QVector<DkMetaDataEntry> DkImageContainerT::metaDataEntries() {
+
+	QSharedPointer<DkMetaDataT> metaData = getMetaData();
+
+	if (!metaData)
+		return QVector<DkMetaDataEntry>();
+
+	{
+		QMutexLocker locker(&mEntriesMutex);
+
+		if (mMetaDataEntries && mEntriesSource == metaData.data() && mEntriesRevision == metaData->revision())
+			return *mMetaDataEntries;
+	}
+
+	return resolveMetaData(metaData);
+}
+
+QVector<DkMetaDataEntry> DkImageContainerT::resolveMetaData(QSharedPointer<DkMetaDataT> metaData) {
+
+	if (!metaData)
+		return QVector<DkMetaDataEntry>();
+
+	int revision = metaData->revision();
+	QSharedPointer<QVector<DkMetaDataEntry> > entries(new QVector<DkMetaDataEntry>(DkMetaDataHelper::getInstance().resolveEntries(metaData)));
+
+	QMutexLocker locker(&mEntriesMutex);
+	mMetaDataEntries = entries;
+	mEntriesSource = metaData.data();
+	mEntriesRevision = revision;
+
+	return *entries;
+}
+
+QImage DkImageContainerT::loadFullImageIntern(const QString& filePath, const QSharedPointer<QByteArray> fileBuffer) {
+
+	DkBasicLoader loader;
+
+	// no fast load here: it would load the RAW's embedded preview again
+	try {
+		loader.loadGeneral(filePath, fileBuffer, true);
+	} catch(...) {}
+
+	return loader.image();
 }
 
 QString DkImageContainerT::saveImageIntern(const QString& filePath, QSharedPointer<DkBasicLoader> loader, QImage saveImg, int compression) {
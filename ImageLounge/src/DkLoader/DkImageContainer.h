@@ -31,6 +31,10 @@
 #include <QFutureWatcher>
 #include <QTimer>
 #include <QSharedPointer>
+#include <QMutex>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 #pragma warning(pop)		// no warnings from includes - end
 
 #pragma warning(disable: 4251)	// TODO: remove
@@ -46,12 +50,15 @@
 #endif
 
 #include "DkThumbs.h"
+#include "DkTimer.h"
+#include "DkImageStorage.h"
 
 namespace nmc {
 
 // nomacs defines
 class DkBasicLoader;
 class DkMetaDataT;
+class DkMetaDataEntry;
 class DkZipContainer;
 class FileDownloader;
 
@@ -93,6 +100,9 @@ public:
 	virtual QSharedPointer<DkMetaDataT> getMetaData();
 	virtual QSharedPointer<DkThumbNailT> getThumb();
 	virtual QSharedPointer<QByteArray> getFileBuffer();
+	DkImageHistogram histogram();
+	bool hasHistogram(const QImage& img) const;
+	void setHistogram(const DkImageHistogram& hist, const QImage& img);
 #ifdef WITH_QUAZIP
 	QSharedPointer<DkZipContainer> getZipData();
 #endif
@@ -121,16 +131,21 @@ protected:
 	QString saveImageIntern(const QString& filePath, QSharedPointer<DkBasicLoader> loader, QImage saveImg, int compression);
 	void setFilePath(const QString& filePath);
 	void init();
+	void shareImage();
+	void releaseImage();
 
 	QSharedPointer<QByteArray> mFileBuffer;
 	QSharedPointer<DkBasicLoader> mLoader;
 	QSharedPointer<DkThumbNailT> mThumb;
+	DkImageHistogram mHistogram;
+	qint64 mHistogramKey = 0;
 
 	int mLoadState	= not_loaded;
 	bool mEdited	= false;
 	bool mSelected	= false;
 
 	QFileInfo mFileInfo;
+	QString mCacheKey;	// the image shared with other containers (see DkImageCache)
 
 #ifdef WITH_QUAZIP	
 	QSharedPointer<DkZipContainer> mZipData;
@@ -147,6 +162,98 @@ private:
 bool imageContainerLessThan(const DkImageContainer& l, const DkImageContainer& r);
 bool imageContainerLessThanPtr(const QSharedPointer<DkImageContainer> l, const QSharedPointer<DkImageContainer> r);
 
+/**
+ * Schedules preloading for slideshows.
+ * Decode times are measured per format. Images that would not be decoded
+ * within the display interval are preloaded earlier (see preloadNow()).
+ * Frames which are displayed later than the player requested them are
+ * reported as missed deadlines.
+ **/ 
+class DllLoaderExport DkSlideshowScheduler {
+
+public:
+	static DkSlideshowScheduler& instance();
+
+	void setInterval(int ms);
+	int interval() const;
+	bool isActive() const;
+
+	void addDecodeTime(const QString& filePath, qint64 ms);
+	double decodeTime(const QString& filePath) const;
+	bool preloadNow(const QString& filePath, int stepsAhead) const;
+
+	void startFrame();
+	bool frameShown(const QString& filePath);
+	qint64 lastDelay() const;
+	int missedDeadlines() const;
+	QString report() const;
+
+	enum {
+		default_decode_ms = 500,	// decode time of unknown formats
+		deadline_tolerance_ms = 100,
+	};
+
+protected:
+	DkSlideshowScheduler() {};
+	DkSlideshowScheduler(DkSlideshowScheduler const&);		// hide
+	void operator=(DkSlideshowScheduler const&);			// hide
+
+	static QString format(const QString& filePath);
+
+	mutable QMutex mMutex;				// decode times are added by the loading threads
+	QHash<QString, double> mDecodeTimes;	// running average per suffix
+
+	QAtomicInt mInterval;				// read by the loading threads
+	QElapsedTimer mFrameTimer;
+	qint64 mLastDelay = 0;
+	qint64 mMaxDelay = 0;
+	int mNumFrames = 0;
+	int mNumMissed = 0;
+};
+
+/**
+ * Process-wide cache of decoded images.
+ * Images are keyed by their file identity (path, modification date and page)
+ * so that containers of different tabs share the same image data.
+ * Images which are not referenced by any container are kept (least recently
+ * used first out) as long as all images fit into the cache memory budget.
+ **/ 
+class DllLoaderExport DkImageCache {
+
+public:
+	static DkImageCache& instance();
+
+	static QString key(const QString& filePath, int pageIdx);
+
+	QImage find(const QString& key);
+	QImage insert(const QString& key, const QImage& img);
+	void release(const QString& key);
+	void clear();
+
+	float memoryUsage() const;
+	float referencedMemory() const;
+	bool withinBudget() const;
+	int size() const;
+
+protected:
+	DkImageCache() {};
+	DkImageCache(DkImageCache const&);		// hide
+	void operator=(DkImageCache const&);	// hide
+
+	void evict();
+
+	struct DkCacheEntry {
+		QImage img;
+		int refs;
+		qint64 lastUsed;
+	};
+
+	mutable QMutex mMutex;				// images are looked up by the loading threads
+	QHash<QString, DkCacheEntry> mImages;
+	qint64 mUseCount = 0;
+	float mMemory = 0;					// MB of all cached images
+};
+
 class DllLoaderExport DkImageContainerT : public QObject, public DkImageContainer {
 	Q_OBJECT
 
@@ -159,8 +266,11 @@ public:
 	void clear();
 	void receiveUpdates(QObject* obj, bool connectSignals = true);
 	void downloadFile(const QUrl& url);
+	void setPreviewSize(const QSize& size);
+	QVector<DkMetaDataEntry> metaDataEntries();
 
 	bool loadImageThreaded(bool force = false);
+	bool loadFullImage();
 	bool saveImageThreaded(const QString& filePath, const QImage saveImg, int compression = -1);
 	bool saveImageThreaded(const QString& filePath, int compression = -1);
 	void saveMetaDataThreaded();
@@ -181,6 +291,7 @@ signals:
 	void errorDialogSignal(const QString& msg) const;
 	void thumbLoadedSignal(bool loaded = true) const;
 	void imageUpdatedSignal() const;
+	void imageUpgradedSignal() const;	// the preview was replaced by the full image
 
 public slots:
 	void checkForFileUpdates(); 
@@ -191,17 +302,23 @@ protected slots:
 	void savingFinished();
 	void loadingFinished();
 	void fileDownloaded();
+	void upgradeImage();
+	void upgradeLoaded();
 
 protected:
 	void fetchImage();
 	
 	QSharedPointer<QByteArray> loadFileToBuffer(const QString& filePath);
 	QSharedPointer<DkBasicLoader> loadImageIntern(const QString& filePath, QSharedPointer<DkBasicLoader> loader, const QSharedPointer<QByteArray> fileBuffer);
+	QImage loadFullImageIntern(const QString& filePath, const QSharedPointer<QByteArray> fileBuffer);
+	bool setFullImage(const QImage& img);
+	QVector<DkMetaDataEntry> resolveMetaData(QSharedPointer<DkMetaDataT> metaData);
 	QString saveImageIntern(const QString& filePath, QSharedPointer<DkBasicLoader> loader, QImage saveImg, int compression);
 	void saveMetaDataIntern(const QString& filePath, QSharedPointer<DkBasicLoader> loader, QSharedPointer<QByteArray> fileBuffer);
 	
 	QFutureWatcher<QSharedPointer<QByteArray> > mBufferWatcher;
 	QFutureWatcher<QSharedPointer<DkBasicLoader> > mImageWatcher;
+	QFutureWatcher<QImage> mUpgradeWatcher;
 	QFutureWatcher<QString> mSaveImageWatcher;
 	QFutureWatcher<bool> mSaveMetaDataWatcher;
 
@@ -211,8 +328,19 @@ protected:
 	bool mFetchingBuffer = false;
 	bool mWaitForUpdate = false;
 	bool mDownloaded = false;
+	bool mUpgrading = false;
+	bool mWatchFile = false;	// true if the file changes should be loaded (selected & not saving)
+
+	QSize mPreviewSize;
+
+	// metadata entries resolved by the loading thread
+	QMutex mEntriesMutex;
+	QSharedPointer<QVector<DkMetaDataEntry> > mMetaDataEntries;
+	const DkMetaDataT* mEntriesSource = 0;
+	int mEntriesRevision = -1;
 
-	QTimer mFileUpdateTimer;
+	QElapsedTimer mLoadTimer;	// wall time - DkTimer measures the CPU time
+	QTimer mUpgradeTimer;
 };
 
 };
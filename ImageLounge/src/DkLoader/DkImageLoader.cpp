@@ -40,17 +40,19 @@
 #include "DkUtils.h"
 #include "DkStatusBar.h"
 #include "DkActionManager.h"
+#include "DkDirScanner.h"
+#include "DkDirWatcher.h"
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QWidget>
 #include <QImageWriter>
-#include <QFileSystemWatcher>
 #include <QFileInfo>
 #include <QFile>
 #include <QSettings>
 #include <QImageReader>
 #include <QDir>
 #include <QThread>
+#include <QThreadPool>
 #include <QBuffer>
 #include <QStringBuilder>
 #include <QDebug>
@@ -107,8 +109,13 @@ DkImageLoader::DkImageLoader(const QString& filePath) {
 
 	qRegisterMetaType<QFileInfo>("QFileInfo");
 
-	mDirWatcher = new QFileSystemWatcher(this);
-	connect(mDirWatcher, SIGNAL(directoryChanged(QString)), this, SLOT(directoryChanged(QString)));
+	mDirWatcher = new DkDirWatcher(this);
+	connect(mDirWatcher, SIGNAL(dirChanged(const QString&)), this, SLOT(directoryChanged(const QString&)));
+	connect(mDirWatcher, SIGNAL(filesChanged(const QStringList&, const QStringList&)), this, SLOT(filesChanged(const QStringList&, const QStringList&)));
+
+	mDirScanner = new DkDirScanner(this);
+	connect(mDirScanner, SIGNAL(folderScanned(const QString&, int)), this, SLOT(subFolderScanned(const QString&, int)));
+	connect(mDirScanner, SIGNAL(scanFinished()), this, SLOT(subFoldersScanned()));
 
 	mSortingIsDirty = false;
 	mSortingImages = false;
@@ -167,21 +174,13 @@ bool DkImageLoader::loadZipArchive(const QString& zipPath) {
 
 	QStringList fileNameList = JlCompress::getFileList(zipPath);
 	
-	// remove the * in fileFilters
-	QStringList fileFiltersClean = Settings::param().app().browseFilters;
-	for (int idx = 0; idx < fileFiltersClean.size(); idx++)
-		fileFiltersClean[idx].replace("*", "");
+	DkSuffixFilter filter(Settings::param().app().browseFilters);
 
 	QStringList fileList;
-	for (int idx = 0; idx < fileNameList.size(); idx++) {
+	for (const QString& fileName : fileNameList) {
 		
-		for (int idxFilter = 0; idxFilter < fileFiltersClean.size(); idxFilter++) {
-
-			if (fileNameList.at(idx).contains(fileFiltersClean[idxFilter], Qt::CaseInsensitive)) {
-				fileList.append(fileNameList.at(idx));
-				break;
-			}
-		}
+		if (filter.matches(fileName))
+			fileList.append(fileName);
 	}
 
 	QFileInfoList fileInfoList;
@@ -230,6 +229,10 @@ bool DkImageLoader::loadDir(const QString& newDirPath, bool scanRecursive) {
 			emit showInfoSignal(tr("%1 \n does not contain any image").arg(newDirPath), 4000);	// stop mShowing
 			mImages.clear();
 			emit updateDirSignal(mImages);
+
+			// keep watching - the folder might have been recreated
+			if (mDirWatcher)
+				mDirWatcher->setDirPath(mCurrentDir);
 			return false;
 		}
 
@@ -256,12 +259,19 @@ bool DkImageLoader::loadDir(const QString& newDirPath, bool scanRecursive) {
 		mFolderUpdated = false;
 
 		mFolderKeywords.clear();	// delete key words -> otherwise user may be confused
+		mWaitForSubFolder = false;
 
 		if (scanRecursive && Settings::param().global().scanSubFolders)
 			files = updateSubFolders(mCurrentDir);
 		else 
 			files = getFilteredFileInfoList(mCurrentDir, mIgnoreKeywords, mKeywords, mFolderKeywords);		// this line takes seconds if you have lots of files and slow loading (e.g. network)
 
+		// the sub folders are still scanned
+		if (files.empty() && mWaitForSubFolder) {
+			emit showInfoSignal(tr("Searching images in the sub folders of %1...").arg(mCurrentDir), 4000);
+			return false;
+		}
+
 		if (files.empty()) {
 			emit showInfoSignal(tr("%1 \n does not contain any image").arg(mCurrentDir), 4000);	// stop mShowing
 			return false;
@@ -269,6 +279,7 @@ bool DkImageLoader::loadDir(const QString& newDirPath, bool scanRecursive) {
 
 		// ok new folder, this should speed-up loading
 		mImages.clear();
+		qDebug() << qPrintable(DkThumbPool::instance().report());
 		
 		//// TODO: creating ~120 000 images takes about 2 secs
 		//// but sorting (just filenames) takes ages (on windows)
@@ -318,17 +329,16 @@ void DkImageLoader::imagesSorted() {
 
 	emit updateDirSignal(mImages);
 
-	if (mDirWatcher) {
-		if (!mDirWatcher->directories().isEmpty())
-			mDirWatcher->removePaths(mDirWatcher->directories());
-		mDirWatcher->addPath(mCurrentDir);
-	}
+	if (mDirWatcher)
+		mDirWatcher->setDirPath(mCurrentDir);
 
 	qDebug() << "images sorted...";
 }
 
 void DkImageLoader::createImages(const QFileInfoList& files, bool sort) {
 
+	DK_TRACE("load", "createImages");
+
 	// TODO: change files to QStringList
 	DkTimer dt;
 	QVector<QSharedPointer<DkImageContainerT > > oldImages = mImages;
@@ -351,11 +361,8 @@ void DkImageLoader::createImages(const QFileInfoList& files, bool sort) {
 
 		emit updateDirSignal(mImages);
 
-		if (mDirWatcher) {
-			if (!mDirWatcher->directories().isEmpty())
-				mDirWatcher->removePaths(mDirWatcher->directories());
-			mDirWatcher->addPath(mCurrentDir);
-		}
+		if (mDirWatcher)
+			mDirWatcher->setDirPath(mCurrentDir);
 	}
 
 }
@@ -837,6 +844,15 @@ void DkImageLoader::setCurrentImage(QSharedPointer<DkImageContainerT> newImg) {
 
 	if (mCurrentImage)
 		mCurrentImage->receiveUpdates(this);
+
+	// archives are not watched - so we poll them
+	QString watchPath = mCurrentImage ? mCurrentImage->filePath() : QString();
+	bool isZip = mCurrentImage && mCurrentImage->isFromZip();
+#ifdef WITH_QUAZIP
+	if (isZip)
+		watchPath = mCurrentImage->getZipData()->getZipFilePath();
+#endif
+	mDirWatcher->setCurrentFile(watchPath, isZip);
 }
 
 void DkImageLoader::reloadImage() {
@@ -899,6 +915,10 @@ void DkImageLoader::load(QSharedPointer<DkImageContainerT> image /* = QSharedPoi
 	if (mCurrentImage && mCurrentImage->getLoadState() == DkImageContainerT::loading)
 		return;
 
+	// show a screen sized preview first (if the decoder supports it)
+	if (Settings::param().resources().fastPreview)
+		mCurrentImage->setPreviewSize(mPreviewSize);
+
 	emit updateSpinnerSignalDelayed(true);
 	bool loaded = mCurrentImage->loadImageThreaded();	// loads file threaded
 	
@@ -1389,6 +1409,7 @@ void DkImageLoader::rotateImage(double angle) {
 		return;
 	}
 
+	mCurrentImage->loadFullImage();
 	QImage img = mCurrentImage->getLoader()->rotate(mCurrentImage->image(), qRound(angle));
 
 	QImage thumb = DkImage::createThumb(mCurrentImage->image());
@@ -1510,6 +1531,66 @@ void DkImageLoader::directoryChanged(const QString& path) {
 	
 }
 
+/**
+ * Applies changes of single files to the image list (without re-indexing the folder).
+ * New and modified images are inserted sorted, removed images are deleted.
+ * @param changed the files that were added or modified.
+ * @param removed the files that were removed.
+ **/
+void DkImageLoader::filesChanged(const QStringList& changed, const QStringList& removed) {
+
+	// archives are polled (see setCurrentImage)
+	if (mCurrentImage && mCurrentImage->isFromZip()) {
+		mCurrentImage->checkForFileUpdates();
+		return;
+	}
+
+	// keywords and duplicates need the full file list
+	if (!mIgnoreKeywords.empty() || !mKeywords.empty() || !mFolderKeywords.empty() || Settings::param().resources().filterDuplicats) {
+		directoryChanged(mCurrentDir);
+		return;
+	}
+
+	DK_TRACE("load", "filesChanged");
+	bool updated = false;
+
+	for (const QString& filePath : removed) {
+
+		int idx = findFileIdx(filePath, mImages);
+
+		if (idx == -1)
+			continue;
+
+		if (mImages[idx] == mCurrentImage)
+			mCurrentImage->checkForFileUpdates();
+
+		mImages.remove(idx);
+		updated = true;
+	}
+
+	for (const QString& filePath : changed) {
+
+		int idx = findFileIdx(filePath, mImages);
+
+		// reload the current image
+		if (idx != -1 && mImages[idx] == mCurrentImage) {
+			mCurrentImage->checkForFileUpdates();
+			continue;
+		}
+
+		// modified images get a new container (see createImages)
+		if (idx != -1)
+			mImages.remove(idx);
+
+		QSharedPointer<DkImageContainerT> imgC(new DkImageContainerT(filePath));
+		mImages.insert(qLowerBound(mImages.begin(), mImages.end(), imgC, imageContainerLessThanPtr), imgC);
+		updated = true;
+	}
+
+	if (updated)
+		emit updateDirSignal(mImages);
+}
+
 /**
  * Returns true if a file was specified.
  * @return bool true if a file name/path was specified
@@ -1571,56 +1652,79 @@ QString DkImageLoader::getDirPath() const {
 	return mCurrentDir;
 }
 
-QStringList DkImageLoader::getFoldersRecursive(const QString& dirPath) {
-
-	//DkTimer dt;
-	QStringList subFolders;
-	//qDebug() << "scanning recursively: " << dir.absolutePath();
+/**
+ * Starts scanning the sub folders of rootDirPath (if scanning sub folders is enabled).
+ * The images of the root directory are returned right away
+ * and the sub folders are added while the scan continues.
+ * If the root directory has no images, the first sub folder
+ * that is reported with images is loaded (see subFolderScanned()).
+ * @param rootDirPath the root directory.
+ * @return QFileInfoList the images of the root directory.
+ **/
+QFileInfoList DkImageLoader::updateSubFolders(const QString& rootDirPath) {
+	
+	mSubFolders = QStringList() << rootDirPath;
+	mCurrentDir = rootDirPath;
+	mWaitForSubFolder = false;
 
-	if (Settings::param().global().scanSubFolders) {
+	if (Settings::param().global().scanSubFolders)
+		mDirScanner->scan(rootDirPath, Settings::param().global().maxSubFolders);
+	else
+		mDirScanner->cancel();
 
-		QDirIterator dirs(dirPath, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDirIterator::Subdirectories);
+	QFileInfoList files = getFilteredFileInfoList(rootDirPath, mIgnoreKeywords, mKeywords);		// this line takes seconds if you have lots of files and slow loading (e.g. network)
 	
-		int nFolders = 0;
-		while (dirs.hasNext()) {
-			dirs.next();
-			subFolders << dirs.filePath();
-			nFolders++;
+	if (files.empty() && mDirScanner->isScanning())
+		mWaitForSubFolder = true;
 
-			if (nFolders > 100)
-				break;
-			
-			//getFoldersRecursive(dirs.filePath(), subFolders);
-			//qDebug() << "loop: " << dirs.filePath();
-		}
-	}	
+	return files;
+}
 
-	subFolders << dirPath;
+void DkImageLoader::subFolderScanned(const QString& dirPath, int numImages) {
 
-	qSort(subFolders.begin(), subFolders.end(), DkUtils::compLogicQString);
-	
+	// ignore results of previous scans
+	if (mDirScanner->numImages(dirPath) == -1)
+		return;
 
-	qDebug() << dirPath << "loaded recursively...";
-	
-	//qDebug() << "scanning folders recursively took me: " << QString::fromStdString(dt.getTotal());
-	return subFolders;
-}
+	QStringList::iterator it = qLowerBound(mSubFolders.begin(), mSubFolders.end(), dirPath, DkUtils::compLogicQString);
 
-QFileInfoList DkImageLoader::updateSubFolders(const QString& rootDirPath) {
-	
-	mSubFolders = getFoldersRecursive(rootDirPath);
-	QFileInfoList files;
-	qDebug() << mSubFolders;
-
-	// find the first subfolder that has images
-	for (int idx = 0; idx < mSubFolders.size(); idx++) {
-		mCurrentDir = mSubFolders[idx];
-		files = getFilteredFileInfoList(mCurrentDir, mIgnoreKeywords, mKeywords);		// this line takes seconds if you have lots of files and slow loading (e.g. network)
-		if (!files.empty())
-			break;
+	if (it == mSubFolders.end() || *it != dirPath)
+		mSubFolders.insert(it, dirPath);
+
+	// the root folder has no images - show the first sub folder that has
+	if (mWaitForSubFolder && numImages > 0 && hasImages(dirPath)) {
+
+		mWaitForSubFolder = false;
+
+		if (loadDir(dirPath, false))
+			firstFile();
 	}
+}
 
-	return files;
+void DkImageLoader::subFoldersScanned() {
+
+	if (!mWaitForSubFolder)
+		return;
+
+	mWaitForSubFolder = false;
+	emit showInfoSignal(tr("%1 \n does not contain any image").arg(mDirScanner->rootDirPath()), 4000);
+}
+
+/**
+ * Checks if a folder has images.
+ * The result of the sub folder scan is used if available.
+ * @param dirPath the folder.
+ * @return bool true if the folder has (unfiltered) images.
+ **/
+bool DkImageLoader::hasImages(const QString& dirPath) {
+
+	int numImages = mDirScanner->numImages(dirPath);
+
+	// we can trust the scanner if there are no keywords that filter the images
+	if (numImages == 0 || (numImages > 0 && mIgnoreKeywords.empty() && mKeywords.empty()))
+		return numImages > 0;
+
+	return !getFilteredFileInfoList(dirPath, mIgnoreKeywords, mKeywords).empty();		// this line takes seconds if you have lots of files and slow loading (e.g. network)
 }
 
 int DkImageLoader::getNextFolderIdx(int folderIdx) {
@@ -1640,9 +1744,7 @@ int DkImageLoader::getNextFolderIdx(int folderIdx) {
 		else if (tmpNextIdx >= mSubFolders.size())
 			return -1;
 
-		QDir cDir = mSubFolders[tmpNextIdx];
-		QFileInfoList cFiles = getFilteredFileInfoList(cDir.absolutePath(), mIgnoreKeywords, mKeywords);		// this line takes seconds if you have lots of files and slow loading (e.g. network)
-		if (!cFiles.empty()) {
+		if (hasImages(mSubFolders[tmpNextIdx])) {
 			nextIdx = tmpNextIdx;
 			break;
 		}
@@ -1668,9 +1770,7 @@ int DkImageLoader::getPrevFolderIdx(int folderIdx) {
 		else if (tmpPrevIdx < 0)
 			return -1;
 
-		QDir cDir = mSubFolders[tmpPrevIdx];
-		QFileInfoList cFiles = getFilteredFileInfoList(cDir.absolutePath(), mIgnoreKeywords, mKeywords);		// this line takes seconds if you have lots of files and slow loading (e.g. network)
-		if (!cFiles.empty()) {
+		if (hasImages(mSubFolders[tmpPrevIdx])) {
 			prevIdx = tmpPrevIdx;
 			break;
 		}
@@ -1708,6 +1808,14 @@ void DkImageLoader::updateCacher(QSharedPointer<DkImageContainerT> imgC) {
 	int cIdx = findFileIdx(imgC->filePath(), mImages);
 	float mem = 0;
 
+	DkSlideshowScheduler& slideshow = DkSlideshowScheduler::instance();
+	DkImageCache& cache = DkImageCache::instance();	// images of all tabs share one budget
+
+	DK_TRACE("load", "updateCacher");
+	DK_TRACE_COUNTER("image cache bytes", cache.memoryUsage()*1024.0*1024.0);
+	DK_TRACE_COUNTER("thumbs loading", Settings::param().resources().numThumbsLoading);
+	DK_TRACE_COUNTER("active threads", QThreadPool::globalInstance()->activeThreadCount());
+
 	if (cIdx == -1) {
 		qDebug() << "WARNING: image not found for caching!";
 		return;
@@ -1732,12 +1840,18 @@ void DkImageLoader::updateCacher(QSharedPointer<DkImageContainerT> imgC) {
 		if (idx == cIdx-1 || idx == cIdx) {
 			continue;
 		}
+		// slideshow: load all images that would not be decoded in time (screen sized)
+		else if (slideshow.preloadNow(mImages.at(idx)->filePath(), idx-cIdx) && mem < Settings::param().resources().cacheMemory && cache.withinBudget() && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
+			mImages.at(idx)->setPreviewSize(mPreviewSize);
+			mImages.at(idx)->loadImageThreaded();
+			qDebug() << "[Cacher] " << mImages.at(idx)->filePath() << " preloaded for the slideshow (" << idx-cIdx << "ahead)";
+		}
 		// fully load the next image
-		else if (idx == cIdx+1 && mem < Settings::param().resources().cacheMemory && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
+		else if (idx == cIdx+1 && mem < Settings::param().resources().cacheMemory && cache.withinBudget() && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
 			mImages.at(idx)->loadImageThreaded();
 			qDebug() << "[Cacher] " << mImages.at(idx)->filePath() << " fully cached...";
 		}
-		else if (idx > cIdx && idx < cIdx+Settings::param().resources().maxImagesCached-2 && mem < Settings::param().resources().cacheMemory && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
+		else if (idx > cIdx && idx < cIdx+Settings::param().resources().maxImagesCached-2 && mem < Settings::param().resources().cacheMemory && cache.withinBudget() && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
 			//dt.getIvl();
 			mImages.at(idx)->fetchFile();		// TODO: crash detected here
 			qDebug() << "[Cacher] " << mImages.at(idx)->filePath() << " file fetched...";
@@ -1752,7 +1866,7 @@ void DkImageLoader::updateCacher(QSharedPointer<DkImageContainerT> imgC) {
  * Returns the file list of the directory dir.
  * Note: this function might get slow if lots of files (> 10000) are in the
  * directory or if the directory is in the net.
- * Currently the file list is sorted according to the system specification.
+ * The file list is not sorted (createImages sorts the images).
  * @param dir the directory to load the file list from.
  * @param ignoreKeywords if one of these keywords is in the file name, the file will be ignored.
  * @param keywords if one of these keywords is not in the file name, the file will be ignored.
@@ -1762,66 +1876,8 @@ QFileInfoList DkImageLoader::getFilteredFileInfoList(const QString& dirPath, QSt
 
 	DkTimer dt;
 
-#ifdef WIN32
-
-	QString winPath = QDir::toNativeSeparators(dirPath) + "\\*.*";
-
-	const wchar_t* fname = reinterpret_cast<const wchar_t *>(winPath.utf16());
-
-	WIN32_FIND_DATAW findFileData;
-	HANDLE MyHandle = FindFirstFileW(fname, &findFileData);
-
-	std::vector<std::wstring> fileNameList;
-	std::wstring fileName;
-
-	if( MyHandle != INVALID_HANDLE_VALUE) {
-		
-		do {
-
-			fileName = findFileData.cFileName;
-			fileNameList.push_back(fileName);	// TODO: sort correct according to numbers
-		} while(FindNextFileW(MyHandle, &findFileData) != 0);
-	}
-
-	FindClose(MyHandle);
-	
-	// remove the * in fileFilters
-	QStringList fileFiltersClean = Settings::param().app().browseFilters;
-	for (QString& filter : fileFiltersClean)
-		filter.replace("*", "");
-
-	qDebug() << "browse filters: " << Settings::param().app().browseFilters;
-
-	QStringList fileList;
-	std::vector<std::wstring>::iterator lIter = fileNameList.begin();
-
-	// convert to QStringList
-	for (unsigned int idx = 0; idx < fileNameList.size(); idx++, lIter++) {
-		
-		QString qFilename = DkUtils::stdWStringToQString(*lIter);
-
-		// believe it or not, but this is 10 times faster than QRegExp
-		// drawback: we also get files that contain *.jpg*
-		for (int i = 0; i < fileFiltersClean.size(); i++) {
-
-			if (qFilename.contains(fileFiltersClean[i], Qt::CaseInsensitive)) {
-				fileList.append(qFilename);
-				break;
-			}
-		}
-	}
-
-	qDebug() << "WinAPI, indexed (" << fileList.size() <<") files in: " << dt.getTotal();
-#else
-
-	// true file list
-	QDir tmpDir = dirPath;
-	tmpDir.setSorting(QDir::LocaleAware);
-	QStringList fileList = tmpDir.entryList(Settings::param().app().browseFilters);
-	qDebug() << "Qt, sorted file list computed in: " << dt.getIvl();
-	qDebug() << fileList;
-
-#endif
+	QStringList fileList = DkDirScanner::listDir(dirPath, DkSuffixFilter(Settings::param().app().browseFilters));
+	qDebug() << "indexed (" << fileList.size() << ") files in: " << dt.getTotal();
 
 	for (int idx = 0; idx < ignoreKeywords.size(); idx++) {
 		QRegExp exp = QRegExp("^((?!" + ignoreKeywords[idx] + ").)*$");
@@ -1890,7 +1946,7 @@ QFileInfoList DkImageLoader::getFilteredFileInfoList(const QString& dirPath, QSt
 	QFileInfoList fileInfoList;
 	
 	for (int idx = 0; idx < fileList.size(); idx++)
-		fileInfoList.append(QFileInfo(mCurrentDir, fileList.at(idx)));
+		fileInfoList.append(QFileInfo(dirPath, fileList.at(idx)));
 
 	return fileInfoList;
 }
@@ -1909,6 +1965,14 @@ void DkImageLoader::currentImageUpdated() const {
 	emit imageUpdatedSignal(mCurrentImage);
 }
 
+void DkImageLoader::currentImageUpgraded() const {
+
+	if (mCurrentImage.isNull())
+		return;
+
+	emit imageUpgradedSignal(mCurrentImage);
+}
+
 /**
  * Returns the directory where files are saved to.
  * @return QDir the directory where the user saved the last file to.
@@ -1921,6 +1985,15 @@ QString DkImageLoader::getSavePath() const {
 		return mSaveDir;
 }
 
+/**
+ * Sets the size of previews which are shown before the full image is decoded.
+ * @param size the viewport size
+ **/ 
+void DkImageLoader::setPreviewSize(const QSize& size) {
+
+	mPreviewSize = size;
+}
+
 /**
 * Returns if an image is loaded currently.
 * @return bool true if an image is loaded.
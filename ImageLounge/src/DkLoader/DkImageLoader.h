@@ -50,11 +50,13 @@
 #endif
 
 // Qt defines
-class QFileSystemWatcher;
 class QUrl;
 
 namespace nmc {
 
+class DkDirScanner;
+class DkDirWatcher;
+
 /**
  * This class is a basic image loader class.
  * It takes care of the file watches for the current folder,
@@ -70,7 +72,6 @@ public:
 	DkImageLoader(const QString& filePath = QString());
 	virtual ~DkImageLoader();
 
-	static QStringList getFoldersRecursive(const QString& dirPath);
 	QFileInfoList updateSubFolders(const QString& rootDirPath);
 	QFileInfoList getFilteredFileInfoList(const QString& dirPath, QStringList ignoreKeywords = QStringList(), QStringList keywords = QStringList(), QStringList folderKeywords = QStringList());
 
@@ -85,6 +86,7 @@ public:
 	QSharedPointer<DkImageContainerT> setImage(const QImage& img, const QString& editName, const QString& editFilePath = QString());
 	QSharedPointer<DkImageContainerT> setImage(QSharedPointer<DkImageContainerT> img);
 	void setCurrentImage(QSharedPointer<DkImageContainerT> newImg);
+	void setPreviewSize(const QSize& size);
 	void sort();
 
 	// file selection
@@ -138,6 +140,7 @@ signals:
 	void imageUpdatedSignal(QSharedPointer<DkImageContainerT> image) const;
 	void imageUpdatedSignal(int idx) const;	// folder scrollbar needs that
 	void imageLoadedSignal(QSharedPointer<DkImageContainerT> image, bool loaded = true) const;
+	void imageUpgradedSignal(QSharedPointer<DkImageContainerT> image) const;
 	void showInfoSignal(const QString& msg, int time = 3000, int position = 0) const;
 	void updateDirSignal(QVector<QSharedPointer<DkImageContainerT> > images) const;
 	void imageHasGPSSignal(bool hasGPS) const;
@@ -147,6 +150,7 @@ public slots:
 	void redo();
 	void changeFile(int skipIdx);
 	void directoryChanged(const QString& path = QString());
+	void filesChanged(const QStringList& changed, const QStringList& removed);
 	void saveFileWeb(const QImage& saveImg);
 	void saveUserFileAs(const QImage& saveImg, bool silent);
 	void saveFile(const QString& filename, const QImage& saveImg = QImage(), const QString& fileFilter = "", int compression = -1, bool threaded = true);
@@ -164,9 +168,12 @@ public slots:
 
 	// new slots
 	void currentImageUpdated() const;
+	void currentImageUpgraded() const;
 	void imageLoaded(bool loaded = false);
 	void imageSaved(const QString& file, bool saved = true);
 	void imagesSorted();
+	void subFolderScanned(const QString& dirPath, int numImages);
+	void subFoldersScanned();
 	bool unloadFile();
 	void reloadImage();
 
@@ -175,6 +182,7 @@ protected:
 	void updateCacher(QSharedPointer<DkImageContainerT> imgC);
 	int getNextFolderIdx(int folderIdx);
 	int getPrevFolderIdx(int folderIdx);
+	bool hasImages(const QString& dirPath);
 	void updateHistory();
 	void sortImagesThreaded(QVector<QSharedPointer<DkImageContainerT > > images);
 	void createImages(const QFileInfoList& files, bool sort = true);
@@ -188,8 +196,10 @@ protected:
 	bool mTimerBlockedUpdate = false;
 	QString mCurrentDir;
 	QString mSaveDir;
-	QFileSystemWatcher* mDirWatcher = 0;
+	DkDirWatcher* mDirWatcher = 0;
 	QStringList mSubFolders;
+	DkDirScanner* mDirScanner = 0;
+	bool mWaitForSubFolder = false;		// the root folder has no images - load the first sub folder that is scanned
 	QVector<QSharedPointer<DkImageContainerT > > mImages;
 	QSharedPointer<DkImageContainerT > mCurrentImage;
 	QSharedPointer<DkImageContainerT > mLastImageLoaded;
@@ -197,6 +207,7 @@ protected:
 	int mTmpFileIdx = 0;
 	bool mSortingImages = false;
 	bool mSortingIsDirty = false;
+	QSize mPreviewSize;
 	QFutureWatcher<QVector<QSharedPointer<DkImageContainerT > > > mCreateImageWatcher;
 
 };
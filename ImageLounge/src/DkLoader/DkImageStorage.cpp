@@ -36,6 +36,7 @@
 #include <QPixmap>
 #include <QPainter>
 #include <QBitmap>
+#include <QtConcurrentRun>
 #pragma warning(pop)		// no warnings from includes - end
 
 #if defined(WIN32) && !defined(SOCK_STREAM)
@@ -352,7 +353,8 @@ QImage DkImage::resizeImage(const QImage& img, const QSize& newSize, float facto
 	try {
 		
 		QImage qImg;
-		cv::Mat resizeImage = DkImage::qImage2Mat(img);
+		DkMatView view(img);
+		cv::Mat resizeImage = view.mat();
 		
 		if (correctGamma) {
 			resizeImage.convertTo(resizeImage, CV_16U, USHRT_MAX/255.0f);
@@ -374,7 +376,7 @@ QImage DkImage::resizeImage(const QImage& img, const QSize& newSize, float facto
 				resizeImage.convertTo(resizeImage, CV_8U, 255.0f/USHRT_MAX);
 			}
 
-			qImg = DkImage::mat2QImage(resizeImage);
+			qImg = DkMatView::toQImage(resizeImage);
 		}
 
 		if (!img.colorTable().isEmpty())
@@ -524,7 +526,14 @@ QImage DkImage::normImage(const QImage& img) {
 	return imgN;
 }
 
-bool DkImage::normImage(QImage& img) {
+/**
+ * Stretches the image's values so that they cover the full range [0 255].
+ * All channels are stretched with the same factor.
+ * @param img the image (is changed in place)
+ * @param hist the image's histogram - if it is valid, it is used instead of scanning the image and it is updated (or cleared if it cannot be updated)
+ * @return bool false if the image is normalized already
+ **/ 
+bool DkImage::normImage(QImage& img, DkImageHistogram* hist) {
 
 	uchar maxVal = 0;
 	uchar minVal = 255;
@@ -532,28 +541,54 @@ bool DkImage::normImage(QImage& img) {
 	// number of used bytes per line
 	int bpl = (img.width() * img.depth() + 7) / 8;
 	int pad = img.bytesPerLine() - bpl;
-	uchar* mPtr = img.bits();
 	bool hasAlpha = img.hasAlphaChannel() || img.format() == QImage::Format_RGB32;
 
-	for (int rIdx = 0; rIdx < img.height(); rIdx++) {
+	// the histogram of indexed images refers to their colors (not the indexes which we normalize here)
+	bool useHist = DkImageHistogram::isSupported(img.format()) && img.format() != QImage::Format_Indexed8;
+	
+	if (useHist) {
+
+		DkImageHistogram h = (hist && !hist->isEmpty() && !hist->isApproximate()) ? *hist : DkImageHistogram::compute(img);
+
+		for (int idx = 0; idx < DkImageHistogram::num_channels; idx++) {
+			minVal = qMin(minVal, h.minBin(idx));
+			maxVal = qMax(maxVal, h.maxBin(idx));
+		}
+
+		if (hist)
+			*hist = h;
+	}
+	else {
+		// the histogram cannot be remapped
+		if (hist)
+			*hist = DkImageHistogram();
+
+		const uchar* mPtr = img.constBits();
+
+		for (int rIdx = 0; rIdx < img.height(); rIdx++) {
 		
-		for (int cIdx = 0; cIdx < bpl; cIdx++, mPtr++) {
+			for (int cIdx = 0; cIdx < bpl; cIdx++, mPtr++) {
 			
-			if (hasAlpha && cIdx % 4 == 3)
-				continue;
+				if (hasAlpha && cIdx % 4 == 3)
+					continue;
 
-			if (*mPtr > maxVal)
-				maxVal = *mPtr;
-			if (*mPtr < minVal)
-				minVal = *mPtr;
-		}
+				if (*mPtr > maxVal)
+					maxVal = *mPtr;
+				if (*mPtr < minVal)
+					minVal = *mPtr;
+			}
 		
-		mPtr += pad;
+			mPtr += pad;
+		}
 	}
 
 	if ((minVal == 0 && maxVal == 255) || maxVal-minVal == 0)
 		return false;
 
+	uchar lut[256];
+	for (int idx = 0; idx < 256; idx++)
+		lut[idx] = (uchar)qRound(255.0f*(qMax(idx, (int)minVal)-minVal)/(maxVal-minVal));
+
 	uchar* ptr = img.bits();
 	
 	for (int rIdx = 0; rIdx < img.height(); rIdx++) {
@@ -563,12 +598,15 @@ bool DkImage::normImage(QImage& img) {
 			if (hasAlpha && cIdx % 4 == 3)
 				continue;
 
-			*ptr = (uchar)qRound(255.0f*(*ptr-minVal)/(maxVal-minVal));
+			*ptr = lut[*ptr];
 		}
 		
 		ptr += pad;
 	}
 
+	if (hist && useHist)
+		hist->remap(lut, lut, lut);
+
 	return true;
 
 }
@@ -581,7 +619,13 @@ QImage DkImage::autoAdjustImage(const QImage& img) {
 	return imgA;
 }
 
-bool DkImage::autoAdjustImage(QImage& img) {
+/**
+ * Stretches each color channel so that it covers the full range [0 255].
+ * @param img the image (is changed in place)
+ * @param hist the image's histogram - if it is valid, it is used instead of scanning the image and it is updated
+ * @return bool false if the image cannot be adjusted
+ **/ 
+bool DkImage::autoAdjustImage(QImage& img, DkImageHistogram* hist) {
 
 	//return DkImage::unsharpMask(img, 30.0f, 1.5f);
 
@@ -591,7 +635,7 @@ bool DkImage::autoAdjustImage(QImage& img) {
 	// for grayscale image - normalize is the same
 	if (img.format() <= QImage::Format_Indexed8) {
 		qDebug() << "[Auto Adjust] Grayscale - switching to Normalize: " << img.format();
-		return normImage(img);
+		return normImage(img, hist);
 	}
 	else if (img.format() != QImage::Format_ARGB32 && img.format() != QImage::Format_ARGB32_Premultiplied && 
 		img.format() != QImage::Format_RGB32 && img.format() != QImage::Format_RGB888) {
@@ -599,120 +643,71 @@ bool DkImage::autoAdjustImage(QImage& img) {
 		return false;
 	}
 
-	int channels = (img.hasAlphaChannel() || img.format() == QImage::Format_RGB32) ? 4 : 3;
-
-	uchar maxR = 0,		maxG = 0,	maxB = 0;
-	uchar minR = 255,	minG = 255, minB = 255;
-
-	// number of bytes per line used
-	int bpl = (img.width() * img.depth() + 7) / 8;
-	int pad = img.bytesPerLine() - bpl;
-
-	uchar* mPtr = img.bits();
-	uchar r,g,b;
-
-	int histR[256] = {0};
-	int histG[256] = {0};
-	int histB[256] = {0};
-
-	for (int rIdx = 0; rIdx < img.height(); rIdx++) {
-
-		for (int cIdx = 0; cIdx < bpl; ) {
-
-			r = *mPtr; mPtr++;
-			g = *mPtr; mPtr++;
-			b = *mPtr; mPtr++;
-			cIdx += 3;
-
-			if (r > maxR)	maxR = r;
-			if (r < minR)	minR = r;
-
-			if (g > maxG)	maxG = g;
-			if (g < minG)	minG = g;
+	DkImageHistogram h = (hist && !hist->isEmpty() && !hist->isApproximate()) ? *hist : DkImageHistogram::compute(img);
 
-			if (b > maxB)	maxB = b;
-			if (b < minB)	minB = b;
+	uchar minVals[3], maxVals[3];
+	bool ignore[3];
 
-			histR[r]++;
-			histG[g]++;
-			histB[b]++;
+	for (int cIdx = 0; cIdx < DkImageHistogram::num_channels; cIdx++) {
 
+		minVals[cIdx] = h.minBin(cIdx);
+		maxVals[cIdx] = h.maxBin(cIdx);
+		ignore[cIdx] = maxVals[cIdx]-minVals[cIdx] == 0 || maxVals[cIdx]-minVals[cIdx] == 255;
 
-			// ?? strange but I would expect the alpha channel to be the first (big endian?)
-			if (channels == 4) {
-				mPtr++;
-				cIdx++;
-			}
-
+		if (ignore[cIdx]) {
+			maxVals[cIdx] = findHistPeak(h.channel(cIdx));
+			ignore[cIdx] = maxVals[cIdx]-minVals[cIdx] == 0 || maxVals[cIdx]-minVals[cIdx] == 255;
 		}
-		mPtr += pad;
-	}
-
-	QColor ignoreChannel;
-	bool ignoreR = maxR-minR == 0 || maxR-minR == 255;
-	bool ignoreG = maxR-minR == 0 || maxG-minG == 255;
-	bool ignoreB = maxR-minR == 0 || maxB-minB == 255;
-
-	uchar* ptr = img.bits();
-
-	if (ignoreR) {
-		maxR = findHistPeak(histR);
-		ignoreR = maxR-minR == 0 || maxR-minR == 255;
-	}
-	if (ignoreG) {
-		maxG = findHistPeak(histG);
-		ignoreG = maxG-minG == 0 || maxG-minG == 255;
-	}
-	if (ignoreB) {
-		maxB = findHistPeak(histB);
-		ignoreB = maxB-minB == 0 || maxB-minB == 255;
 	}
 
-	//qDebug() << "red max: " << maxR << " min: " << minR << " ignored: " << ignoreR;
-	//qDebug() << "green max: " << maxG << " min: " << minG << " ignored: " << ignoreG;
-	//qDebug() << "blue max: " << maxB << " min: " << minB << " ignored: " << ignoreB;
-	//qDebug() << "computed in: " << dt.getTotal();
-
-	if (ignoreR && ignoreG && ignoreB) {
+	if (ignore[0] && ignore[1] && ignore[2]) {
 		qDebug() << "[Auto Adjust] There is no need to adjust the image";
 		return false;
 	}
 
-	for (int rIdx = 0; rIdx < img.height(); rIdx++) {
+	// lookup tables for all channels
+	uchar luts[3][256];
 
-		for (int cIdx = 0; cIdx < bpl; ) {
+	for (int cIdx = 0; cIdx < DkImageHistogram::num_channels; cIdx++) {
+		
+		for (int idx = 0; idx < 256; idx++) {
 
-			// don't check values - speed (but you see under-/overflows anyway)
-			if (!ignoreR && *ptr < maxR)
-				*ptr = (uchar)qRound(255.0f*((float)*ptr-minR)/(maxR-minR));
-			else if (!ignoreR)
-				*ptr = 255;
+			if (ignore[cIdx])
+				luts[cIdx][idx] = (uchar)idx;
+			else if (idx < maxVals[cIdx])
+				luts[cIdx][idx] = (uchar)qRound(255.0f*(qMax(idx, (int)minVals[cIdx])-minVals[cIdx])/(maxVals[cIdx]-minVals[cIdx]));
+			else
+				luts[cIdx][idx] = 255;
+		}
+	}
 
-			ptr++;
-			cIdx++;
+	if (img.depth() == 32) {
 
-			if (!ignoreG && *ptr < maxG)
-				*ptr = (uchar)qRound(255.0f*((float)*ptr-minG)/(maxG-minG));
-			else if (!ignoreG)
-				*ptr = 255;
+		for (int rIdx = 0; rIdx < img.height(); rIdx++) {
 
-			ptr++;
-			cIdx++;
+			QRgb* ptr = (QRgb*)img.scanLine(rIdx);
 
-			if (!ignoreB && *ptr < maxB)
-				*ptr = (uchar)qRound(255.0f*((float)*ptr-minB)/(maxB-minB));
-			else if (!ignoreB)
-				*ptr = 255;
-			ptr++;
-			cIdx++;
+			for (int cIdx = 0; cIdx < img.width(); cIdx++, ptr++)
+				*ptr = qRgba(luts[0][qRed(*ptr)], luts[1][qGreen(*ptr)], luts[2][qBlue(*ptr)], qAlpha(*ptr));
+		}
+	}
+	else {
 
-			if (channels == 4) {
-				ptr++;
-				cIdx++;
-			}
+		for (int rIdx = 0; rIdx < img.height(); rIdx++) {
 
+			uchar* ptr = img.scanLine(rIdx);
+
+			for (int cIdx = 0; cIdx < img.width(); cIdx++) {
+				*ptr = luts[0][*ptr]; ptr++;
+				*ptr = luts[1][*ptr]; ptr++;
+				*ptr = luts[2][*ptr]; ptr++;
+			}
 		}
-		ptr += pad;
+	}
+
+	if (hist) {
+		*hist = h;
+		hist->remap(luts[0], luts[1], luts[2]);
 	}
 
 	qDebug() << "[Auto Adjust] image adjusted in: " << dt.getTotal();
@@ -844,6 +839,172 @@ QImage DkImage::mat2QImage(cv::Mat img) {
 	return qImg;
 }
 
+// DkMatView --------------------------------------------------------------------
+QAtomicInt DkMatView::sNumConversions(0);
+
+/**
+ * Creates a read only view of img.
+ * @param img the image (it is not copied if its format is supported).
+ * @param keepGray if false, grayscale images are converted to ARGB32 (CV_8UC4).
+ **/
+DkMatView::DkMatView(const QImage& img, bool keepGray) {
+
+	mImg = img;
+	int type = prepare(mImg, keepGray);
+
+	// constBits() does not detach
+	if (type != -1)
+		mMat = cv::Mat(mImg.height(), mImg.width(), type, const_cast<uchar*>(mImg.constBits()), mImg.bytesPerLine());
+}
+
+/**
+ * Creates a writable view of img.
+ * Changes of the cv::Mat are written to img directly.
+ * img is converted if its format is not supported.
+ * @param img the image.
+ * @param keepGray if false, grayscale images are converted to ARGB32 (CV_8UC4).
+ **/
+DkMatView::DkMatView(QImage* img, bool keepGray) {
+
+	if (!img)
+		return;
+
+	int type = prepare(*img, keepGray);
+
+	// bits() detaches if the image is shared
+	if (type != -1)
+		mMat = cv::Mat(img->height(), img->width(), type, img->bits(), img->bytesPerLine());
+}
+
+cv::Mat& DkMatView::mat() {
+	return mMat;
+}
+
+/**
+ * Returns true if the image format had to be converted.
+ * @return bool true if the image was copied.
+ **/
+bool DkMatView::isConverted() const {
+	return mConverted;
+}
+
+/**
+ * Returns the number of images that had to be converted (copied)
+ * since the layouts of the QImage and the cv::Mat differed.
+ * @return int the number of conversions.
+ **/
+int DkMatView::numConversions() {
+	return sNumConversions.load();
+}
+
+int DkMatView::prepare(QImage& img, bool keepGray) {
+
+	if (img.isNull())
+		return -1;
+
+	switch (img.format()) {
+	case QImage::Format_RGB32:
+	case QImage::Format_ARGB32:
+		return CV_8UC4;
+	case QImage::Format_RGB888:
+		return CV_8UC3;
+#if QT_VERSION >= 0x050500
+	case QImage::Format_Grayscale8:
+		if (keepGray)
+			return CV_8UC1;
+		break;
+#endif
+	case QImage::Format_Indexed8:
+		if (keepGray && isGrayRamp(img))
+			return CV_8UC1;
+		break;
+	default:
+		break;
+	}
+
+	DK_TRACE("convert", "DkMatView");
+	img = img.convertToFormat(QImage::Format_ARGB32);
+	mConverted = true;
+
+	int numConversions = sNumConversions.fetchAndAddRelaxed(1) + 1;
+	DK_TRACE_COUNTER("image conversions", numConversions);
+
+	return CV_8UC4;
+}
+
+bool DkMatView::isGrayRamp(const QImage& img) {
+
+	QVector<QRgb> colorTable = img.colorTable();
+
+	if (colorTable.size() != 256)
+		return false;
+
+	for (int idx = 0; idx < colorTable.size(); idx++) {
+		if (colorTable[idx] != qRgb(idx, idx, idx))
+			return false;
+	}
+
+	return true;
+}
+
+static void releaseMat(void* mat) {
+	delete static_cast<cv::Mat*>(mat);
+}
+
+/**
+ * Converts a cv::Mat to a QImage without copying its pixels.
+ * The QImage keeps a reference to the Mat's buffer, hence the Mat must not
+ * be changed afterwards. Use DkImage::mat2QImage if you need a copy.
+ * @param img supported formats CV_8UC1 | CV_8UC3 | CV_8UC4
+ * @return QImage the corresponding QImage
+ **/
+QImage DkMatView::toQImage(cv::Mat img) {
+
+	QImage::Format format = QImage::Format_Invalid;
+
+	switch (img.type()) {
+#if QT_VERSION >= 0x050500
+	case CV_8UC1:	format = QImage::Format_Grayscale8; break;
+#else
+	case CV_8UC1:	format = QImage::Format_Indexed8; break;
+#endif
+	case CV_8UC3:	format = QImage::Format_RGB888; break;
+	case CV_8UC4:	format = QImage::Format_ARGB32; break;
+	}
+
+#if CV_MAJOR_VERSION >= 3
+	bool ownsData = img.u != 0;
+#else
+	bool ownsData = img.refcount != 0;
+#endif
+
+	QImage qImg;
+
+	// QImage needs 32 bit aligned lines - and we can only share ref counted buffers
+#if QT_VERSION >= 0x050000
+	if (format != QImage::Format_Invalid && ownsData && (quintptr)img.data % 4 == 0 && img.step % 4 == 0) {
+		cv::Mat* owner = new cv::Mat(img);
+		qImg = QImage(owner->data, owner->cols, owner->rows, (int)owner->step, format, releaseMat, owner);
+	}
+#endif
+
+	if (qImg.isNull()) {
+		int numConversions = sNumConversions.fetchAndAddRelaxed(1) + 1;
+		DK_TRACE_COUNTER("image conversions", numConversions);
+		qImg = DkImage::mat2QImage(img);
+	}
+
+	if (qImg.format() == QImage::Format_Indexed8 && qImg.colorTable().isEmpty()) {
+
+		QVector<QRgb> grayRamp(256);
+		for (int idx = 0; idx < grayRamp.size(); idx++)
+			grayRamp[idx] = qRgb(idx, idx, idx);
+		qImg.setColorTable(grayRamp);
+	}
+
+	return qImg;
+}
+
 cv::Mat DkImage::get1DGauss(double sigma) {
 
 	// correct -> checked with matlab reference
@@ -986,12 +1147,12 @@ void DkImage::tinyPlanet(QImage& img, double scaleLog, double angle, QSize s, bo
 	// make square
 	img = img.scaled(s, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 
-	cv::Mat mImg = DkImage::qImage2Mat(img);
+	// logPolar writes to img directly (remap copies the source)
+	DkMatView view(&img);
+	cv::Mat& mImg = view.mat();
 
 	qDebug() << "scale log: " << scaleLog << " inverted: " << invert;
 	logPolar(mImg, mImg, cv::Point2d(mImg.cols*0.5, mImg.rows*0.5), scaleLog, angle);
-
-	img = DkImage::mat2QImage(mImg);
 }
 
 #endif
@@ -1001,7 +1162,8 @@ bool DkImage::unsharpMask(QImage& img, float sigma, float weight) {
 #ifdef WITH_OPENCV
 	DkTimer dt;
 	//DkImage::gammaToLinear(img);
-	cv::Mat imgCv = DkImage::qImage2Mat(img);
+	DkMatView view(&img);	// the result is written to img directly
+	cv::Mat& imgCv = view.mat();
 
 	cv::Mat imgG;
 	cv::Mat gx = cv::getGaussianKernel(qRound(4*sigma+1), sigma);
@@ -1009,9 +1171,8 @@ bool DkImage::unsharpMask(QImage& img, float sigma, float weight) {
 	cv::sepFilter2D(imgCv, imgG, CV_8U, gx, gy);
 	//cv::GaussianBlur(imgCv, imgG, cv::Size(4*sigma+1, 4*sigma+1), sigma);		// this is awesomely slow
 	cv::addWeighted(imgCv, weight, imgG, 1-weight, 0, imgCv);
-	img = DkImage::mat2QImage(imgCv);
 
-	qDebug() << "unsharp mask takes: " << dt.getTotal();
+	qDebug() << "unsharp mask takes: " << dt.getTotal() << "image conversions so far:" << DkMatView::numConversions();
 	//DkImage::linearToGamma(img);
 #endif
 
@@ -1087,6 +1248,54 @@ bool DkImage::addToImage(QImage& img, unsigned char val) {
 	return done;
 };
 
+/**
+ * Blends two images (dst = alpha * from + (1-alpha) * to).
+ * Both images need to have the same size and ARGB32_Premultiplied format.
+ * Two channels are blended with one multiplication which makes it fast
+ * enough to be done for every frame of an animation.
+ * @param from the first image
+ * @param to the second image
+ * @param alpha the weight of the first image [0 1]
+ * @param dst the blended image (it is reallocated if its size or format does not match)
+ * @return bool false if the images cannot be blended
+ **/ 
+bool DkImage::crossFade(const QImage& from, const QImage& to, float alpha, QImage& dst) {
+
+	if (from.size() != to.size() || 
+		from.format() != QImage::Format_ARGB32_Premultiplied || 
+		to.format() != QImage::Format_ARGB32_Premultiplied)
+		return false;
+
+	if (dst.size() != from.size() || dst.format() != QImage::Format_ARGB32_Premultiplied)
+		dst = QImage(from.size(), QImage::Format_ARGB32_Premultiplied);
+
+#if QT_VERSION >= 0x050000
+	dst.setDevicePixelRatio(from.devicePixelRatio());	// HiDPI buffers
+#endif
+
+	// 8 bit weights that sum up to 256 -> the products fit into 16 bit
+	quint32 a = qBound(0, qRound(alpha * 256), 256);
+	quint32 ia = 256 - a;
+
+	for (int rIdx = 0; rIdx < dst.height(); rIdx++) {
+
+		const quint32* fPtr = reinterpret_cast<const quint32*>(from.constScanLine(rIdx));
+		const quint32* tPtr = reinterpret_cast<const quint32*>(to.constScanLine(rIdx));
+		quint32* dPtr = reinterpret_cast<quint32*>(dst.scanLine(rIdx));
+
+		for (int cIdx = 0; cIdx < dst.width(); cIdx++) {
+
+			// red & blue | alpha & green
+			quint32 rb = ((fPtr[cIdx] & 0x00ff00ff) * a + (tPtr[cIdx] & 0x00ff00ff) * ia) >> 8;
+			quint32 ag = ((fPtr[cIdx] >> 8) & 0x00ff00ff) * a + ((tPtr[cIdx] >> 8) & 0x00ff00ff) * ia;
+
+			dPtr[cIdx] = (rb & 0x00ff00ff) | (ag & 0xff00ff00);
+		}
+	}
+
+	return true;
+}
+
 QColor DkImage::getMeanColor(const QImage& img) {
 
 	// some speed-up params
@@ -1139,6 +1348,395 @@ QColor DkImage::getMeanColor(const QImage& img) {
 }
 
 
+// DkImageHistogram --------------------------------------------------------------------
+DkImageHistogram::DkImageHistogram() {
+}
+
+/**
+ * Computes the histogram of an image.
+ * The image is split into row blocks which are processed in parallel.
+ * @param img the image
+ * @param level if > 0, only every 2^level-th row and column is sampled
+ * @return DkImageHistogram the histogram (empty if the image is empty)
+ **/ 
+DkImageHistogram DkImageHistogram::compute(const QImage& img, int level) {
+
+	if (img.isNull())
+		return DkImageHistogram();
+
+	DkTimer dt;
+
+	QImage cImg = img;
+
+	// convert formats we cannot handle (e.g. mono or 16 bit RGB)
+	if (!isSupported(cImg.format()))
+		cImg = cImg.convertToFormat(cImg.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+	DkImageHistogram hist = computeRect(cImg, cImg.rect(), 1 << qMax(level, 0));
+	hist.mLevel = qMax(level, 0);
+
+	qDebug() << "[DkImageHistogram] level" << level << "of" << img.size() << "computed in" << dt.getTotal();
+
+	return hist;
+}
+
+/**
+ * Returns the coarsest level which still has more than maxPixels samples.
+ * @param imgSize the image size
+ * @param maxPixels the number of samples that should be used
+ * @return int the level (0 if the image is small)
+ **/ 
+int DkImageHistogram::level(const QSize& imgSize, int maxPixels) {
+
+	int level = 0;
+
+	if (maxPixels <= 0)
+		return level;
+	
+	while ((qint64)(imgSize.width() >> (level+1)) * (imgSize.height() >> (level+1)) >= maxPixels)
+		level++;
+
+	return level;
+}
+
+bool DkImageHistogram::isSupported(QImage::Format format) {
+
+	switch (format) {
+	case QImage::Format_RGB32:
+	case QImage::Format_ARGB32:
+	case QImage::Format_ARGB32_Premultiplied:
+	case QImage::Format_RGB888:
+	case QImage::Format_Indexed8:
+#if QT_VERSION >= 0x050500
+	case QImage::Format_Grayscale8:
+#endif
+#if QT_VERSION >= 0x050C00
+	case QImage::Format_RGBX64:
+	case QImage::Format_RGBA64:
+	case QImage::Format_RGBA64_Premultiplied:
+#endif
+		return true;
+	default:
+		return false;
+	}
+}
+
+DkImageHistogram DkImageHistogram::computeRect(const QImage& img, const QRect& rect, int step) {
+
+	QRect r = rect.intersected(img.rect());
+	
+	if (r.isEmpty())
+		return DkImageHistogram();
+
+	// blocks must start at a sampled row
+	int numRows = (r.height() + step - 1) / step;
+	int numBlocks = qMin(QThread::idealThreadCount(), numRows / 64 + 1);
+	
+	// small images are not worth the threading overhead
+	if ((qint64)numRows * (r.width() / step) < 256*256)
+		numBlocks = 1;
+
+	if (numBlocks <= 1)
+		return computeBlock(img, r, step);
+
+	int blockRows = (numRows + numBlocks - 1) / numBlocks * step;
+	QVector<QFuture<DkImageHistogram> > blocks;
+
+	for (int y = r.top(); y <= r.bottom(); y += blockRows) {
+		QRect br(r.left(), y, r.width(), qMin(blockRows, r.bottom() - y + 1));
+		blocks << QtConcurrent::run(&DkImageHistogram::computeBlock, img, br, step);
+	}
+
+	DkImageHistogram hist;
+	for (QFuture<DkImageHistogram>& f : blocks)
+		hist += f.result();
+
+	return hist;
+}
+
+/**
+ * The histogram kernel.
+ * Two sets of bins are filled alternately: neighboring pixels often have the same
+ * values and the increments of a single set would have to wait for each other.
+ **/ 
+DkImageHistogram DkImageHistogram::computeBlock(const QImage& img, const QRect& r, int step) {
+
+	QVector<int> bins(2 * num_channels * num_bins, 0);
+	int* h0 = bins.data();
+	int* h1 = h0 + num_channels * num_bins;
+	
+	int* r0 = h0;	int* g0 = h0 + num_bins;	int* b0 = h0 + 2*num_bins;
+	int* r1 = h1;	int* g1 = h1 + num_bins;	int* b1 = h1 + 2*num_bins;
+
+	int xe = r.left() + r.width();
+	int x = 0;
+	qint64 numPixels = 0;
+
+	switch (img.depth()) {
+
+	case 8: {
+
+		// count the indexes first - indexed colors are resolved afterwards
+		int idx0[num_bins] = {0};
+		int idx1[num_bins] = {0};
+
+		for (int y = r.top(); y <= r.bottom(); y += step) {
+
+			const uchar* px = img.constScanLine(y);
+
+			for (x = r.left(); x + step < xe; x += 2*step) {
+				idx0[px[x]]++;
+				idx1[px[x+step]]++;
+			}
+			if (x < xe)
+				idx0[px[x]]++;
+		}
+
+		QVector<QRgb> colors = img.format() == QImage::Format_Indexed8 ? img.colorTable() : QVector<QRgb>();
+
+		for (int idx = 0; idx < num_bins; idx++) {
+
+			int cnt = idx0[idx] + idx1[idx];
+
+			if (idx < colors.size()) {
+				r0[qRed(colors[idx])] += cnt;
+				g0[qGreen(colors[idx])] += cnt;
+				b0[qBlue(colors[idx])] += cnt;
+			}
+			else {
+				r0[idx] += cnt;
+				g0[idx] += cnt;
+				b0[idx] += cnt;
+			}
+			numPixels += cnt;
+		}
+		break;
+	}
+	case 24: {
+
+		for (int y = r.top(); y <= r.bottom(); y += step) {
+
+			const uchar* px = img.constScanLine(y);
+
+			for (x = r.left(); x + step < xe; x += 2*step) {
+				const uchar* p0 = px + 3*x;
+				const uchar* p1 = px + 3*(x+step);
+				r0[p0[0]]++; g0[p0[1]]++; b0[p0[2]]++;
+				r1[p1[0]]++; g1[p1[1]]++; b1[p1[2]]++;
+			}
+			if (x < xe) {
+				const uchar* p0 = px + 3*x;
+				r0[p0[0]]++; g0[p0[1]]++; b0[p0[2]]++;
+			}
+		}
+		break;
+	}
+	case 32: {
+
+		for (int y = r.top(); y <= r.bottom(); y += step) {
+
+			const QRgb* px = (const QRgb*)img.constScanLine(y);
+
+			for (x = r.left(); x + step < xe; x += 2*step) {
+				QRgb p0 = px[x];
+				QRgb p1 = px[x+step];
+				r0[qRed(p0)]++; g0[qGreen(p0)]++; b0[qBlue(p0)]++;
+				r1[qRed(p1)]++; g1[qGreen(p1)]++; b1[qBlue(p1)]++;
+			}
+			if (x < xe) {
+				QRgb p0 = px[x];
+				r0[qRed(p0)]++; g0[qGreen(p0)]++; b0[qBlue(p0)]++;
+			}
+		}
+		break;
+	}
+	case 64: {
+
+		// 16 bit per channel - we bin the upper 8 bits
+		for (int y = r.top(); y <= r.bottom(); y += step) {
+
+			const quint16* px = (const quint16*)img.constScanLine(y);
+
+			for (x = r.left(); x + step < xe; x += 2*step) {
+				const quint16* p0 = px + 4*x;
+				const quint16* p1 = px + 4*(x+step);
+				r0[p0[0] >> 8]++; g0[p0[1] >> 8]++; b0[p0[2] >> 8]++;
+				r1[p1[0] >> 8]++; g1[p1[1] >> 8]++; b1[p1[2] >> 8]++;
+			}
+			if (x < xe) {
+				const quint16* p0 = px + 4*x;
+				r0[p0[0] >> 8]++; g0[p0[1] >> 8]++; b0[p0[2] >> 8]++;
+			}
+		}
+		break;
+	}
+	}
+
+	DkImageHistogram hist;
+	hist.mHist = QVector<int>(num_channels * num_bins);
+
+	for (int idx = 0; idx < num_channels * num_bins; idx++)
+		hist.mHist[idx] = h0[idx] + h1[idx];
+
+	if (img.depth() != 8)
+		numPixels = (qint64)((r.height() + step - 1) / step) * ((r.width() + step - 1) / step);
+
+	hist.mNumPixels = numPixels;
+
+	return hist;
+}
+
+bool DkImageHistogram::isEmpty() const {
+	return mHist.isEmpty();
+}
+
+bool DkImageHistogram::isApproximate() const {
+	return mLevel > 0;
+}
+
+int DkImageHistogram::getLevel() const {
+	return mLevel;
+}
+
+qint64 DkImageHistogram::numPixels() const {
+	return mNumPixels;
+}
+
+/**
+ * Returns the bins of a channel.
+ * @param channel the channel (0 = red, 1 = green, 2 = blue)
+ * @return const int* num_bins values or 0 if the histogram is empty
+ **/ 
+const int* DkImageHistogram::channel(int channel) const {
+
+	if (isEmpty() || channel < 0 || channel >= num_channels)
+		return 0;
+
+	return mHist.constData() + channel * num_bins;
+}
+
+int DkImageHistogram::maxCount() const {
+
+	int maxVal = 0;
+
+	for (int v : mHist)
+		maxVal = qMax(maxVal, v);
+
+	return maxVal;
+}
+
+uchar DkImageHistogram::minBin(int channel) const {
+
+	const int* c = this->channel(channel);
+
+	for (int idx = 0; c && idx < num_bins; idx++) {
+		if (c[idx] > 0)
+			return (uchar)idx;
+	}
+
+	return 255;
+}
+
+uchar DkImageHistogram::maxBin(int channel) const {
+
+	const int* c = this->channel(channel);
+
+	for (int idx = num_bins-1; c && idx >= 0; idx--) {
+		if (c[idx] > 0)
+			return (uchar)idx;
+	}
+
+	return 0;
+}
+
+/**
+ * Returns the histogram of a cropped image.
+ * If most of the image is kept, the histogram of the cut off borders is
+ * subtracted which is faster than computing the crop's histogram.
+ * @param img the image this histogram was computed from
+ * @param rect the crop rectangle
+ * @return DkImageHistogram the histogram of img.copy(rect)
+ **/ 
+DkImageHistogram DkImageHistogram::cropped(const QImage& img, const QRect& rect) const {
+
+	QRect r = rect.intersected(img.rect());
+
+	if (isEmpty() || isApproximate() || (qint64)r.width() * r.height() * 2 < (qint64)img.width() * img.height())
+		return compute(img.copy(r));
+
+	QImage cImg = img;
+
+	if (!isSupported(cImg.format()))
+		cImg = cImg.convertToFormat(cImg.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+	DkImageHistogram hist = *this;
+	
+	// top, bottom, left & right borders
+	hist -= computeRect(cImg, QRect(0, 0, cImg.width(), r.top()), 1);
+	hist -= computeRect(cImg, QRect(0, r.bottom() + 1, cImg.width(), cImg.height() - r.bottom() - 1), 1);
+	hist -= computeRect(cImg, QRect(0, r.top(), r.left(), r.height()), 1);
+	hist -= computeRect(cImg, QRect(r.right() + 1, r.top(), cImg.width() - r.right() - 1, r.height()), 1);
+
+	return hist;
+}
+
+/**
+ * Updates the histogram after the image's values were mapped with lookup tables.
+ * @param lutR the red channel's lookup table (num_bins values)
+ * @param lutG the green channel's lookup table
+ * @param lutB the blue channel's lookup table
+ **/ 
+void DkImageHistogram::remap(const uchar* lutR, const uchar* lutG, const uchar* lutB) {
+
+	if (isEmpty())
+		return;
+
+	const uchar* luts[num_channels] = {lutR, lutG, lutB};
+	QVector<int> hist(num_channels * num_bins, 0);
+
+	for (int cIdx = 0; cIdx < num_channels; cIdx++) {
+		
+		const int* src = mHist.constData() + cIdx * num_bins;
+		int* dst = hist.data() + cIdx * num_bins;
+
+		for (int idx = 0; idx < num_bins; idx++)
+			dst[luts[cIdx][idx]] += src[idx];
+	}
+
+	mHist = hist;
+}
+
+DkImageHistogram& DkImageHistogram::operator+=(const DkImageHistogram& o) {
+
+	if (o.isEmpty())
+		return *this;
+
+	if (isEmpty()) {
+		*this = o;
+		return *this;
+	}
+
+	for (int idx = 0; idx < mHist.size(); idx++)
+		mHist[idx] += o.mHist[idx];
+
+	mNumPixels += o.mNumPixels;
+
+	return *this;
+}
+
+DkImageHistogram& DkImageHistogram::operator-=(const DkImageHistogram& o) {
+
+	if (o.isEmpty() || isEmpty())
+		return *this;
+
+	for (int idx = 0; idx < mHist.size(); idx++)
+		mHist[idx] -= o.mHist[idx];
+
+	mNumPixels -= o.mNumPixels;
+
+	return *this;
+}
+
 // DkImageStorage --------------------------------------------------------------------
 DkImageStorage::DkImageStorage(const QImage& img) {
 	mImg = img;
@@ -1205,6 +1803,7 @@ void DkImageStorage::computeImage() {
 	if (!mImgs.empty())
 		return;
 
+	DK_TRACE("pyramid", "computeImage");
 	DkTimer dt;
 	mBusy = true;
 	QImage resizedImg = mImg;
@@ -1229,10 +1828,9 @@ void DkImageStorage::computeImage() {
 			break;
 
 #ifdef WITH_OPENCV
-		cv::Mat rImgCv = DkImage::qImage2Mat(resizedImg);
 		cv::Mat tmp;
-		cv::resize(rImgCv, tmp, cv::Size(s.width(), s.height()), 0, 0, CV_INTER_AREA);
-		resizedImg = DkImage::mat2QImage(tmp);
+		cv::resize(DkMatView(resizedImg).mat(), tmp, cv::Size(s.width(), s.height()), 0, 0, CV_INTER_AREA);
+		resizedImg = DkMatView::toQImage(tmp);
 #else
 		resizedImg = resizedImg.scaled(s, Qt::KeepAspectRatio, Qt::SmoothTransformation);
 #endif
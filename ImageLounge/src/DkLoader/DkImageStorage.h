@@ -32,6 +32,7 @@
 #include <QMutex>
 #include <QVector>
 #include <QObject>
+#include <QAtomicInt>
 
 // opencv
 #ifdef WITH_OPENCV
@@ -67,6 +68,8 @@ class QColor;
 
 namespace nmc {
 
+class DkImageHistogram;
+
 /**
  * DkImage holds some basic image processing
  * methods that are generally needed.
@@ -111,18 +114,96 @@ public:
 	static void linearToGamma(QImage& img);
 	static void mapGammaTable(QImage& img, const QVector<uchar>& gammaTable);
 	static QImage normImage(const QImage& img);
-	static bool normImage(QImage& img);
+	static bool normImage(QImage& img, DkImageHistogram* hist = 0);
 	static QImage autoAdjustImage(const QImage& img);
-	static bool autoAdjustImage(QImage& img);
+	static bool autoAdjustImage(QImage& img, DkImageHistogram* hist = 0);
 	static bool unsharpMask(QImage& img, float sigma = 20.0f, float weight = 1.5f);
 	static bool alphaChannelUsed(const QImage& img);
 	static QPixmap colorizePixmap(const QPixmap& icon, const QColor& col, float opacity = 1.0f);
 	static QImage createThumb(const QImage& img);
 	static bool addToImage(QImage& img, unsigned char val = 1);
+	static bool crossFade(const QImage& from, const QImage& to, float alpha, QImage& dst);
 	static QColor getMeanColor(const QImage& img);
 	static uchar findHistPeak(const int* hist, float quantile = 0.005f);
 };
 
+#ifdef WITH_OPENCV
+/**
+ * Wraps the pixels of a QImage with a cv::Mat header (no copy).
+ * RGB32/ARGB32 (CV_8UC4), RGB888 (CV_8UC3) and grayscale images (CV_8UC1)
+ * are wrapped directly, all other formats are converted to ARGB32 once.
+ * The read only view keeps a shallow copy of the image, so the pixels
+ * stay valid as long as the view lives - don't write to its cv::Mat.
+ * The writable view (QImage*) writes directly to the image.
+ **/
+class DllLoaderExport DkMatView {
+
+public:
+	DkMatView(const QImage& img, bool keepGray = true);
+	DkMatView(QImage* img, bool keepGray = true);
+
+	cv::Mat& mat();
+	bool isConverted() const;
+
+	static QImage toQImage(cv::Mat img);
+	static int numConversions();
+
+protected:
+	int prepare(QImage& img, bool keepGray);
+	static bool isGrayRamp(const QImage& img);
+
+	QImage mImg;		// keeps the pixels of read only views alive
+	cv::Mat mMat;
+	bool mConverted = false;
+
+	static QAtomicInt sNumConversions;
+};
+#endif
+
+/**
+ * Histogram of an image's RGB channels.
+ * The histogram is computed in parallel. Large images can be
+ * sampled at a coarser level first (see level()) which
+ * gives a good approximation in a fraction of the time.
+ **/ 
+class DllLoaderExport DkImageHistogram {
+
+public:
+	enum {
+		num_bins = 256,
+		num_channels = 3,
+	};
+
+	DkImageHistogram();
+
+	static DkImageHistogram compute(const QImage& img, int level = 0);
+	static int level(const QSize& imgSize, int maxPixels);
+	static bool isSupported(QImage::Format format);
+
+	bool isEmpty() const;
+	bool isApproximate() const;
+	int getLevel() const;
+	qint64 numPixels() const;
+	const int* channel(int channel) const;
+	int maxCount() const;
+	uchar minBin(int channel) const;
+	uchar maxBin(int channel) const;
+
+	DkImageHistogram cropped(const QImage& img, const QRect& rect) const;
+	void remap(const uchar* lutR, const uchar* lutG, const uchar* lutB);
+
+	DkImageHistogram& operator+=(const DkImageHistogram& o);
+	DkImageHistogram& operator-=(const DkImageHistogram& o);
+
+protected:
+	static DkImageHistogram computeRect(const QImage& img, const QRect& rect, int step);
+	static DkImageHistogram computeBlock(const QImage& img, const QRect& rect, int step);
+
+	QVector<int> mHist;
+	int mLevel = 0;
+	qint64 mNumPixels = 0;
+};
+
 class DllLoaderExport DkImageStorage : public QObject {
 	Q_OBJECT
 
@@ -39,10 +39,283 @@
 #include <QBuffer>
 #include <QVector2D>
 #include <QApplication>
+#include <QtEndian>
 #pragma warning(pop)		// no warnings from includes - end
 
 namespace nmc {
 
+// DkMetaDataProbe --------------------------------------------------------------------
+DkMetaDataProbe::DkMetaDataProbe() {
+}
+
+void DkMetaDataProbe::clear() {
+
+	mValid = false;
+	mBigEndian = false;
+	mOrientation = 0;
+	mRating = -1;
+	mSize = QSize();
+	mThumbData.clear();
+}
+
+/**
+ * Reads orientation, rating, size and the embedded thumbnail.
+ * In contrast to Exiv2's readMetadata(), XMP packets and MakerNotes are never touched.
+ * @param filePath the image file
+ * @param ba the file buffer (the file is read if it is empty)
+ * @return bool true if the file could be parsed - it does not need to have an exif block.
+ **/ 
+bool DkMetaDataProbe::probe(const QString& filePath, QSharedPointer<QByteArray> ba) {
+
+	clear();
+
+	QFile file;
+	QBuffer buffer;
+	QIODevice* io = 0;
+
+	if (!ba || ba->isEmpty()) {
+		QFileInfo fileInfo(filePath);
+		file.setFileName(fileInfo.isSymLink() ? fileInfo.symLinkTarget() : filePath);
+		io = &file;
+	}
+	else {
+		buffer.setData(*ba);	// implicitly shared - no deep copy
+		io = &buffer;
+	}
+
+	if (!io->open(QIODevice::ReadOnly))
+		return false;
+
+	QByteArray header = io->read(4);
+
+	if (header.size() < 4)
+		return false;
+
+	if ((uchar)header[0] == 0xff && (uchar)header[1] == 0xd8)
+		mValid = probeJpg(*io);
+	else if (header == QByteArray("II*\0", 4) || header == QByteArray("MM\0*", 4))	// TIFF, CR2, NEF, DNG, ARW...
+		mValid = probeTiff(*io);
+
+	return mValid;
+}
+
+bool DkMetaDataProbe::probeJpg(QIODevice& io) {
+
+	qint64 pos = 2;
+	bool exifFound = false;
+
+	// walk through the header segments until we hit the first scan
+	while (io.seek(pos)) {
+
+		QByteArray marker = io.read(4);
+
+		if (marker.size() < 4)
+			break;
+
+		if ((uchar)marker[0] != 0xff)
+			return false;	// corrupted segment
+
+		uchar mId = (uchar)marker[1];
+
+		if (mId == 0xff) {	// fill byte
+			pos++;
+			continue;
+		}
+		if (mId == 0xda || mId == 0xd9)	// SOS or EOI
+			break;
+
+		int segLength = ((uchar)marker[2] << 8) | (uchar)marker[3];
+
+		if (segLength < 2)
+			return false;
+
+		// APP1 - there might be XMP packets in APP1 too
+		if (mId == 0xe1 && !exifFound) {
+
+			QByteArray segment = io.read(segLength - 2);
+
+			if (segment.startsWith(QByteArray("Exif\0\0", 6))) {
+				QBuffer tiff;
+				tiff.setData(segment.mid(6));
+				tiff.open(QIODevice::ReadOnly);
+				exifFound = probeTiff(tiff);
+			}
+		}
+		// start of frame - it knows the true image size
+		else if (mId >= 0xc0 && mId <= 0xcf && mId != 0xc4 && mId != 0xc8 && mId != 0xcc) {
+
+			QByteArray sof = io.read(5);
+
+			if (sof.size() == 5) {
+				mBigEndian = true;	// jpg markers are always big endian
+				mSize = QSize(toUShort(sof, 3), toUShort(sof, 1));
+			}
+			break;
+		}
+
+		pos += 2 + segLength;
+	}
+
+	return true;
+}
+
+bool DkMetaDataProbe::probeTiff(QIODevice& io) {
+
+	if (!io.seek(0))
+		return false;
+
+	QByteArray header = io.read(8);
+
+	if (header.size() < 8)
+		return false;
+
+	if (header.startsWith("II"))
+		mBigEndian = false;
+	else if (header.startsWith("MM"))
+		mBigEndian = true;
+	else
+		return false;
+
+	if (toUShort(header, 2) != 42)
+		return false;
+
+	quint32 ifd1 = 0;
+	QMap<quint16, quint32> ifd0 = readIfd(io, toULong(header, 4), ifd1);
+
+	if (ifd0.isEmpty())
+		return false;
+
+	mOrientation = ifd0.value(0x0112, 0);	// Exif.Image.Orientation
+	mRating = ifd0.contains(0x4746) ? (int)ifd0.value(0x4746) : -1;	// Exif.Image.Rating
+	mSize = QSize(ifd0.value(0x0100, 0), ifd0.value(0x0101, 0));	// Exif.Image.ImageWidth & ImageLength
+
+	// the Exif sub IFD stores the image size for jpgs
+	if (mSize.isEmpty() && ifd0.contains(0x8769)) {
+		quint32 dummy = 0;
+		QMap<quint16, quint32> exifIfd = readIfd(io, ifd0.value(0x8769), dummy);
+		mSize = QSize(exifIfd.value(0xa002, 0), exifIfd.value(0xa003, 0));	// Exif.Photo.PixelXDimension & PixelYDimension
+	}
+
+	// IFD1 holds the thumbnail
+	if (ifd1) {
+		quint32 dummy = 0;
+		QMap<quint16, quint32> thumbIfd = readIfd(io, ifd1, dummy);
+		quint32 thumbOffset = thumbIfd.value(0x0201, 0);	// Exif.Thumbnail.JPEGInterchangeFormat
+		quint32 thumbLength = thumbIfd.value(0x0202, 0);	// Exif.Thumbnail.JPEGInterchangeFormatLength
+
+		if (thumbOffset && thumbLength && thumbLength < 1024*1024 && io.seek(thumbOffset)) {
+			mThumbData = io.read(thumbLength);
+
+			if (mThumbData.size() != (int)thumbLength || !mThumbData.startsWith("\xff\xd8"))
+				mThumbData.clear();
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Reads all SHORT and LONG values of an IFD.
+ * @param io the device positioned relative to the TIFF header
+ * @param offset the IFD offset
+ * @param nextIfd the offset of the next IFD (0 if there is none)
+ * @return QMap<quint16, quint32> tag -> value
+ **/ 
+QMap<quint16, quint32> DkMetaDataProbe::readIfd(QIODevice& io, quint32 offset, quint32& nextIfd) const {
+
+	QMap<quint16, quint32> tags;
+	nextIfd = 0;
+
+	if (!offset || !io.seek(offset))
+		return tags;
+
+	QByteArray cnt = io.read(2);
+	if (cnt.size() < 2)
+		return tags;
+
+	int numEntries = toUShort(cnt, 0);
+
+	if (numEntries > 1000)	// must be garbage
+		return tags;
+
+	QByteArray entries = io.read(numEntries*12 + 4);
+
+	if (entries.size() < numEntries*12)
+		return tags;
+
+	for (int idx = 0; idx < numEntries; idx++) {
+
+		int ePos = idx*12;
+		quint16 tag = toUShort(entries, ePos);
+		quint16 type = toUShort(entries, ePos+2);
+		quint32 count = toULong(entries, ePos+4);
+
+		if (count != 1)
+			continue;
+
+		if (type == 3)		// SHORT
+			tags.insert(tag, toUShort(entries, ePos+8));
+		else if (type == 4)	// LONG
+			tags.insert(tag, toULong(entries, ePos+8));
+	}
+
+	if (entries.size() == numEntries*12 + 4)
+		nextIfd = toULong(entries, numEntries*12);
+
+	return tags;
+}
+
+quint16 DkMetaDataProbe::toUShort(const QByteArray& ba, int pos) const {
+
+	const uchar* ptr = (const uchar*)ba.constData() + pos;
+	return mBigEndian ? qFromBigEndian<quint16>(ptr) : qFromLittleEndian<quint16>(ptr);
+}
+
+quint32 DkMetaDataProbe::toULong(const QByteArray& ba, int pos) const {
+
+	const uchar* ptr = (const uchar*)ba.constData() + pos;
+	return mBigEndian ? qFromBigEndian<quint32>(ptr) : qFromLittleEndian<quint32>(ptr);
+}
+
+bool DkMetaDataProbe::isValid() const {
+	return mValid;
+}
+
+/**
+ * Returns the EXIF orientation (1-8).
+ * @return int the orientation or 0 if no orientation was found
+ **/ 
+int DkMetaDataProbe::getOrientation() const {
+	return mOrientation;
+}
+
+/**
+ * Returns the EXIF rating.
+ * Note: XMP ratings are not probed.
+ * @return int the rating or -1 if there is no EXIF rating
+ **/ 
+int DkMetaDataProbe::getRating() const {
+	return mRating;
+}
+
+QSize DkMetaDataProbe::getImageSize() const {
+	return mSize;
+}
+
+bool DkMetaDataProbe::hasThumbnail() const {
+	return !mThumbData.isEmpty();
+}
+
+QImage DkMetaDataProbe::getThumbnail() const {
+
+	QImage thumb;
+
+	if (!mThumbData.isEmpty())
+		thumb.loadFromData(mThumbData);
+
+	return thumb;
+}
+
 // DkMetaDataT --------------------------------------------------------------------
 DkMetaDataT::DkMetaDataT() {
 
@@ -106,11 +379,36 @@ void DkMetaDataT::readMetaData(const QString& filePath, QSharedPointer<QByteArra
 	
 	//qDebug() << "[Exiv2] metadata loaded";
 	mExifState = loaded;
+	mRevision++;
 
 	//printMetaData();
 
 }
 
+/**
+ * Reads the frequently used fields (orientation, rating, size, thumbnail) only.
+ * Use this if you don't need the full metadata since it does not parse XMP or MakerNotes.
+ * Call readMetaData() later on if you need more.
+ * @param filePath the image file
+ * @param ba the file buffer (may be empty)
+ * @return bool true if the file could be probed - false if the caller should fall back to readMetaData()
+ **/ 
+bool DkMetaDataT::probeMetaData(const QString& filePath, QSharedPointer<QByteArray> ba) {
+
+	// we already have everything
+	if ((mExifState == loaded || mExifState == dirty) && mFilePath == filePath)
+		return true;
+
+	mFilePath = filePath;
+
+	if (!mProbe.probe(filePath, ba))
+		return false;
+
+	mExifState = probed;
+	mRevision++;
+	return true;
+}
+
 bool DkMetaDataT::saveMetaData(const QString& filePath, bool force) {
 
 	if (mExifState != loaded && mExifState != dirty)
@@ -147,7 +445,7 @@ bool DkMetaDataT::saveMetaData(QSharedPointer<QByteArray>& ba, bool force) {
 
 	if (!force && mExifState != dirty)
 		return false;
-	else if (mExifState == not_loaded || mExifState == no_data)
+	else if (mExifState != loaded && mExifState != dirty)
 		return false;
 
 	Exiv2::ExifData &exifData = mExifImg->exifData();
@@ -195,6 +493,7 @@ bool DkMetaDataT::saveMetaData(QSharedPointer<QByteArray>& ba, bool force) {
 
 	mExifImg = exifImgN;
 	mExifState = loaded;
+	mRevision++;
 
 	return true;
 }
@@ -231,6 +530,9 @@ QString DkMetaDataT::getDescription() const {
 
 int DkMetaDataT::getOrientation() const {
 
+	if (mExifState == probed)
+		return mProbe.getOrientation() ? orientationToDegree(mProbe.getOrientation()) : 0;
+
 	if (mExifState != loaded && mExifState != dirty)
 		return 0;
 
@@ -248,24 +550,7 @@ int DkMetaDataT::getOrientation() const {
 			
 				Exiv2::Value::AutoPtr v = pos->getValue();
 
-				orientation = (int)pos->toFloat();
-
-				switch (orientation) {
-				case 6: orientation = 90;
-					break;
-				case 7: orientation = 90;
-					break;
-				case 3: orientation = 180;
-					break;
-				case 4: orientation = 180;
-					break;
-				case 8: orientation = -90;
-					break;
-				case 5: orientation = -90;
-					break;
-				default: orientation = -1;
-					break;
-				}	
+				orientation = orientationToDegree((int)pos->toFloat());
 			}
 		}
 	}
@@ -276,8 +561,49 @@ int DkMetaDataT::getOrientation() const {
 	return orientation;
 }
 
+/**
+ * Converts the EXIF orientation flag to degrees.
+ * @param exifOrientation the EXIF orientation (1-8)
+ * @return int the rotation in degrees, -1 if no rotation is needed (or the flag is illegal)
+ **/ 
+int DkMetaDataT::orientationToDegree(int exifOrientation) {
+
+	switch (exifOrientation) {
+	case 6: return 90;
+	case 7: return 90;
+	case 3: return 180;
+	case 4: return 180;
+	case 8: return -90;
+	case 5: return -90;
+	default: return -1;
+	}
+}
+
+/**
+ * Returns the image size stored in the metadata.
+ * @return QSize the image size or an empty size if the metadata does not know it
+ **/ 
+QSize DkMetaDataT::getImageSize() const {
+
+	if (mExifState == probed)
+		return mProbe.getImageSize();
+
+	if (mExifState != loaded && mExifState != dirty)
+		return QSize();
+
+	QSize size(getExifValue("PixelXDimension").toInt(), getExifValue("PixelYDimension").toInt());
+
+	if (size.isEmpty())
+		size = QSize(getExifValue("ImageWidth").toInt(), getExifValue("ImageLength").toInt());
+
+	return size;
+}
+
 int DkMetaDataT::getRating() const {
 	
+	if (mExifState == probed)
+		return mProbe.getRating();
+
 	if (mExifState != loaded && mExifState != dirty)
 		return -1;
 
@@ -600,6 +926,9 @@ QImage DkMetaDataT::getThumbnail() const {
 
 	QImage qThumb;
 
+	if (mExifState == probed)
+		return mProbe.getThumbnail();
+
 	if (mExifState != loaded && mExifState != dirty)
 		return qThumb;
 
@@ -676,7 +1005,7 @@ QImage DkMetaDataT::getPreviewImage(int minPreviewWidth) const {
 
 bool DkMetaDataT::hasMetaData() const {
 
-	return !(mExifState == no_data || mExifState == not_loaded);
+	return mExifState == loaded || mExifState == dirty;
 }
 
 bool DkMetaDataT::isLoaded() const {
@@ -684,6 +1013,11 @@ bool DkMetaDataT::isLoaded() const {
 	return mExifState == loaded || mExifState == dirty || mExifState == no_data;
 }
 
+bool DkMetaDataT::isProbed() const {
+
+	return mExifState == probed;
+}
+
 bool DkMetaDataT::isTiff() const {
 
 	QString newSuffix = QFileInfo(mFilePath).suffix();
@@ -707,6 +1041,16 @@ bool DkMetaDataT::isDirty() const {
 	return mExifState == dirty;
 }
 
+/**
+ * Returns the number of changes since the metadata was created.
+ * Resolved entries (see DkMetaDataHelper::resolveEntries()) are outdated if the revision changed.
+ * @return int the revision
+ **/ 
+int DkMetaDataT::revision() const {
+
+	return mRevision;
+}
+
 QStringList DkMetaDataT::getExifKeys() const {
 
 	QStringList exifKeys;
@@ -841,6 +1185,8 @@ void DkMetaDataT::setQtValues(const QImage& cImg) {
 			}
 		}
 	}
+
+	mRevision++;
 }
 
 QString DkMetaDataT::getQtValue(const QString& key) const {
@@ -867,7 +1213,7 @@ QStringList DkMetaDataT::getQtValues() const {
 
 void DkMetaDataT::setThumbnail(QImage thumb) {
 
-	if (mExifState == not_loaded || mExifState == no_data) 
+	if (mExifState != loaded && mExifState != dirty)
 		return;
 
 	try {
@@ -901,6 +1247,7 @@ void DkMetaDataT::setThumbnail(QImage thumb) {
 
 		mExifImg->setExifData(exifData);
 		mExifState = dirty;
+		mRevision++;
 
 	} catch (...) {
 		qDebug() << "I could not save the thumbnail...";
@@ -960,7 +1307,7 @@ void DkMetaDataT::setResolution(const QVector2D& res) {
 
 void DkMetaDataT::clearOrientation() {
 
-	if (mExifState == not_loaded || mExifState == no_data)
+	if (mExifState != loaded && mExifState != dirty)
 		return;
 
 	setExifValue("Exif.Image.Orientation", "1");	// we wrote "0" here - that was against the standard!
@@ -968,7 +1315,7 @@ void DkMetaDataT::clearOrientation() {
 
 void DkMetaDataT::setOrientation(int o) {
 
-	if (mExifState == not_loaded || mExifState == no_data)
+	if (mExifState != loaded && mExifState != dirty)
 		return;
 
 	if (o!=90 && o!=-90 && o!=180 && o!=0 && o!=270)
@@ -1028,11 +1375,12 @@ void DkMetaDataT::setOrientation(int o) {
 	mExifImg->setExifData(exifData);
 
 	mExifState = dirty;
+	mRevision++;
 }
 
 bool DkMetaDataT::setDescription(const QString& description) {
 
-	if (mExifState == not_loaded || mExifState == no_data)
+	if (mExifState != loaded && mExifState != dirty)
 		return false;
 
 	return setExifValue("Exif.Image.ImageDescription", description.toUtf8());
@@ -1040,7 +1388,7 @@ bool DkMetaDataT::setDescription(const QString& description) {
 
 void DkMetaDataT::setRating(int r) {
 
-	if (mExifState == not_loaded || mExifState == no_data || getRating() == r)
+	if ((mExifState != loaded && mExifState != dirty) || getRating() == r)
 		return;
 
 	unsigned short percentRating = 0;
@@ -1090,6 +1438,7 @@ void DkMetaDataT::setRating(int r) {
 		mExifImg->setXmpData(xmpData);
 
 		mExifState = dirty;
+		mRevision++;
 	}
 	catch (...) {
 		qDebug() << "[WARNING] I could not set the exif data for this image format...";
@@ -1114,7 +1463,7 @@ bool DkMetaDataT::updateImageMetaData(const QImage& img) {
 
 bool DkMetaDataT::setExifValue(QString key, QString taginfo) {
 
-	if (mExifState == not_loaded || mExifState == no_data)
+	if (mExifState != loaded && mExifState != dirty)
 		return false;
 
 	if (mExifImg->checkMode(Exiv2::mdExif) != Exiv2::amReadWrite &&
@@ -1136,6 +1485,7 @@ bool DkMetaDataT::setExifValue(QString key, QString taginfo) {
 		//tag.setValue(&val);
 		if (!tag.setValue(taginfo.toStdString())) {
 			mExifState = dirty;
+			mRevision++;
 			setExifSuccessfull = true;
 		}
 	}
@@ -1145,6 +1495,7 @@ bool DkMetaDataT::setExifValue(QString key, QString taginfo) {
 		Exiv2::Exifdatum tag(exivKey);
 		if (!tag.setValue(taginfo.toStdString())) {
 			mExifState = dirty;
+			mRevision++;
 			setExifSuccessfull = true;
 		}
 
@@ -1740,6 +2091,70 @@ bool DkMetaDataHelper::hasGPS(QSharedPointer<DkMetaDataT> metaData) const {
 	return !getGpsCoordinates(metaData).isEmpty();
 }
 
+/**
+ * Resolves all metadata entries.
+ * Keys are translated and special values (e.g. aperture, flash) are resolved.
+ * This is slow for RAW files with large MakerNotes, so call it from the loading threads.
+ * @param metaData the metadata
+ * @return QVector<DkMetaDataEntry> the entries in the order: file, exif, iptc, xmp, qt
+ **/ 
+QVector<DkMetaDataEntry> DkMetaDataHelper::resolveEntries(QSharedPointer<DkMetaDataT> metaData) const {
+
+	QVector<DkMetaDataEntry> entries;
+
+	if (!metaData)
+		return entries;
+
+	QStringList fileKeys, fileValues;
+	metaData->getFileMetaData(fileKeys, fileValues);
+
+	QStringList keys[DkMetaDataEntry::entry_end];
+	keys[DkMetaDataEntry::entry_file] = fileKeys;
+	keys[DkMetaDataEntry::entry_exif] = metaData->getExifKeys();
+	keys[DkMetaDataEntry::entry_iptc] = metaData->getIptcKeys();
+	keys[DkMetaDataEntry::entry_xmp] = metaData->getXmpKeys();
+	keys[DkMetaDataEntry::entry_qt] = metaData->getQtKeys();
+
+	for (int type = 0; type < DkMetaDataEntry::entry_end; type++) {
+
+		for (int idx = 0; idx < keys[type].size(); idx++) {
+
+			DkMetaDataEntry e;
+			e.type = type;
+			e.key = keys[type].at(idx);
+
+			QString lastKey = e.key.split(".").last();
+
+			switch (type) {
+			case DkMetaDataEntry::entry_file:	e.value = fileValues.value(idx);					break;
+			case DkMetaDataEntry::entry_exif:	e.value = metaData->getNativeExifValue(e.key);	break;
+			case DkMetaDataEntry::entry_iptc:	e.value = metaData->getIptcValue(e.key);			break;
+			case DkMetaDataEntry::entry_xmp:	e.value = metaData->getXmpValue(e.key);			break;
+			case DkMetaDataEntry::entry_qt:		e.value = metaData->getQtValue(e.key);				break;
+			}
+
+			if (type == DkMetaDataEntry::entry_file)
+				e.name = lastKey;
+			else {
+				e.name = translateKey(lastKey);
+				e.value = resolveSpecialValue(metaData, lastKey, e.value);
+			}
+
+			QString cleanValue = DkUtils::cleanFraction(e.value);
+			QDateTime pd = DkUtils::getConvertableDate(cleanValue);
+
+			if (!pd.isNull())
+				e.displayValue = pd;
+			else
+				e.displayValue = cleanValue;
+
+			entries.append(e);
+		}
+	}
+
+	return entries;
+}
+
 QStringList DkMetaDataHelper::getCamSearchTags() const {
 
 	return mCamSearchTags;
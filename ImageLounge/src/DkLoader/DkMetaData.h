@@ -31,6 +31,9 @@
 #include <QSharedPointer>
 #include <QStringList>
 #include <QMap>
+#include <QSize>
+#include <QVector>
+#include <QVariant>
 
 //code for metadata crop:
 #include "DkMath.h"
@@ -65,15 +68,53 @@ typedef unsigned char byte;
 // Qt defines
 class QVector2D;
 class QImage;
+class QIODevice;
 
 namespace nmc {
 
+/**
+ * Lightweight EXIF reader.
+ * It parses only the Exif APP1 segment (JPG) or IFD0/IFD1 (TIFF and TIFF based RAW files)
+ * and reads the fields we frequently need (orientation, rating, size, thumbnail).
+ * Use DkMetaDataT::readMetaData() if you need anything else.
+ **/
+class DllLoaderExport DkMetaDataProbe {
+
+public:
+	DkMetaDataProbe();
+
+	bool probe(const QString& filePath, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
+	void clear();
+
+	bool isValid() const;
+	int getOrientation() const;
+	int getRating() const;
+	QSize getImageSize() const;
+	bool hasThumbnail() const;
+	QImage getThumbnail() const;
+
+protected:
+	bool probeJpg(QIODevice& io);
+	bool probeTiff(QIODevice& io);
+	QMap<quint16, quint32> readIfd(QIODevice& io, quint32 offset, quint32& nextIfd) const;
+	quint16 toUShort(const QByteArray& ba, int pos) const;
+	quint32 toULong(const QByteArray& ba, int pos) const;
+
+	bool mValid = false;
+	bool mBigEndian = false;
+	int mOrientation = 0;
+	int mRating = -1;
+	QSize mSize;
+	QByteArray mThumbData;
+};
+
 class DllLoaderExport DkMetaDataT {
 
 public:
 	DkMetaDataT();
 
 	void readMetaData(const QString& filePath, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
+	bool probeMetaData(const QString& filePath, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
 	bool saveMetaData(const QString& filePath, bool force = false);
 	bool saveMetaData(QSharedPointer<QByteArray>& ba, bool force = false);
 
@@ -81,6 +122,7 @@ public:
 	int getRating() const;
 	QString getDescription() const;
 	QVector2D getResolution() const;
+	QSize getImageSize() const;
 	QString getNativeExifValue(const QString& key) const;
 	QString getXmpValue(const QString& key) const;
 	QString getExifValue(const QString& key) const;
@@ -107,13 +149,16 @@ public:
 	void setThumbnail(QImage thumb);
 	void setQtValues(const QImage& cImg);
 	static QString exiv2ToQString(std::string exifString);
+	static int orientationToDegree(int exifOrientation);
 
 	bool hasMetaData() const;
 	bool isLoaded() const;
+	bool isProbed() const;
 	bool isTiff() const;
 	bool isJpg() const;
 	bool isRaw() const;
 	bool isDirty() const;
+	int revision() const;
 	void printMetaData() const; //only for debug
 
 	//code for metadata crop:
@@ -130,14 +175,42 @@ protected:
 		no_data,
 		loaded,
 		dirty,
+		probed,
 	};
 
 	Exiv2::Image::AutoPtr mExifImg;
+	DkMetaDataProbe mProbe;
 	QString mFilePath;
 	QStringList mQtKeys;
 	QStringList mQtValues;
 
 	int mExifState = not_loaded;
+	int mRevision = 0;	// counts changes (see DkMetaDataEntry)
+};
+
+/**
+ * A resolved metadata entry (translated key and readable value).
+ * The entries are resolved by the loading threads (see DkMetaDataHelper::resolveEntries())
+ * so that the metadata dock and HUD do not need to query Exiv2.
+ **/ 
+class DllLoaderExport DkMetaDataEntry {
+
+public:
+	enum {
+		entry_file,
+		entry_exif,
+		entry_iptc,
+		entry_xmp,
+		entry_qt,
+
+		entry_end
+	};
+
+	int type = entry_file;
+	QString key;			// e.g. Exif.Image.Make
+	QString name;			// the (translated) key name
+	QString value;			// the resolved value
+	QVariant displayValue;	// the cleaned value or a QDateTime
 };
 
 class DllLoaderExport DkMetaDataHelper {
@@ -163,6 +236,7 @@ public:
 	bool hasGPS(QSharedPointer<DkMetaDataT> metaData) const;
 	QString translateKey(const QString& key) const;
 	QString resolveSpecialValue(QSharedPointer<DkMetaDataT> metaData, const QString& key, const QString& value) const;
+	QVector<DkMetaDataEntry> resolveEntries(QSharedPointer<DkMetaDataT> metaData) const;
 
 	QStringList getCamSearchTags() const;
 	QStringList getDescSearchTags() const;
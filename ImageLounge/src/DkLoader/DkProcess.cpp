@@ -29,8 +29,10 @@
 #include "DkUtils.h"
 #include "DkImageContainer.h"
 #include "DkImageStorage.h"
+#include "DkMetaData.h"
 #include "DkPluginManager.h"
 #include "DkSettings.h"
+#include "DkTimer.h"
 
 #pragma warning(push, 0)	// no warnings from includes - begin
 #include <QFuture>
@@ -40,6 +42,11 @@
 #include <QUuid>
 #pragma warning(pop)		// no warnings from includes - end
 
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/fs.h>	// FICLONE
+#endif
+
 namespace nmc {
 
 // DkAbstractBatch --------------------------------------------------------------------
@@ -183,11 +190,12 @@ QString DkBatchTransform::name() const {
 	return QObject::tr("[Transform Batch]");
 }
 
-void DkBatchTransform::setProperties(int angle, bool horizontalFlip /* = false */, bool verticalFlip /* = false */) {
+void DkBatchTransform::setProperties(int angle, bool horizontalFlip /* = false */, bool verticalFlip /* = false */, bool exifOnly /* = false */) {
 	
 	mAngle = angle;
 	mHorizontalFlip = horizontalFlip;
 	mVerticalFlip = verticalFlip;
+	mExifOnly = exifOnly;
 }
 
 bool DkBatchTransform::isActive() const {
@@ -195,6 +203,51 @@ bool DkBatchTransform::isActive() const {
 	return mHorizontalFlip || mVerticalFlip || mAngle != 0;
 }
 
+/**
+ * Returns true if the transform can be expressed by the EXIF orientation.
+ * @return bool true if the image is rotated but not flipped
+ **/ 
+bool DkBatchTransform::isRotationOnly() const {
+
+	return !mHorizontalFlip && !mVerticalFlip;
+}
+
+/**
+ * By default, the pixels are transformed. Only if the user explicitly chose
+ * to, rotations are written to the EXIF orientation (viewers that ignore it show the old orientation).
+ * Flips need the pixels since we do not display mirrored EXIF orientations.
+ * @return bool true if the image needs to be decoded
+ **/ 
+bool DkBatchTransform::needsPixels() const {
+
+	return !mExifOnly || 
+		!isRotationOnly() || 
+		Settings::param().metaData().ignoreExifOrientation;
+}
+
+/**
+ * Rotates JPGs by changing their EXIF orientation (if the user opted in).
+ * The compressed data is not touched - so no quality is lost. The embedded
+ * thumbnail is stored in the same orientation as the image, hence it stays valid.
+ * @param metaData the image's metadata
+ * @param logStrings log strings
+ * @return bool false if the image needs to be decoded (e.g. it is no JPG)
+ **/ 
+bool DkBatchTransform::computeMetaData(QSharedPointer<DkMetaDataT> metaData, QStringList& logStrings) const {
+
+	if (needsPixels() || !metaData || !metaData->isJpg())
+		return false;
+
+	metaData->setOrientation(mAngle);
+
+	if (!metaData->isDirty())
+		return false;
+
+	logStrings.append(QObject::tr("%1 EXIF orientation rotated by %2%3 (lossless).").arg(name()).arg(mAngle).arg(QChar(0x00B0)));
+
+	return true;
+}
+
 bool DkBatchTransform::compute(QImage& img, QStringList& logStrings) const {
 
 	if (!isActive()) {
@@ -358,6 +411,8 @@ bool DkBatchProcess::wasProcessed() const {
 
 bool DkBatchProcess::compute() {
 
+	DK_TRACE("batch", "compute");
+
 	mIsProcessed = true;
 
 	QFileInfo fInfoIn(mFilePathIn);
@@ -382,25 +437,85 @@ bool DkBatchProcess::compute() {
 	}
 	
 	// do the work
-	if (mProcessFunctions.empty() && mFilePathIn == mFilePathOut && fInfoIn.suffix() == fInfoOut.suffix()) {	// rename?
-		if (!renameFile())
-			mFailure++;
-		return mFailure == 0;
-	}
-	else if (mProcessFunctions.empty() && fInfoIn.suffix() == fInfoOut.suffix()) {	// copy?
+	mPath = classify();
+
+	switch (mPath) {
+	case path_move:
+		if (renameFile())
+			break;
+		// e.g. the target is on another device
+		mPath = path_copy;
+		// fall through
+	case path_copy:
 		if (!copyFile())
 			mFailure++;
 		else
 			deleteOriginalFile();
-
-		return mFailure == 0;
+		break;
+	case path_metadata:
+		if (copyWithMetaData()) {
+			deleteOriginalFile();
+			break;
+		}
+		// e.g. the format does not support it
+		mPath = path_decode;
+		// fall through
+	default:
+		process();
+		break;
 	}
 
-	process();
+	qDebug() << "[Batch]" << fInfoIn.fileName() << "->" << pathName(mPath);
 
 	return mFailure == 0;
 }
 
+/**
+ * Returns how the file will be processed.
+ * Only jobs that change the format or the pixels need to decode the image.
+ * @return int the processing path (path_move, path_copy, path_metadata or path_decode)
+ **/ 
+int DkBatchProcess::classify() const {
+
+	// .JPG -> .jpg does not change the format
+	if (QFileInfo(mFilePathIn).suffix().toLower() != QFileInfo(mFilePathOut).suffix().toLower())
+		return path_decode;
+
+	bool active = false;
+
+	for (QSharedPointer<DkAbstractBatch> batch : mProcessFunctions) {
+
+		if (!batch || !batch->isActive())
+			continue;
+
+		if (batch->needsPixels())
+			return path_decode;
+
+		active = true;
+	}
+
+	if (active)
+		return path_metadata;
+
+	return mDeleteOriginal ? path_move : path_copy;
+}
+
+int DkBatchProcess::path() const {
+	return mPath;
+}
+
+QString DkBatchProcess::pathName(int path) {
+
+	switch (path) {
+	case path_move:		return QObject::tr("moved");
+	case path_clone:	return QObject::tr("cloned");
+	case path_copy:		return QObject::tr("copied");
+	case path_metadata:	return QObject::tr("metadata only");
+	case path_decode:	return QObject::tr("decoded");
+	default:			return QObject::tr("not processed");
+	}
+}
+
 QStringList DkBatchProcess::getLog() const {
 
 	return mLogStrings;
@@ -412,6 +527,8 @@ bool DkBatchProcess::process() {
 
 	QSharedPointer<DkImageContainer> imgC(new DkImageContainer(mFilePathIn));
 
+	DK_TRACE("batch", "process");
+
 	if (!imgC->loadImage() || imgC->image().isNull()) {
 		mLogStrings.append(QObject::tr("Error while loading..."));
 		mFailure++;
@@ -425,6 +542,8 @@ bool DkBatchProcess::process() {
 			continue;
 		}
 
+		DK_TRACE("batch", "stage");
+
 		if (!batch->compute(imgC, mLogStrings)) {
 			mLogStrings.append(QObject::tr("%1 failed").arg(batch->name()));
 			mFailure++;
@@ -437,7 +556,13 @@ bool DkBatchProcess::process() {
 		return false;
 	}
 
-	if (imgC->saveImage(mFilePathOut, mCompression)) {
+	bool saved = false;
+	{
+		DK_TRACE("batch", "save");
+		saved = imgC->saveImage(mFilePathOut, mCompression);
+	}
+
+	if (saved) {
 		mLogStrings.append(QObject::tr("%1 saved...").arg(mFilePathOut));
 	}
 	else {
@@ -453,10 +578,79 @@ bool DkBatchProcess::process() {
 	return true;
 }
 
+/**
+ * Copies the file and rewrites its metadata.
+ * All process functions are applied to the metadata only. The
+ * compressed image data is copied as is, so the image is not decoded.
+ * @return bool false if a function cannot be applied to the metadata (the file is not written then)
+ **/ 
+bool DkBatchProcess::copyWithMetaData() {
+
+	QFile file(mFilePathIn);
+
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QSharedPointer<QByteArray> ba(new QByteArray(file.readAll()));
+	file.close();
+
+	QStringList logStrings;
+
+	try {
+		QSharedPointer<DkMetaDataT> metaData(new DkMetaDataT());
+		metaData->readMetaData(mFilePathIn, ba);
+
+		for (QSharedPointer<DkAbstractBatch> batch : mProcessFunctions) {
+
+			if (batch && batch->isActive() && !batch->computeMetaData(metaData, logStrings))
+				return false;
+		}
+
+		if (!metaData->saveMetaData(ba))
+			return false;
+	}
+	catch (...) {
+		return false;
+	}
+
+	mLogStrings.append(QObject::tr("processing %1").arg(mFilePathIn));
+	mLogStrings << logStrings;
+
+	// report we could not back-up & break here
+	if (!prepareDeleteExisting()) {
+		mFailure++;
+		return true;
+	}
+
+	QFile outFile(mFilePathOut);
+	bool saved = outFile.open(QIODevice::WriteOnly) && outFile.write(*ba) == ba->size();
+	outFile.close();
+
+	if (saved) {
+		mLogStrings.append(QObject::tr("%1 saved (metadata only)...").arg(mFilePathOut));
+	}
+	else {
+		mLogStrings.append(QObject::tr("Could not save: %1").arg(mFilePathOut));
+		mLogStrings.append(outFile.errorString());
+		outFile.remove();	// restores the back-up (if any)
+		mFailure++;
+	}
+
+	if (!deleteOrRestoreExisting())
+		mFailure++;
+
+	return true;
+}
+
+/**
+ * Moves the file.
+ * Nothing is logged if the file cannot be moved since we fall back to copying it.
+ * @return bool true if the file was moved
+ **/ 
 bool DkBatchProcess::renameFile() {
 
 	if (QFileInfo(mFilePathOut).exists()) {
-		mLogStrings.append(QObject::tr("Error: could not rename file, the target file exists already."));
+		qDebug() << "[Batch] cannot rename" << mFilePathIn << "the target file exists already";
 		return false;
 	}
 
@@ -464,8 +658,7 @@ bool DkBatchProcess::renameFile() {
 
 	// Note: if two images are renamed at the same time to the same name, one image is lost -> see Qt comment Race Condition
 	if (!file.rename(mFilePathOut)) {
-		mLogStrings.append(QObject::tr("Error: could not rename file"));
-		mLogStrings.append(file.errorString());
+		qDebug() << "[Batch] cannot rename" << mFilePathIn << file.errorString();
 		return false;
 	}
 	else
@@ -483,6 +676,13 @@ bool DkBatchProcess::copyFile() {
 			return false;	// early break
 	}
 
+	// copy-on-write if the file system supports it
+	if (!QFileInfo(mFilePathOut).exists() && cloneFile(mFilePathIn, mFilePathOut)) {
+		mPath = path_clone;
+		mLogStrings.append(QObject::tr("Cloning: %1 -> %2").arg(mFilePathIn).arg(mFilePathOut));
+		return true;
+	}
+
 	if (!file.copy(mFilePathOut)) {
 		mLogStrings.append(QObject::tr("Error: could not copy file"));
 		mLogStrings.append(QObject::tr("Input: %1").arg(mFilePathIn));
@@ -496,6 +696,38 @@ bool DkBatchProcess::copyFile() {
 	return true;
 }
 
+/**
+ * Creates a copy-on-write clone (reflink) of a file.
+ * The clone shares the data blocks with the original until either of them
+ * is changed, so no data is copied. This is supported by e.g. btrfs and XFS.
+ * Hard links are not used since changing the copy would change the original.
+ * @param filePathIn the file to be cloned
+ * @param filePathOut the clone's file path (must not exist)
+ * @return bool false if cloning is not supported
+ **/ 
+bool DkBatchProcess::cloneFile(const QString& filePathIn, const QString& filePathOut) {
+
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+	QFile inFile(filePathIn);
+	QFile outFile(filePathOut);
+
+	if (!inFile.open(QIODevice::ReadOnly) || !outFile.open(QIODevice::WriteOnly))
+		return false;
+
+	bool cloned = ioctl(outFile.handle(), FICLONE, inFile.handle()) == 0;
+	outFile.close();
+
+	if (!cloned)
+		outFile.remove();
+
+	return cloned;
+#else
+	Q_UNUSED(filePathIn);
+	Q_UNUSED(filePathOut);
+	return false;
+#endif
+}
+
 bool DkBatchProcess::prepareDeleteExisting() {
 
 	if (QFileInfo(mFilePathOut).exists() && mMode == DkBatchConfig::mode_overwrite) {
@@ -619,7 +851,7 @@ DkBatchProcessing::DkBatchProcessing(const DkBatchConfig& config, QWidget* paren
 	this->batchConfig = config;
 
 	connect(&batchWatcher, SIGNAL(progressValueChanged(int)), this, SIGNAL(progressValueChanged(int)));
-	connect(&batchWatcher, SIGNAL(finished()), this, SIGNAL(finished()));
+	connect(&batchWatcher, SIGNAL(finished()), this, SLOT(batchFinished()));
 }
 
 void DkBatchProcessing::init() {
@@ -655,10 +887,17 @@ void DkBatchProcessing::compute() {
 	if (batchWatcher.isRunning())
 		batchWatcher.waitForFinished();
 
+	batchTimer.start();
 	QFuture<void> future = QtConcurrent::map(batchItems, &nmc::DkBatchProcessing::computeItem);
 	batchWatcher.setFuture(future);
 }
 
+void DkBatchProcessing::batchFinished() {
+
+	batchDuration = batchTimer.elapsed();
+	emit finished();
+}
+
 bool DkBatchProcessing::computeItem(DkBatchProcess& item) {
 
 	return item.compute();
@@ -667,13 +906,29 @@ bool DkBatchProcessing::computeItem(DkBatchProcess& item) {
 QStringList DkBatchProcessing::getLog() const {
 
 	QStringList log;
+	QVector<int> numPaths(DkBatchProcess::path_end, 0);
 
 	for (DkBatchProcess batch : batchItems) {
 
 		log << batch.getLog();
 		log << "";	// add empty line between images
+		numPaths[batch.path()]++;
 	}
 
+	// summarize how the files were processed
+	int numProcessed = getNumProcessed();
+	double sec = batchDuration / 1000.0;
+	QString summary = QObject::tr("%1 files processed in %2 sec (%3 files/sec)")
+		.arg(numProcessed).arg(sec, 0, 'f', 1).arg(numProcessed / qMax(sec, 0.001), 0, 'f', 1);
+
+	for (int idx = DkBatchProcess::path_move; idx < DkBatchProcess::path_end; idx++) {
+		if (numPaths[idx])
+			summary += QString(" - %1: %2").arg(DkBatchProcess::pathName(idx)).arg(numPaths[idx]);
+	}
+
+	log.prepend("");
+	log.prepend(summary);
+
 	return log;
 }
 
@@ -744,6 +999,8 @@ QString DkBatchProcessing::getBatchSummary(const DkBatchProcess& batch) const {
 	else
 		res += " <span style=\" color:#aa0000;\">" + tr("[FAIL]") + "</span>";
 
+	res += " <span style=\" color:#888888;\">[" + DkBatchProcess::pathName(batch.path()) + "]</span>";
+
 	return res;
 }
 
@@ -34,6 +34,7 @@
 #include <QDir>
 #include <QStringList>
 #include <QUrl>
+#include <QElapsedTimer>
 #pragma warning(pop)		// no warnings from includes - end
 
 #pragma warning(disable: 4251)	// TODO: remove
@@ -55,6 +56,7 @@ namespace nmc {
 
 // nomacs defines
 class DkImageContainer;
+class DkMetaDataT;
 
 class DllLoaderExport DkAbstractBatch {
 
@@ -64,8 +66,10 @@ public:
 	virtual void setProperties(...) {};
 	virtual bool compute(QSharedPointer<DkImageContainer> container, QStringList& logStrings) const;
 	virtual bool compute(QImage&, QStringList&) const { return true; };
+	virtual bool computeMetaData(QSharedPointer<DkMetaDataT>, QStringList&) const { return false; };
 	virtual QString name() const {return "Abstract Batch";};
 	virtual bool isActive() const { return false; };
+	virtual bool needsPixels() const { return true; };
 
 private:
 	// ok, this is important:
@@ -142,16 +146,21 @@ class DllLoaderExport DkBatchTransform : public DkAbstractBatch {
 public:
 	DkBatchTransform();
 
-	virtual void setProperties(int angle, bool horizontalFlip = false, bool verticalFlip = false);
+	virtual void setProperties(int angle, bool horizontalFlip = false, bool verticalFlip = false, bool exifOnly = false);
 	virtual bool compute(QImage& img, QStringList& logStrings) const;
+	virtual bool computeMetaData(QSharedPointer<DkMetaDataT> metaData, QStringList& logStrings) const;
 	virtual QString name() const;
 	virtual bool isActive() const;
+	virtual bool needsPixels() const;
+
+	bool isRotationOnly() const;
 
 protected:
 
 	int mAngle = 0;
 	bool mHorizontalFlip = false;
 	bool mVerticalFlip = false;
+	bool mExifOnly = false;		// rotate JPGs by changing their EXIF orientation (opt-in)
 };
 
 class DllLoaderExport DkBatchProcess {
@@ -169,14 +178,30 @@ public:
 	bool wasProcessed() const;
 	QString inputFile() const;
 	QString outputFile() const;
+	int path() const;
+	static QString pathName(int path);
+
+	enum {
+		path_none,		// not processed
+		path_move,		// renamed
+		path_clone,		// copy-on-write copy
+		path_copy,
+		path_metadata,	// copied & the metadata rewritten
+		path_decode,	// decoded, processed & encoded
+
+		path_end
+	};
 
 protected:
+	int classify() const;
 	bool process();
+	bool copyWithMetaData();
 	bool prepareDeleteExisting();
 	bool deleteOrRestoreExisting();
 	bool deleteOriginalFile();
 	bool copyFile();
 	bool renameFile();
+	static bool cloneFile(const QString& filePathIn, const QString& filePathOut);
 
 	QString mFilePathIn;
 	QString mFilePathOut;
@@ -186,6 +211,7 @@ protected:
 	int mCompression = -1;
 	int mFailure = 0;
 	bool mIsProcessed = false;
+	int mPath = path_none;
 
 	QVector<QSharedPointer<DkAbstractBatch> > mProcessFunctions;
 	QStringList mLogStrings;
@@ -278,6 +304,9 @@ signals:
 	void progressValueChanged(int idx);
 	void finished();
 
+protected slots:
+	void batchFinished();
+
 protected:
 	DkBatchConfig batchConfig;
 	QVector<DkBatchProcess> batchItems;
@@ -285,6 +314,8 @@ protected:
 	
 	// threading
 	QFutureWatcher<void> batchWatcher;
+	QElapsedTimer batchTimer;
+	qint64 batchDuration = 0;
 	
 	void init();
 };
@@ -85,6 +85,7 @@ void DkThumbNail::compute(int forceLoad) {
 QImage DkThumbNail::computeIntern(const QString& filePath, const QSharedPointer<QByteArray> ba, 
 								  int forceLoad, int maxThumbSize, int minThumbSize) {
 	
+	DK_TRACE("thumbs", "computeThumb");
 	DkTimer dt;
 	//qDebug() << "[thumb] file: " << file.absoluteFilePath();
 
@@ -97,13 +98,12 @@ QImage DkThumbNail::computeIntern(const QString& filePath, const QSharedPointer<
 	if (QFileInfo(mFile).dir().path().contains(DkZipContainer::zipMarker())) 
 		baZip = DkZipContainer::extractImage(DkZipContainer::decodeZipFile(filePath), DkZipContainer::decodeImageFile(filePath));
 #endif
+	QSharedPointer<QByteArray> exifBa = (baZip && !baZip->isEmpty()) ? baZip : ba;
+
 	try {
-		if (baZip && !baZip->isEmpty())	
-			metaData.readMetaData(filePath, baZip);
-		else if (!ba || ba->isEmpty())
-			metaData.readMetaData(filePath);
-		else
-			metaData.readMetaData(filePath, ba);
+		// we just need the thumbnail & orientation - so probe the exif header if we don't save the thumbnail
+		if (forceLoad == save_thumb || forceLoad == force_save_thumb || !metaData.probeMetaData(filePath, exifBa))
+			metaData.readMetaData(filePath, exifBa);
 
 		// read the full image if we want to create new thumbnails
 		if (forceLoad != force_save_thumb)
@@ -186,6 +186,7 @@ QImage DkThumbNail::computeIntern(const QString& filePath, const QSharedPointer<
 		// try to read the image
 		if (thumb.isNull()) {
 			DkBasicLoader loader;
+			loader.setTargetSize(QSize(maxThumbSize, maxThumbSize));	// decode a preview if possible
 			
 			if (baZip && !baZip->isEmpty())	{
 				if (loader.loadGeneral(lFilePath, baZip, true, true))
@@ -337,6 +338,179 @@ void DkThumbNail::setImage(const QImage img) {
 	mImg = DkImage::createThumb(img);
 }
 
+// DkThumbPool --------------------------------------------------------------------
+DkThumbPool::DkThumbPool() {
+
+	mClock.start();
+}
+
+DkThumbPool& DkThumbPool::instance() {
+
+	static DkThumbPool inst;
+	return inst;
+}
+
+/**
+ * Adds a loaded thumbnail to the pool.
+ * If the thumbnail is already known, its size is updated.
+ * Older thumbnails are evicted if the budget is exceeded.
+ * @param thumb the thumbnail
+ **/ 
+void DkThumbPool::insert(DkThumbNailT* thumb) {
+
+	if (!thumb)
+		return;
+
+	remove(thumb);
+
+	QImage img = thumb->DkThumbNail::getImage();
+
+	if (img.isNull())
+		return;
+
+	Entry e;
+	e.it = mLru.insert(mLru.end(), thumb);
+	e.bytes = img.byteCount();
+	e.lastUsed = mClock.elapsed();
+
+	mEntries.insert(thumb, e);
+	mUsedBytes += e.bytes;
+
+	shrink();
+
+	DK_TRACE_COUNTER("thumb pool bytes", mUsedBytes);
+	DK_TRACE_COUNTER("thumb pool evictions", mEvictions);
+}
+
+/**
+ * Marks the thumbnail as recently used.
+ * @param thumb the thumbnail
+ **/ 
+void DkThumbPool::touch(const DkThumbNailT* thumb) {
+
+	QHash<const DkThumbNailT*, Entry>::iterator eIt = mEntries.find(thumb);
+
+	if (eIt == mEntries.end())
+		return;
+
+	mHits++;
+	eIt->lastUsed = mClock.elapsed();
+
+	// move to the back
+	DkThumbNailT* t = *eIt->it;
+	mLru.erase(eIt->it);
+	eIt->it = mLru.insert(mLru.end(), t);
+}
+
+void DkThumbPool::remove(const DkThumbNailT* thumb) {
+
+	QHash<const DkThumbNailT*, Entry>::iterator eIt = mEntries.find(thumb);
+
+	if (eIt == mEntries.end())
+		return;
+
+	mUsedBytes -= eIt->bytes;
+	mLru.erase(eIt->it);
+	mEntries.erase(eIt);
+}
+
+/**
+ * Evicts thumbnails until the pool fits into its budget.
+ * Thumbnails that were drawn recently (visible_ms) are probably 
+ * visible - so we first evict all others.
+ **/ 
+void DkThumbPool::shrink() {
+
+	qint64 maxBytes = budget();
+
+	if (maxBytes <= 0 || mUsedBytes <= maxBytes)
+		return;
+
+	qint64 now = mClock.elapsed();
+
+	// first pass: keep the thumbs that are (probably) visible
+	QLinkedList<DkThumbNailT*>::iterator lIt = mLru.begin();
+	while (lIt != mLru.end() && mUsedBytes > maxBytes) {
+
+		DkThumbNailT* t = *lIt;
+		++lIt;
+
+		if (now - mEntries.value(t).lastUsed > visible_ms)
+			evict(t);
+	}
+
+	// second pass: the visible thumbs do not even fit into the budget (keep the newest)
+	while (mLru.size() > 1 && mUsedBytes > maxBytes)
+		evict(mLru.first());
+}
+
+void DkThumbPool::evict(DkThumbNailT* thumb) {
+
+	remove(thumb);
+	thumb->releaseImage();
+	mEvictions++;
+}
+
+void DkThumbPool::addMiss(bool evicted) {
+
+	mMisses++;
+
+	if (evicted)
+		mReloads++;
+
+	DK_TRACE_COUNTER("thumb pool misses", mMisses);
+}
+
+qint64 DkThumbPool::usedBytes() const {
+
+	return mUsedBytes;
+}
+
+qint64 DkThumbPool::budget() const {
+
+	return qRound64(Settings::param().resources().thumbMemory*1024.0*1024.0);
+}
+
+int DkThumbPool::hits() const {
+
+	return mHits;
+}
+
+int DkThumbPool::misses() const {
+
+	return mMisses;
+}
+
+int DkThumbPool::evictions() const {
+
+	return mEvictions;
+}
+
+QString DkThumbPool::report() const {
+
+	return QString("[DkThumbPool] %1 thumbs, %2/%3 MB, hits: %4 misses: %5 (reloads: %6) evictions: %7")
+		.arg(mEntries.size())
+		.arg(mUsedBytes/(1024.0*1024.0), 0, 'f', 1)
+		.arg(budget()/(1024.0*1024.0), 0, 'f', 1)
+		.arg(mHits)
+		.arg(mMisses)
+		.arg(mReloads)
+		.arg(mEvictions);
+}
+
+/**
+ * Converts opaque thumbnails to RGB888 which saves a fourth of the memory.
+ * @param img the thumbnail
+ * @return QImage the compact thumbnail
+ **/ 
+QImage DkThumbPool::compact(const QImage& img) {
+
+	if (img.isNull() || img.hasAlphaChannel() || img.depth() <= 24)
+		return img;
+
+	return img.convertToFormat(QImage::Format_RGB888);
+}
+
 /**
  * This class provides threaded access to image thumbnails.
  * @param file the thumbnail's file
@@ -357,18 +531,25 @@ DkThumbNailT::~DkThumbNailT() {
 	if (mFetching && Settings::param().resources().numThumbsLoading > 0)
 		Settings::param().resources().numThumbsLoading--;
 
+	DkThumbPool::instance().remove(this);
+
 	thumbWatcher.blockSignals(true);
 	thumbWatcher.cancel();
 }
 
 bool DkThumbNailT::fetchThumb(int forceLoad /* = false */,  QSharedPointer<QByteArray> ba) {
 
-	if (forceLoad == force_full_thumb || forceLoad == force_save_thumb || forceLoad == save_thumb)
+	if (forceLoad == force_full_thumb || forceLoad == force_save_thumb || forceLoad == save_thumb) {
 		mImg = QImage();
+		DkThumbPool::instance().remove(this);
+	}
 
 	if (!mImg.isNull() || !mImgExists || mFetching)
 		return false;
 
+	DkThumbPool::instance().addMiss(mEvicted);
+	mEvicted = false;
+
 	// we have to do our own bool here
 	// watcher.isRunning() returns false if the thread is waiting in the pool
 	mFetching = true;
@@ -379,6 +560,7 @@ bool DkThumbNailT::fetchThumb(int forceLoad /* = false */,  QSharedPointer<QByte
 		&nmc::DkThumbNailT::computeCall, mFile, ba, forceLoad, mMaxThumbSize, mMinThumbSize));
 
 	Settings::param().resources().numThumbsLoading++;
+	DK_TRACE_COUNTER("thumbs loading", Settings::param().resources().numThumbsLoading);
 
 	return true;
 }
@@ -389,16 +571,27 @@ QImage DkThumbNailT::computeCall(const QString& filePath, QSharedPointer<QByteAr
 	return DkThumbNail::computeIntern(filePath, ba, forceLoad, maxThumbSize, minThumbSize);
 }
 
+/**
+ * Releases the thumbnail's image (called by DkThumbPool).
+ * The thumbnail is reloaded if fetchThumb is called again.
+ **/ 
+void DkThumbNailT::releaseImage() {
+
+	mImg = QImage();
+	mEvicted = true;
+}
+
 void DkThumbNailT::thumbLoaded() {
 	
 	QFuture<QImage> future = thumbWatcher.future();
 
-	mImg = future.result();
+	mImg = DkThumbPool::compact(future.result());
 	
 	if (mImg.isNull() && mForceLoad != force_exif_thumb)
 		mImgExists = false;
 
 	mFetching = false;
+	DkThumbPool::instance().insert(this);
 	Settings::param().resources().numThumbsLoading--;
 	emit thumbLoadedSignal(!mImg.isNull());
 }
@@ -34,6 +34,9 @@
 #include <QDir>
 #include <QThread>
 #include <QImage>
+#include <QHash>
+#include <QLinkedList>
+#include <QElapsedTimer>
 #pragma warning(pop)		// no warnings from includes - end
 
 #pragma warning(disable: 4251)	// TODO: remove
@@ -167,6 +170,65 @@ protected:
 	int mMinThumbSize;
 };
 
+class DkThumbNailT;
+
+/**
+ * Keeps the memory of all loaded thumbnails below a budget.
+ * Thumbnails are added when they are loaded and touched whenever
+ * they are drawn. If the budget (Resources::thumbMemory) is exceeded,
+ * the least recently used thumbnails release their images. 
+ * They are transparently reloaded (thumbLoadedSignal) if requested again.
+ * Note: the pool must only be used from the GUI thread.
+ **/ 
+class DllLoaderExport DkThumbPool {
+
+public:
+	static DkThumbPool& instance();
+
+	void insert(DkThumbNailT* thumb);
+	void touch(const DkThumbNailT* thumb);
+	void remove(const DkThumbNailT* thumb);
+	void shrink();
+
+	qint64 usedBytes() const;
+	qint64 budget() const;
+	int hits() const;
+	int misses() const;
+	int evictions() const;
+	QString report() const;
+
+	void addMiss(bool evicted);
+
+	static QImage compact(const QImage& img);
+
+	enum {
+		visible_ms = 1000,	// thumbs drawn within this period are evicted last
+	};
+
+protected:
+	DkThumbPool();
+	DkThumbPool(DkThumbPool const&);		// hide
+	void operator=(DkThumbPool const&);		// hide
+
+	void evict(DkThumbNailT* thumb);
+
+	struct Entry {
+		QLinkedList<DkThumbNailT*>::iterator it;
+		qint64 bytes;
+		qint64 lastUsed;
+	};
+
+	QLinkedList<DkThumbNailT*> mLru;	// front: least recently used
+	QHash<const DkThumbNailT*, Entry> mEntries;
+	QElapsedTimer mClock;
+
+	qint64 mUsedBytes = 0;
+	int mHits = 0;
+	int mMisses = 0;
+	int mReloads = 0;
+	int mEvictions = 0;
+};
+
 class DllLoaderExport DkThumbNailT : public QObject, public DkThumbNail {
 	Q_OBJECT
 
@@ -175,6 +237,19 @@ public:
 	~DkThumbNailT();
 
 	bool fetchThumb(int forceLoad = do_not_force, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
+	void releaseImage();
+
+	/**
+	 * Returns the thumbnail and marks it as recently used.
+	 * @return QImage the thumbnail.
+	 **/ 
+	QImage getImage() const {
+
+		if (!mImg.isNull())
+			DkThumbPool::instance().touch(this);
+
+		return mImg;
+	};
 
 	/**
 	 * Returns whether the thumbnail was loaded, or does not exist.
@@ -190,6 +265,7 @@ public:
 
 	void setImage(const QImage img) {
 		DkThumbNail::setImage(img);
+		DkThumbPool::instance().insert(this);
 		emit thumbLoadedSignal(true);
 	};
 
@@ -204,6 +280,7 @@ protected:
 
 	QFutureWatcher<QImage> thumbWatcher;
 	bool mFetching;
+	bool mEvicted = false;
 	int mForceLoad;
 };
 
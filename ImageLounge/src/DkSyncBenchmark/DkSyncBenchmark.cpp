@@ -0,0 +1,203 @@
+/*******************************************************************************************************
+ DkSyncBenchmark.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkSyncBenchmark.h"
+#include "DkConnection.h"
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QTimer>
+#include <QHostAddress>
+#include <QDebug>
+#pragma warning(pop)		// no warnings from includes - end
+
+namespace nmc {
+
+// DkLoopbackBenchmark --------------------------------------------------------------------
+DkLoopbackBenchmark::DkLoopbackBenchmark(QObject* parent) : QObject(parent) {
+
+	mServer = new DkLoopbackServer(this);
+	mClock.start();
+}
+
+DkLoopbackBenchmark::~DkLoopbackBenchmark() {
+
+	delete mClient;
+	delete mPeer;
+}
+
+void DkLoopbackBenchmark::DkLoopbackServer::incomingConnection(qintptr socketDescriptor) {
+
+	mBenchmark->createPeer(socketDescriptor);
+}
+
+void DkLoopbackBenchmark::createPeer(qintptr socketDescriptor) {
+
+	if (mPeer)
+		return;
+
+	mPeer = new DkLocalConnection();
+	mPeer->setSocketDescriptor(socketDescriptor);
+	mPeer->setLocalTcpServerPort(mServer->serverPort());
+
+	connect(mPeer, SIGNAL(connectionReadyForUse(quint16, const QString&, DkConnection*)), this, SLOT(peerReady(quint16, const QString&, DkConnection*)));
+	connect(mPeer, SIGNAL(connectionTitleHasChanged(DkConnection*, const QString&)), this, SLOT(serverTitleReceived(DkConnection*, const QString&)));
+}
+
+/**
+ * Connects two local peers (greeting messages are exchanged).
+ * @return bool true if both peers are ready for use
+ **/
+bool DkLoopbackBenchmark::init() {
+
+	if (!mServer->listen(QHostAddress::LocalHost)) {
+		qWarning() << "[DkLoopbackBenchmark] cannot listen:" << mServer->errorString();
+		return false;
+	}
+
+	mClient = new DkLocalConnection();
+	mClient->setLocalTcpServerPort(0);
+
+	connect(mClient, SIGNAL(connectionReadyForUse(quint16, const QString&, DkConnection*)), this, SLOT(peerReady(quint16, const QString&, DkConnection*)));
+	connect(mClient, SIGNAL(connectionTitleHasChanged(DkConnection*, const QString&)), this, SLOT(clientTitleReceived(DkConnection*, const QString&)));
+
+	mClient->connectToHost(QHostAddress::LocalHost, mServer->serverPort());
+
+	if (!mClient->waitForConnected(timeout_ms)) {
+		qWarning() << "[DkLoopbackBenchmark] cannot connect:" << mClient->errorString();
+		return false;
+	}
+
+	mClient->sendGreetingMessage("client");
+
+	return wait() && mNumReady == 2;
+}
+
+bool DkLoopbackBenchmark::isBinary() const {
+
+	return mClient && mClient->isBinaryProtocol();
+}
+
+/**
+ * Sends numMessages title messages from the client to the peer.
+ * @param numMessages the number of messages
+ * @return double the time (ms) until the last message was processed by the peer
+ **/
+double DkLoopbackBenchmark::sendMessages(int numMessages) {
+
+	mEcho = false;
+	mNumExpected = numMessages;
+	mNumReceived = 0;
+
+	qint64 start = mClock.nsecsElapsed();
+
+	for (int idx = 0; idx < numMessages; idx++)
+		mClient->sendNewTitleMessage(QString("title %1").arg(idx));
+
+	if (!wait())
+		return -1.0;
+
+	return (mClock.nsecsElapsed() - start) / 1e6;
+}
+
+/**
+ * Sends numMessages messages which are echoed by the peer.
+ * A message is only sent after the previous echo was received.
+ * @param numMessages the number of round trips
+ * @return QVector<double> the round trip times in ms
+ **/
+QVector<double> DkLoopbackBenchmark::roundTrips(int numMessages) {
+
+	mEcho = true;
+	mNumExpected = numMessages;
+	mNumReceived = 0;
+	mRoundTrips.clear();
+
+	mSentAt = mClock.nsecsElapsed();
+	mClient->sendNewTitleMessage("ping 0");
+
+	if (!wait())
+		mRoundTrips.clear();
+
+	return mRoundTrips;
+}
+
+void DkLoopbackBenchmark::peerReady(quint16, const QString&, DkConnection*) {
+
+	mNumReady++;
+
+	if (mNumReady == 2)
+		mLoop.quit();
+}
+
+void DkLoopbackBenchmark::serverTitleReceived(DkConnection* connection, const QString& title) {
+
+	if (mEcho) {
+		connection->sendNewTitleMessage(title);
+		return;
+	}
+
+	mNumReceived++;
+
+	if (mNumReceived == mNumExpected)
+		mLoop.quit();
+}
+
+void DkLoopbackBenchmark::clientTitleReceived(DkConnection* connection, const QString&) {
+
+	if (!mEcho)
+		return;
+
+	mRoundTrips << (mClock.nsecsElapsed() - mSentAt) / 1e6;
+	mNumReceived++;
+
+	if (mNumReceived == mNumExpected) {
+		mLoop.quit();
+		return;
+	}
+
+	mSentAt = mClock.nsecsElapsed();
+	connection->sendNewTitleMessage(QString("ping %1").arg(mNumReceived));
+}
+
+bool DkLoopbackBenchmark::wait() {
+
+	QTimer timer;
+	timer.setSingleShot(true);
+	connect(&timer, SIGNAL(timeout()), &mLoop, SLOT(quit()));
+	timer.start(timeout_ms);
+
+	mLoop.exec();
+
+	if (!timer.isActive()) {
+		qWarning() << "[DkLoopbackBenchmark] timeout";
+		return false;
+	}
+
+	return true;
+}
+
+}
@@ -0,0 +1,100 @@
+/*******************************************************************************************************
+ DkSyncBenchmark.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QObject>
+#include <QVector>
+#include <QTcpServer>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#pragma warning(pop)		// no warnings from includes - end
+
+namespace nmc {
+
+class DkConnection;
+class DkLocalConnection;
+
+/**
+ * Measures the messages/s and round trip times of two
+ * DkLocalConnections which are connected via the loopback device.
+ **/
+class DkLoopbackBenchmark : public QObject {
+	Q_OBJECT
+
+public:
+	DkLoopbackBenchmark(QObject* parent = 0);
+	~DkLoopbackBenchmark();
+
+	bool init();
+	bool isBinary() const;
+	double sendMessages(int numMessages);
+	QVector<double> roundTrips(int numMessages);
+
+	enum {
+		timeout_ms = 30000,
+	};
+
+protected slots:
+	void peerReady(quint16 peerServerPort, const QString& title, DkConnection* connection);
+	void serverTitleReceived(DkConnection* connection, const QString& title);
+	void clientTitleReceived(DkConnection* connection, const QString& title);
+
+protected:
+	/**
+	 * Accepts the loopback connection as DkLocalConnection.
+	 **/
+	class DkLoopbackServer : public QTcpServer {
+
+	public:
+		DkLoopbackServer(DkLoopbackBenchmark* benchmark) : QTcpServer(benchmark), mBenchmark(benchmark) {};
+
+	protected:
+		void incomingConnection(qintptr socketDescriptor) override;
+
+		DkLoopbackBenchmark* mBenchmark;
+	};
+
+	bool wait();
+	void createPeer(qintptr socketDescriptor);
+
+	DkLoopbackServer* mServer = 0;
+	DkLocalConnection* mClient = 0;
+	DkLocalConnection* mPeer = 0;
+	QEventLoop mLoop;
+	QElapsedTimer mClock;
+
+	int mNumReady = 0;
+	int mNumExpected = 0;
+	int mNumReceived = 0;
+	bool mEcho = false;
+	qint64 mSentAt = 0;			// ns
+	QVector<double> mRoundTrips;	// ms
+};
+
+};
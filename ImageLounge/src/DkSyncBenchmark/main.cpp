@@ -0,0 +1,147 @@
+/*******************************************************************************************************
+ main.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma warning(push, 0)	// no warnings from includes - begin
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDebug>
+#pragma warning(pop)		// no warnings from includes - end
+
+#include "DkSyncBenchmark.h"
+
+#include <algorithm>
+#include <iostream>
+
+// measures the synchronization protocol (e.g. nomacsSyncBenchmark -platform offscreen -o sync.json)
+int main(int argc, char *argv[]) {
+
+	// use separate settings - we do not want to touch the user's nomacs settings
+	QCoreApplication::setOrganizationName("nomacs");
+	QCoreApplication::setApplicationName("Image Lounge Benchmark");
+
+	QApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("nomacs synchronization benchmark (two DkLocalConnections via loopback)");
+	parser.addHelpOption();
+
+	QCommandLineOption outputOpt(QStringList() << "o" << "output",
+		QObject::tr("Write the results (JSON) to <file> instead of stdout."),
+		QObject::tr("file"));
+	parser.addOption(outputOpt);
+
+	QCommandLineOption runsOpt(QStringList() << "r" << "runs",
+		QObject::tr("Number of timed <runs>."),
+		QObject::tr("runs"),
+		"5");
+	parser.addOption(runsOpt);
+
+	QCommandLineOption quickOpt(QStringList() << "q" << "quick",
+		QObject::tr("Send fewer messages (smoke test)."));
+	parser.addOption(quickOpt);
+
+	parser.process(a);
+
+	nmc::DkLoopbackBenchmark loopback;
+
+	if (!loopback.init()) {
+		qWarning() << "[DkSyncBenchmark] cannot connect the loopback peers";
+		return 1;
+	}
+
+	int numRuns = qMax(parser.value(runsOpt).toInt(), 1);
+	int numMessages = parser.isSet(quickOpt) ? 2000 : 20000;
+	int numRoundTrips = parser.isSet(quickOpt) ? 200 : 2000;
+
+	// warm-up
+	loopback.sendMessages(numMessages);
+
+	QVector<double> runs;
+	for (int idx = 0; idx < numRuns; idx++) {
+
+		double ms = loopback.sendMessages(numMessages);
+
+		if (ms < 0)
+			return 1;
+		runs << ms;
+	}
+
+	QVector<double> rtts;
+	for (int idx = 0; idx < numRuns; idx++)
+		rtts += loopback.roundTrips(numRoundTrips);
+
+	if (rtts.isEmpty())
+		return 1;
+
+	std::sort(runs.begin(), runs.end());
+	std::sort(rtts.begin(), rtts.end());
+	double median = runs[runs.size()/2];
+
+	QJsonArray runsJson;
+	for (double r : runs)
+		runsJson.append(r);
+
+	QJsonObject o;
+	o["benchmark"] = QString("nomacs sync");
+	o["version"] = QString(NOMACS_VERSION);
+	o["qt"] = QString(qVersion());
+	o["protocol"] = loopback.isBinary() ? QString("binary") : QString("text");
+	o["messages"] = numMessages;
+	o["runs_ms"] = runsJson;
+	o["messages_per_s"] = numMessages / median * 1000.0;
+	o["round_trips"] = rtts.size();
+	o["latency_p50_ms"] = rtts[rtts.size()/2];
+	o["latency_p90_ms"] = rtts[rtts.size()*9/10];
+	o["latency_p99_ms"] = rtts[rtts.size()*99/100];
+	o["latency_max_ms"] = rtts.last();
+
+	std::cerr << qPrintable(QString("sync (%1): %2 messages/s, latency p50: %3 ms p99: %4 ms")
+		.arg(o["protocol"].toString())
+		.arg(o["messages_per_s"].toDouble(), 0, 'f', 0)
+		.arg(o["latency_p50_ms"].toDouble(), 0, 'f', 3)
+		.arg(o["latency_p99_ms"].toDouble(), 0, 'f', 3)) << std::endl;
+
+	QByteArray json = QJsonDocument(o).toJson(QJsonDocument::Indented);
+
+	if (!parser.isSet(outputOpt)) {
+		std::cout << json.constData() << std::endl;
+		return 0;
+	}
+
+	QFile file(parser.value(outputOpt));
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "[DkSyncBenchmark] cannot write" << file.fileName();
+		return 1;
+	}
+
+	return file.write(json) == json.size() ? 0 : 1;
+}
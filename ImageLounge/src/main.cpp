@@ -56,6 +56,7 @@
 
 #include "DkNoMacs.h"
 #include "DkCentralWidget.h"
+#include "DkNetwork.h"
 #include "DkSettings.h"
 #include "DkTimer.h"
 #include "DkPong.h"
@@ -132,13 +133,46 @@ int main(int argc, char *argv[]) {
 		QObject::tr("images"));
 	parser.addOption(tabOpt);
 
+	QCommandLineOption newInstanceOpt(QStringList() << "n" << "new-instance", QObject::tr("Do not hand the images to a running nomacs."));
+	parser.addOption(newInstanceOpt);
+
+	QCommandLineOption traceOpt(QStringList() << "trace",
+		QObject::tr("Write a Chrome trace (chrome://tracing, Perfetto) to <file>."),
+		QObject::tr("file"));
+	parser.addOption(traceOpt);
+
 	parser.process(a);
+
+	if (parser.isSet(traceOpt))
+		nmc::DkTracer::instance().start(parser.value(traceOpt));
 	// CMD parser --------------------------------------------------------------------
 
-	nmc::Settings::param().initFileFilters();
+	{
+		DK_TRACE("startup", "settings");
+		nmc::Settings::param().initFileFilters();
+		nmc::Settings::param().load();	// load in constructor??
+	}
+
 	QSettings& settings = nmc::Settings::instance().getSettings();
-	
-	nmc::Settings::param().load();	// load in constructor??
+
+	// single instance mode: hand the images to a running nomacs
+	bool singleInstance = nmc::Settings::param().app().singleInstance &&
+		!parser.isSet(newInstanceOpt) &&
+		!parser.isSet(privateOpt) &&
+		!parser.isSet(modeOpt) &&
+		!parser.isSet(pongOpt);
+
+	if (singleInstance) {
+
+		QStringList filePaths;
+		for (const QString& arg : parser.positionalArguments() + parser.values(tabOpt))
+			filePaths << QFileInfo(arg).absoluteFilePath();
+
+		if (!filePaths.empty() && nmc::DkInstanceServer::sendFiles(filePaths)) {
+			qDebug() << "files sent to the running nomacs: " << filePaths;
+			return 0;
+		}
+	}
 
 	int mode = settings.value("AppSettings/appMode", nmc::Settings::param().app().appMode).toInt();
 	nmc::Settings::param().app().currentAppMode = mode;
@@ -180,6 +214,10 @@ int main(int argc, char *argv[]) {
 
 	qDebug() << "mode: " << mode;
 
+	// show the image first if we are started with a file - the remaining UI is created afterwards
+	bool fastStart = !parser.positionalArguments().empty() && !parser.isSet(pongOpt);
+	nmc::Settings::param().app().fastStart = fastStart;
+
 	nmc::DkTimer dt;
 
 	// initialize nomacs
@@ -199,13 +237,16 @@ int main(int argc, char *argv[]) {
 	else
 		w = static_cast<nmc::DkNoMacs*> (new nmc::DkNoMacsIpl());	// slice it
 
-	if (w)
+	if (w && !fastStart)
 		w->onWindowLoaded();
 
+	if (w && singleInstance)
+		w->startInstanceServer();
+
 	qDebug() << "Initialization takes: " << dt.getTotal();
 
-	if (!parser.positionalArguments().empty()) {
-		w->loadFile(QFileInfo(parser.positionalArguments()[0]).absoluteFilePath());	// update folder + be silent
+	if (fastStart) {
+		w->startWithFile(QFileInfo(parser.positionalArguments()[0]).absoluteFilePath());	// update folder + be silent
 		qDebug() << "loading: " << parser.positionalArguments()[0];
 	}
 	else if (nmc::Settings::param().app().showRecentFiles)
@@ -251,6 +292,11 @@ int main(int argc, char *argv[]) {
 	if (pw)
 		delete pw;
 
+	if (nmc::DkTracer::isEnabled()) {
+		nmc::DkTracer::instance().stop();
+		nmc::DkTracer::instance().save();
+	}
+
 	return rVal;
 }
 